@@ -0,0 +1,1190 @@
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#define BENCH_PERF
+#endif
+
+#include <rvdec/corpus.h>
+#include <rvdec/dataflow.h>
+#include <rvdec/decode.h>
+#include <rvdec/format.h>
+#include <rvdec/instruction.h>
+#include <rvdec/page_cache.h>
+#include <rvdec/stream.h>
+#include <rvdec/trace.h>
+
+#define CORPUS_SIZE (1 << 16)
+#define ITERATIONS 200
+#define BUFFER_BATCH 256
+
+static uint64_t bench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Reference cycles from the time-stamp counter, 0 where there is none
+static uint64_t bench_now_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* Time-stamp counter read after every earlier instruction has completed,
+ * for timing a single call, and the monotonic clock where there is none. */
+static inline uint64_t bench_fenced_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_lfence();
+  uint64_t tsc = __rdtsc();
+  _mm_lfence();
+  return tsc;
+#else
+  return bench_now_ns();
+#endif
+}
+
+/* Hardware counters read around each kernel with --perf. Each event is
+ * opened on its own so that one the CPU or hypervisor doesn't have leaves
+ * the others working, and its count is scaled by the share of the run it
+ * was scheduled for in case the PMU had to multiplex them. */
+
+#define BENCH_PERF_EVENTS 6
+
+static const char *const bench_perf_names[BENCH_PERF_EVENTS] = {
+  "cycles", "instructions", "branch_misses",
+  "l1i_misses", "l1d_misses", "itlb_misses",
+};
+
+// Counter of each event, -1 if it isn't counted
+static int bench_perf_fds[BENCH_PERF_EVENTS] = { -1, -1, -1, -1, -1, -1 };
+
+#ifdef BENCH_PERF
+
+#define BENCH_CACHE_MISSES(cache) (PERF_COUNT_HW_CACHE_##cache \
+    | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+
+static const struct {
+  uint32_t type;
+  uint64_t config;
+} bench_perf_events[BENCH_PERF_EVENTS] = {
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { PERF_TYPE_HW_CACHE, BENCH_CACHE_MISSES(L1I) },
+  { PERF_TYPE_HW_CACHE, BENCH_CACHE_MISSES(L1D) },
+  { PERF_TYPE_HW_CACHE, BENCH_CACHE_MISSES(ITLB) },
+};
+
+#endif // BENCH_PERF
+
+/* Opens the counters of the calling process and the threads it starts,
+ * user space only so that the default perf_event_paranoid allows it. Says
+ * on stderr which events can't be counted, returns how many can. */
+static int bench_perf_open(void) {
+  int opened = 0;
+  int error = ENOSYS;
+#ifdef BENCH_PERF
+  for (int i = 0; i < BENCH_PERF_EVENTS; ++i) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = bench_perf_events[i].type;
+    attr.config = bench_perf_events[i].config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+      | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    bench_perf_fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (bench_perf_fds[i] >= 0) {
+      ++opened;
+    } else {
+      error = errno;
+    }
+  }
+#endif // BENCH_PERF
+  if (opened == 0) {
+    fprintf(stderr, "perf events unavailable (%s), reporting time only\n",
+        strerror(error));
+  } else if (opened < BENCH_PERF_EVENTS) {
+    fprintf(stderr, "perf events unavailable:");
+    for (int i = 0; i < BENCH_PERF_EVENTS; ++i) {
+      if (bench_perf_fds[i] < 0) {
+        fprintf(stderr, " %s", bench_perf_names[i]);
+      }
+    }
+    fprintf(stderr, "\n");
+  }
+  return opened;
+}
+
+static void bench_perf_enable(void) {
+#ifdef BENCH_PERF
+  for (int i = 0; i < BENCH_PERF_EVENTS; ++i) {
+    if (bench_perf_fds[i] >= 0) {
+      ioctl(bench_perf_fds[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(bench_perf_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#endif // BENCH_PERF
+}
+
+// Stops the counters and stores their counts to `counts`, -1 if not counted
+static void bench_perf_disable(double *counts) {
+  for (int i = 0; i < BENCH_PERF_EVENTS; ++i) {
+    counts[i] = -1;
+#ifdef BENCH_PERF
+    // Count, then the time the event was enabled and the time it counted
+    uint64_t values[3];
+    if (bench_perf_fds[i] >= 0
+        && ioctl(bench_perf_fds[i], PERF_EVENT_IOC_DISABLE, 0) == 0
+        && read(bench_perf_fds[i], values, sizeof(values)) == sizeof(values)
+        && values[2] != 0) {
+      counts[i] = (double)values[0] * values[1] / values[2];
+    }
+#endif // BENCH_PERF
+  }
+}
+
+struct bench_timer {
+  uint64_t ns;
+  uint64_t cycles;
+  // Event counts of bench_perf_names, -1 for those not counted
+  double perf[BENCH_PERF_EVENTS];
+};
+
+static struct bench_timer bench_start(void) {
+  struct bench_timer timer;
+  bench_perf_enable();
+  timer.ns = bench_now_ns();
+  timer.cycles = bench_now_cycles();
+  return timer;
+}
+
+static void bench_stop(struct bench_timer *timer) {
+  timer->cycles = bench_now_cycles() - timer->cycles;
+  timer->ns = bench_now_ns() - timer->ns;
+  bench_perf_disable(timer->perf);
+}
+
+static uint32_t bench_rand_state = 0x12345678;
+
+static uint32_t bench_rand(void) {
+  // xorshift32, deterministic across runs
+  bench_rand_state ^= bench_rand_state << 13;
+  bench_rand_state ^= bench_rand_state >> 17;
+  bench_rand_state ^= bench_rand_state << 5;
+  return bench_rand_state;
+}
+
+/* Encodings of a mixed RV64IM stream as (opcode, funct3, funct7) triples,
+ * funct7 of -1 leaves the upper bits to be filled with a random immediate. */
+static const int32_t rv64im_mix[][3] = {
+  { 0b0110011, 0b000, 0b0000000 }, // add
+  { 0b0110011, 0b000, 0b0100000 }, // sub
+  { 0b0110011, 0b111, 0b0000000 }, // and
+  { 0b0110011, 0b000, 0b0000001 }, // mul
+  { 0b0110011, 0b100, 0b0000001 }, // div
+  { 0b0111011, 0b000, 0b0000000 }, // addw
+  { 0b0111011, 0b000, 0b0000001 }, // mulw
+  { 0b0010011, 0b000, -1 },        // addi
+  { 0b0010011, 0b001, 0b0000000 }, // slli
+  { 0b0011011, 0b000, -1 },        // addiw
+  { 0b0000011, 0b011, -1 },        // ld
+  { 0b0000011, 0b010, -1 },        // lw
+  { 0b0100011, 0b011, -1 },        // sd
+  { 0b1100011, 0b001, -1 },        // bne
+  { 0b1101111, 0b000, -1 },        // jal
+  { 0b0110111, 0b000, -1 },        // lui
+};
+
+static void bench_fill_rv64im(uint32_t *corpus, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    const int32_t *enc = rv64im_mix[bench_rand() % (sizeof(rv64im_mix) / sizeof(*rv64im_mix))];
+    uint32_t repr = bench_rand() & 0x01fff000;
+    repr = (repr & ~(0b111 << 12)) | (enc[1] << 12) | enc[0];
+    repr |= (bench_rand() & 0b11111) << 7;
+    if (enc[2] >= 0) {
+      repr |= (uint32_t)enc[2] << 25;
+    } else {
+      repr |= bench_rand() & 0xfe000000;
+    }
+    corpus[i] = repr;
+  }
+}
+
+// Uniformly random 32-bit words, compressed and illegal ones included
+static void bench_fill_random(uint32_t *corpus, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    corpus[i] = bench_rand();
+  }
+}
+
+// 32-bit words that riscv_decode() rejects, the worst case for fallbacks
+static void bench_fill_illegal(uint32_t *corpus, size_t size) {
+  struct riscv_insn insn;
+  for (size_t i = 0; i < size; ++i) {
+    do {
+      corpus[i] = bench_rand() | 0b11;
+    } while (riscv_decode(&insn, corpus[i]) != RVINSN_ILLEGAL);
+  }
+}
+
+/* Kind frequencies of compiled RV64 code, roughly: address arithmetic,
+ * loads and stores first, then branches, calls and the rest. */
+static const uint32_t compiled_mix[][2] = {
+  { RVINSN_ADDI, 220 }, { RVINSN_LD, 140 }, { RVINSN_SD, 100 },
+  { RVINSN_ADD, 50 }, { RVINSN_LW, 45 }, { RVINSN_BNE, 40 },
+  { RVINSN_BEQ, 40 }, { RVINSN_JAL, 45 }, { RVINSN_AUIPC, 35 },
+  { RVINSN_ADDIW, 35 }, { RVINSN_JALR, 25 }, { RVINSN_SW, 30 },
+  { RVINSN_LUI, 20 }, { RVINSN_LBU, 20 }, { RVINSN_SLLI, 20 },
+  { RVINSN_SRLI, 10 }, { RVINSN_ANDI, 15 }, { RVINSN_SUB, 10 },
+  { RVINSN_BLT, 8 }, { RVINSN_BGE, 8 }, { RVINSN_BLTU, 8 },
+  { RVINSN_BGEU, 6 }, { RVINSN_SB, 10 }, { RVINSN_ADDW, 10 },
+  { RVINSN_MUL, 6 }, { RVINSN_MULW, 3 }, { RVINSN_DIVU, 1 },
+  { RVINSN_OR, 5 }, { RVINSN_AND, 5 }, { RVINSN_XOR, 3 },
+};
+
+/* Byte stream from the corpus generator with the kind frequencies above and
+ * as many compressed instructions as RVC-enabled toolchains emit, returns
+ * the number of bytes used. */
+static size_t bench_fill_synthetic(uint8_t *buf, size_t size) {
+  uint32_t weights[RVINSN_ILLEGAL] = { 0 };
+  for (size_t i = 0; i < sizeof(compiled_mix) / sizeof(*compiled_mix); ++i) {
+    weights[compiled_mix[i][0]] = compiled_mix[i][1];
+  }
+  struct riscv_corpus_config config;
+  riscv_corpus_config_init(&config);
+  config.kind_weights = weights;
+  config.rvc_percent = 60;
+  struct riscv_corpus *corpus = riscv_corpus_create(&config);
+  if (!corpus) {
+    return 0;
+  }
+  size_t used = riscv_corpus_fill(corpus, buf, size);
+  riscv_corpus_destroy(corpus);
+  return used;
+}
+
+/* Baseline: the per-set hook chain that `riscv_decode` walked before the
+ * dispatch table. */
+
+typedef int (*hook_fn)(struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
+
+static const hook_fn hook_chain[][6] = {
+  { riscv_decode_rv64i_r, riscv_decode_rv64i_i, riscv_decode_rv64i_s, NULL, NULL, NULL },
+  { riscv_decode_rv32i_r, riscv_decode_rv32i_i, riscv_decode_rv32i_s,
+    riscv_decode_rv32i_b, riscv_decode_rv32i_u, riscv_decode_rv32i_j },
+  { riscv_decode_rv64m_r, NULL, NULL, NULL, NULL, NULL },
+  { riscv_decode_rv32m_r, NULL, NULL, NULL, NULL, NULL },
+};
+
+static int hook_chain_slot(uint32_t opcode) {
+  switch (opcode) {
+    case 0b0110011: case 0b0111011:
+      return 0;
+    case 0b0000011: case 0b0001111: case 0b0010011: case 0b0011011:
+    case 0b1100111: case 0b1110011:
+      return 1;
+    case 0b0100011:
+      return 2;
+    case 0b1100011:
+      return 3;
+    case 0b0010111: case 0b0110111:
+      return 4;
+    case 0b1101111:
+      return 5;
+  }
+  return -1;
+}
+
+static int hook_chain_decode(struct riscv_insn *insn, uint32_t repr) {
+  uint32_t opcode = repr & 0b1111111;
+  int slot = hook_chain_slot(opcode);
+  if (slot >= 0) {
+    for (size_t i = 0; i < sizeof(hook_chain) / sizeof(*hook_chain); ++i) {
+      if (hook_chain[i][slot] && hook_chain[i][slot](insn, repr, opcode)) {
+        return insn->kind;
+      }
+    }
+  }
+  insn->kind = RVINSN_ILLEGAL;
+  return insn->kind;
+}
+
+#ifdef SUPPORT_COMPRESSED
+
+/* Baseline: the RVC hook chain that `rvc_decode` walked before the expanded
+ * tables. */
+
+static const hook_fn hook16_chain[] = {
+  rvc_decode_ci_rv64, rvc_decode_css_rv64, rvc_decode_cl_rv64,
+  rvc_decode_cs_rv64, rvc_decode_ca_rv64, rvc_decode_cj_rv64,
+  rvc_decode_cr_rv32, rvc_decode_ci_rv32, rvc_decode_css_rv32,
+  rvc_decode_ciw_rv32, rvc_decode_cl_rv32, rvc_decode_cs_rv32,
+  rvc_decode_ca_rv32, rvc_decode_cb_rv32, rvc_decode_cj_rv32,
+};
+
+static int hook16_chain_decode(struct riscv_insn *insn, uint32_t repr) {
+  if (repr != 0) {
+    for (size_t i = 0; i < sizeof(hook16_chain) / sizeof(*hook16_chain); ++i) {
+      if (hook16_chain[i](insn, repr, repr & 0b11)) {
+        return insn->kind;
+      }
+    }
+  }
+  return RVINSN_ILLEGAL;
+}
+
+static void bench_fill_rvc(uint32_t *corpus, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    uint32_t repr;
+    do {
+      repr = bench_rand() & 0xffff;
+    } while ((repr & 0b11) == 0b11);
+    corpus[i] = repr;
+  }
+}
+
+#endif // SUPPORT_COMPRESSED
+
+/* Byte stream of 32-bit RV64IM instructions with compressed ones mixed in,
+ * returns the number of bytes used. */
+static size_t bench_fill_mixed(uint8_t *buf, size_t size, int rvc_percent) {
+  size_t offset = 0;
+  while (size - offset >= 4) {
+    uint32_t repr;
+    if ((int)(bench_rand() % 100) < rvc_percent) {
+      do {
+        repr = bench_rand() & 0xffff;
+      } while ((repr & 0b11) == 0b11);
+      buf[offset++] = repr;
+      buf[offset++] = repr >> 8;
+    } else {
+      bench_fill_rv64im(&repr, 1);
+      buf[offset++] = repr;
+      buf[offset++] = repr >> 8;
+      buf[offset++] = repr >> 16;
+      buf[offset++] = repr >> 24;
+    }
+  }
+  return offset;
+}
+
+typedef int (*decode_fn)(struct riscv_insn *insn, uint32_t repr);
+
+// Write results as one JSON document instead of a table, set by --json
+static int bench_json;
+static int bench_results;
+
+static void bench_json_begin(void) {
+  if (bench_json) {
+    printf("{\n  \"benchmark\": \"rvdec_bench\",\n  \"results\": [");
+  }
+}
+
+static void bench_json_end(void) {
+  if (bench_json) {
+    printf("\n  ]\n}\n");
+  }
+}
+
+static void bench_json_entry(const char *name, const char *corpus) {
+  printf("%s\n    { \"name\": \"%s\", \"corpus\": \"%s\", ",
+      bench_results++ ? "," : "", name, corpus);
+}
+
+static void bench_report(const char *name, const char *corpus,
+    const struct bench_timer *timer, uint64_t insns, uint64_t checksum) {
+  double ns = (double)timer->ns / insns;
+  double minsn = insns * 1e3 / timer->ns;
+  double cycles = (double)timer->cycles / insns;
+  if (bench_json) {
+    bench_json_entry(name, corpus);
+    printf("\"insns\": %llu, \"ns_per_insn\": %.3f, \"minsn_per_s\": %.3f, "
+        "\"cycles_per_insn\": %.3f, \"checksum\": %llu",
+        (unsigned long long)insns, ns, minsn, cycles,
+        (unsigned long long)checksum);
+    int counted = 0;
+    for (int i = 0; i < BENCH_PERF_EVENTS; ++i) {
+      if (timer->perf[i] >= 0) {
+        printf("%s\"%s\": %.4f", counted++ ? ", " : ", \"perf_per_insn\": { ",
+            bench_perf_names[i], timer->perf[i] / insns);
+      }
+    }
+    printf("%s }", counted ? " }" : "");
+    return;
+  }
+  printf("%-24s %-12s %8.2f ns/insn %10.2f Minsn/s %7.2f cycles/insn (checksum %llu)\n",
+      name, corpus, ns, minsn, cycles, (unsigned long long)checksum);
+  int counted = 0;
+  for (int i = 0; i < BENCH_PERF_EVENTS; ++i) {
+    if (timer->perf[i] >= 0) {
+      printf("%s %s %.4f", counted++ ? "" : "    per insn:", bench_perf_names[i],
+          timer->perf[i] / insns);
+    }
+  }
+  if (counted) {
+    printf("\n");
+  }
+}
+
+static int bench_compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/* Latency of single calls: each word of the corpus is decoded once between
+ * two fenced counter reads, the cost of the reads alone is subtracted and
+ * the median and 99th percentile of the samples are reported. */
+static void bench_latency(const char *name, const char *corpus_name,
+    decode_fn decode, const uint32_t *corpus, size_t size) {
+  uint64_t *samples = malloc(size * sizeof(*samples));
+  if (!samples) {
+    return;
+  }
+  struct riscv_insn insn;
+  uint64_t checksum = 0;
+
+  for (size_t i = 0; i < size; ++i) {
+    uint64_t start = bench_fenced_cycles();
+    samples[i] = bench_fenced_cycles() - start;
+  }
+  qsort(samples, size, sizeof(*samples), bench_compare_u64);
+  uint64_t overhead = samples[size / 2];
+
+  for (size_t i = 0; i < size; ++i) {
+    uint64_t start = bench_fenced_cycles();
+    checksum += decode(&insn, corpus[i]);
+    uint64_t cycles = bench_fenced_cycles() - start;
+    samples[i] = cycles > overhead ? cycles - overhead : 0;
+  }
+  qsort(samples, size, sizeof(*samples), bench_compare_u64);
+  uint64_t p50 = samples[size / 2];
+  uint64_t p99 = samples[size - 1 - size / 100];
+  free(samples);
+
+  if (bench_json) {
+    bench_json_entry(name, corpus_name);
+    printf("\"samples\": %llu, \"p50_cycles\": %llu, \"p99_cycles\": %llu, "
+        "\"checksum\": %llu }", (unsigned long long)size,
+        (unsigned long long)p50, (unsigned long long)p99,
+        (unsigned long long)checksum);
+    return;
+  }
+  printf("%-24s %-12s %8llu p50 %10llu p99 cycles/call (checksum %llu)\n",
+      name, corpus_name, (unsigned long long)p50, (unsigned long long)p99,
+      (unsigned long long)checksum);
+}
+
+static void bench_decode_fn(const char *name, const char *corpus_name,
+    decode_fn decode, const uint32_t *corpus, size_t size) {
+  struct riscv_insn insn;
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    for (size_t i = 0; i < size; ++i) {
+      checksum += decode(&insn, corpus[i]);
+    }
+  }
+  bench_stop(&timer);
+  bench_report(name, corpus_name, &timer, (uint64_t)size * ITERATIONS, checksum);
+}
+
+static struct riscv_decoder bench_decoder;
+
+static int bench_decoder_decode(struct riscv_insn *insn, uint32_t repr) {
+  return riscv_decoder_decode(&bench_decoder, insn, repr);
+}
+
+#define HOT_WORDS 4096
+#define CACHE_SIZE 8192
+
+/* Simulator-like stream: `size` lookups of HOT_WORDS distinct words. */
+static void bench_fill_hot(uint32_t *corpus, size_t size) {
+  uint32_t hot[HOT_WORDS];
+  bench_fill_rv64im(hot, HOT_WORDS);
+  for (size_t i = 0; i < size; ++i) {
+    corpus[i] = hot[bench_rand() % HOT_WORDS];
+  }
+}
+
+static void bench_decode_cache(const uint32_t *corpus, size_t size) {
+  static struct riscv_decode_cache_entry entries[CACHE_SIZE];
+  struct riscv_decode_cache cache;
+  riscv_decode_cache_init(&cache, entries, CACHE_SIZE, NULL);
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    for (size_t i = 0; i < size; ++i) {
+      checksum += riscv_decode_cache_lookup(&cache, corpus[i])->kind;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_decode_cache", "hot", &timer, (uint64_t)size * ITERATIONS,
+      checksum);
+  if (!bench_json) {
+    printf("  %llu hits, %llu misses\n", (unsigned long long)cache.hits,
+        (unsigned long long)cache.misses);
+  }
+}
+
+static void bench_decode_words(const uint32_t *corpus, size_t size) {
+  static struct riscv_insn insns[BUFFER_BATCH];
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    for (size_t i = 0; i + BUFFER_BATCH <= size; i += BUFFER_BATCH) {
+      riscv_decode_words(corpus + i, BUFFER_BATCH, insns);
+      checksum += insns[i % BUFFER_BATCH].kind;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_decode_words", "rv64im", &timer,
+      (uint64_t)(size / BUFFER_BATCH * BUFFER_BATCH) * ITERATIONS, checksum);
+}
+
+/* Baseline for buffer decoding: one decode call per instruction, with the
+ * caller working out the instruction length. */
+static void bench_walk_per_insn(const uint8_t *buf, size_t size) {
+  struct riscv_insn insn;
+  uint64_t checksum = 0;
+  uint64_t insns = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    size_t offset = 0;
+    while (size - offset >= 4) {
+      uint32_t repr = buf[offset] | (buf[offset + 1] << 8);
+      if ((repr & 0b11) == 0b11) {
+        repr |= (uint32_t)(buf[offset + 2] | (buf[offset + 3] << 8)) << 16;
+        checksum += riscv_decode(&insn, repr);
+        offset += 4;
+      } else {
+#ifdef SUPPORT_COMPRESSED
+        checksum += rvc_decode(&insn, repr);
+#endif
+        offset += 2;
+      }
+      ++insns;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("per_insn_walk", "mixed", &timer, insns, checksum);
+}
+
+static void bench_decode_buffer(const uint8_t *buf, size_t size,
+    const char *corpus) {
+  static struct riscv_insn insns[BUFFER_BATCH];
+  uint64_t checksum = 0;
+  uint64_t total = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    size_t offset = 0;
+    size_t n;
+    while ((n = riscv_decode_buffer(buf + offset, size - offset, offset,
+            insns, BUFFER_BATCH)) != 0) {
+      for (size_t i = 0; i < n; ++i) {
+        checksum += insns[i].kind;
+      }
+      offset = insns[n - 1].pc + insns[n - 1].length;
+      total += n;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_decode_buffer", corpus, &timer, total, checksum);
+}
+
+static void bench_decode_buffer_parallel(const uint8_t *buf, size_t size) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t cap = size / 2;
+  struct riscv_insn *insns = malloc(cap * sizeof(*insns));
+  if (!insns) {
+    return;
+  }
+  uint64_t checksum = 0;
+  uint64_t total = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    size_t n = riscv_decode_buffer_parallel(buf, size, 0, insns, cap,
+        threads > 0 ? threads : 1);
+    for (size_t i = 0; i < n; ++i) {
+      checksum += insns[i].kind;
+    }
+    total += n;
+  }
+  bench_stop(&timer);
+  char name[32];
+  snprintf(name, sizeof(name), "riscv_decode_par/%ld", threads);
+  bench_report(name, "mixed", &timer, total, checksum);
+  free(insns);
+}
+
+struct bench_sink {
+  uint64_t checksum;
+  uint64_t total;
+};
+
+static void bench_sink_emit(void *ctx, const struct riscv_insn *insns,
+    size_t count) {
+  struct bench_sink *sink = ctx;
+  for (size_t i = 0; i < count; ++i) {
+    sink->checksum += insns[i].kind;
+  }
+  sink->total += count;
+}
+
+/* Feeds the buffer to a stream in odd-sized chunks, as reads from a pipe
+ * would deliver it, so that instructions are split across chunks. */
+static void bench_stream(const uint8_t *buf, size_t size) {
+  struct bench_sink sink = { 0, 0 };
+  struct riscv_stream *stream = riscv_stream_create(BUFFER_BATCH, NULL, 0,
+      bench_sink_emit, &sink);
+  if (!stream) {
+    return;
+  }
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    for (size_t offset = 0; offset < size; offset += 4095) {
+      riscv_stream_feed(stream, buf + offset,
+          size - offset < 4095 ? size - offset : 4095);
+    }
+  }
+  riscv_stream_flush(stream);
+  bench_stop(&timer);
+  bench_report("riscv_stream", "mixed", &timer, sink.total, sink.checksum);
+  riscv_stream_destroy(stream);
+}
+
+#define TRACE_RECORD 16
+
+/* Lays `size` words out as trace records with increasing PCs. */
+static uint8_t *bench_make_trace(const uint32_t *corpus, size_t size) {
+  uint8_t *records = malloc(size * TRACE_RECORD);
+  if (!records) {
+    return NULL;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    uint64_t pc = 0x80000000ull + 4 * i;
+    memcpy(records + i * TRACE_RECORD, &pc, 8);
+    memcpy(records + i * TRACE_RECORD + 8, &corpus[i], 4);
+    memset(records + i * TRACE_RECORD + 12, 0, 4);
+  }
+  return records;
+}
+
+/* Baseline for trace decoding: one riscv_decode() call per record. */
+static void bench_trace_per_record(const uint8_t *records, size_t size) {
+  struct riscv_insn insn;
+  struct riscv_operands ops;
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    for (size_t i = 0; i < size; ++i) {
+      uint32_t repr;
+      uint64_t pc;
+      memcpy(&pc, records + i * TRACE_RECORD, 8);
+      memcpy(&repr, records + i * TRACE_RECORD + 8, 4);
+      riscv_decode(&insn, repr);
+      riscv_insn_operands(&insn, &ops);
+      checksum += insn.kind + ops.rd + pc;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("trace_per_record", "hot", &timer, (uint64_t)size * ITERATIONS,
+      checksum);
+}
+
+static void bench_trace_decode(const uint8_t *records, size_t size) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  uint64_t *pc = malloc(size * sizeof(*pc));
+  uint16_t *kind = malloc(size * sizeof(*kind));
+  uint8_t *regs = malloc(size * 4);
+  int32_t *imm = malloc(size * sizeof(*imm));
+  struct riscv_trace trace;
+  if (pc && kind && regs && imm
+      && riscv_trace_init(&trace, records, size * TRACE_RECORD, TRACE_RECORD)) {
+    const struct riscv_insn_soa soa = { kind, regs, regs + size,
+      regs + 2 * size, imm, regs + 3 * size };
+    uint64_t checksum = 0;
+    struct bench_timer timer = bench_start();
+    for (int it = 0; it < ITERATIONS; ++it) {
+      riscv_trace_decode(&trace, 0, size, NULL, pc, &soa,
+          threads > 0 ? threads : 1);
+      checksum += kind[it % size] + regs[it % size] + pc[it % size];
+    }
+    bench_stop(&timer);
+    char name[32];
+    snprintf(name, sizeof(name), "riscv_trace_decode/%ld", threads);
+    bench_report(name, "hot", &timer, (uint64_t)size * ITERATIONS, checksum);
+    if (!bench_json) {
+      printf("%-24s %-12s %8.2f GB/s of trace\n", name, "hot",
+          (double)size * TRACE_RECORD * ITERATIONS / timer.ns);
+    }
+  }
+  free(pc);
+  free(kind);
+  free(regs);
+  free(imm);
+}
+
+#define FORMAT_BUFFER (64 * 1024)
+
+/* Baseline for disassembly: snprintf() of the kind name and operands. */
+static void bench_format_snprintf(const struct riscv_insn *insns, size_t n) {
+  static char out[FORMAT_BUFFER];
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    size_t used = 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (FORMAT_BUFFER - used < 128) {
+        checksum += out[used / 2];
+        used = 0;
+      }
+      struct riscv_operands ops;
+      riscv_insn_operands(&insns[i], &ops);
+      used += snprintf(out + used, FORMAT_BUFFER - used,
+          "%8llx:\t%s\tx%u,x%u,x%u,%d\n", (unsigned long long)insns[i].pc,
+          riscv_kind_names[insns[i].kind], ops.rd, ops.rs1, ops.rs2, ops.imm);
+    }
+    checksum += used;
+  }
+  bench_stop(&timer);
+  bench_report("snprintf_format", "mixed", &timer, (uint64_t)n * ITERATIONS,
+      checksum);
+}
+
+static void bench_format_batch(const struct riscv_insn *insns, size_t n) {
+  static char out[FORMAT_BUFFER];
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    size_t done = 0;
+    while (done < n) {
+      size_t length;
+      done += riscv_format_batch(insns + done, n - done, out, FORMAT_BUFFER,
+          &length);
+      checksum += length + out[length / 2];
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_format_batch", "mixed", &timer, (uint64_t)n * ITERATIONS,
+      checksum);
+}
+
+/* Baseline for register masks: a switch over the format on top of
+ * riscv_insn_operands(). */
+static void bench_regs_switch(const struct riscv_insn *insns, size_t n) {
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    for (size_t i = 0; i < n; ++i) {
+      const struct riscv_insn *insn = &insns[i];
+      struct riscv_operands ops;
+      riscv_insn_operands(insn, &ops);
+      uint64_t read = 0, write = 0;
+      switch (insn->type) {
+        case INSN_R:
+          read = (1ull << ops.rs1) | (1ull << ops.rs2);
+          write = 1ull << ops.rd;
+          break;
+        case INSN_I:
+          if (insn->kind != RVINSN_ECALL && insn->kind != RVINSN_EBREAK) {
+            read = 1ull << ops.rs1;
+            write = 1ull << ops.rd;
+          }
+          break;
+        case INSN_S:
+        case INSN_B:
+          read = (1ull << ops.rs1) | (1ull << ops.rs2);
+          break;
+        case INSN_U:
+        case INSN_J:
+          write = 1ull << ops.rd;
+          break;
+      }
+      checksum += (read & ~1ull) ^ (write & ~1ull);
+    }
+  }
+  bench_stop(&timer);
+  bench_report("regs_switch", "mixed", &timer, (uint64_t)n * ITERATIONS,
+      checksum);
+}
+
+static void bench_regs_table(const struct riscv_insn *insns, size_t n) {
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    for (size_t i = 0; i < n; ++i) {
+      struct riscv_reg_masks masks;
+      riscv_insn_regs(&insns[i], &masks);
+      checksum += masks.read ^ masks.write;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_insn_regs", "mixed", &timer, (uint64_t)n * ITERATIONS,
+      checksum);
+}
+
+/* Baseline for classification: bytes accessed and control transfers
+ * counted with a switch over the kind. */
+static void bench_classify_switch(const struct riscv_insn *insns, size_t n) {
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    for (size_t i = 0; i < n; ++i) {
+      switch (insns[i].kind) {
+        case RVINSN_LB: case RVINSN_LBU: case RVINSN_SB:
+          checksum += 1;
+          break;
+        case RVINSN_LH: case RVINSN_LHU: case RVINSN_SH:
+          checksum += 2;
+          break;
+        case RVINSN_LW: case RVINSN_LWU: case RVINSN_SW:
+          checksum += 4;
+          break;
+        case RVINSN_LD: case RVINSN_SD:
+          checksum += 8;
+          break;
+        case RVINSN_BEQ: case RVINSN_BNE: case RVINSN_BLT: case RVINSN_BGE:
+        case RVINSN_BLTU: case RVINSN_BGEU: case RVINSN_JAL: case RVINSN_JALR:
+          checksum += 1 << 16;
+          break;
+      }
+    }
+  }
+  bench_stop(&timer);
+  bench_report("classify_switch", "mixed", &timer, (uint64_t)n * ITERATIONS,
+      checksum);
+}
+
+static void bench_classify_flags(const struct riscv_insn *insns, size_t n) {
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    for (size_t i = 0; i < n; ++i) {
+      uint32_t flags = riscv_kind_flags[insns[i].kind];
+      checksum += riscv_access_size(flags);
+      checksum += (uint64_t)!!(flags & (RISCV_FLAG_BRANCH | RISCV_FLAG_JUMP)) << 16;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_kind_flags", "mixed", &timer, (uint64_t)n * ITERATIONS,
+      checksum);
+}
+
+// Passes over instructions that are already decoded
+static void bench_decoded(const uint8_t *buf, size_t size) {
+  size_t cap = size / 2;
+  struct riscv_insn *insns = malloc(cap * sizeof(*insns));
+  if (!insns) {
+    return;
+  }
+  size_t n = riscv_decode_buffer(buf, size, 0x10000, insns, cap);
+  bench_format_snprintf(insns, n);
+  bench_format_batch(insns, n);
+  bench_regs_switch(insns, n);
+  bench_regs_table(insns, n);
+  bench_classify_switch(insns, n);
+  bench_classify_flags(insns, n);
+  free(insns);
+}
+
+static void bench_decode_blocks(const uint8_t *buf, size_t size,
+    const char *corpus) {
+  static struct riscv_insn insns[BUFFER_BATCH];
+  uint64_t checksum = 0;
+  uint64_t total = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    size_t offset = 0;
+    struct riscv_block block;
+    while (riscv_decode_block(buf + offset, size - offset, offset, insns,
+          BUFFER_BATCH, &block) != 0) {
+      checksum += block.terminator + block.target_pc;
+      offset += block.length;
+      total += block.count;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_decode_block", corpus, &timer, total, checksum);
+}
+
+/* Block decoding followed by the dataflow summary of each block, while its
+ * instructions are still in cache. */
+static void bench_block_dataflow(const uint8_t *buf, size_t size) {
+  static struct riscv_insn insns[BUFFER_BATCH];
+  static struct riscv_insn_defs defs[BUFFER_BATCH];
+  uint64_t checksum = 0;
+  uint64_t total = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    size_t offset = 0;
+    struct riscv_block block;
+    while (riscv_decode_block(buf + offset, size - offset, offset, insns,
+          BUFFER_BATCH, &block) != 0) {
+      struct riscv_block_summary summary;
+      riscv_block_dataflow(insns, block.count, defs, &summary);
+      checksum += summary.use ^ summary.def ^ summary.depth;
+      offset += block.length;
+      total += block.count;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_block_dataflow", "mixed", &timer, total, checksum);
+}
+
+struct bench_guest {
+  const uint8_t *buf;
+  size_t size;
+};
+
+static size_t bench_guest_fetch(void *ctx, uint64_t addr, uint8_t *buf,
+    size_t len) {
+  const struct bench_guest *guest = ctx;
+  if (addr >= guest->size) {
+    return 0;
+  }
+  if (len > guest->size - addr) {
+    len = guest->size - addr;
+  }
+  memcpy(buf, guest->buf + addr, len);
+  return len;
+}
+
+/* Same walk as bench_walk_per_insn(), fetching through a page cache that
+ * holds the whole buffer after the first pass. */
+static void bench_page_cache(const uint8_t *buf, size_t size) {
+  struct bench_guest guest = { buf, size };
+  struct riscv_page_cache *cache = riscv_page_cache_create(
+      size / RISCV_PAGE_SIZE + 1, NULL, bench_guest_fetch, &guest);
+  if (!cache) {
+    return;
+  }
+  uint64_t checksum = 0;
+  uint64_t insns = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    uint64_t pc = 0;
+    while (size - pc >= 4) {
+      const struct riscv_insn *insn = riscv_page_cache_lookup(cache, pc);
+      checksum += insn->kind;
+      pc += (buf[pc] & 0b11) == 0b11 ? 4 : 2;
+      ++insns;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_page_cache", "mixed", &timer, insns, checksum);
+  riscv_page_cache_destroy(cache);
+}
+
+/* Decodes into attribute arrays and then makes a pass over `kind` only, the
+ * way a histogram pass would. */
+static void bench_decode_buffer_soa(const uint8_t *buf, size_t size) {
+  static uint16_t kind[BUFFER_BATCH];
+  static uint8_t rd[BUFFER_BATCH], rs1[BUFFER_BATCH], rs2[BUFFER_BATCH];
+  static int32_t imm[BUFFER_BATCH];
+  static uint8_t len[BUFFER_BATCH];
+  const struct riscv_insn_soa soa = { kind, rd, rs1, rs2, imm, len };
+  uint64_t checksum = 0;
+  uint64_t total = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    size_t offset = 0;
+    size_t n;
+    while ((n = riscv_decode_buffer_soa(buf + offset, size - offset, &soa,
+            BUFFER_BATCH)) != 0) {
+      for (size_t i = 0; i < n; ++i) {
+        checksum += kind[i];
+        offset += len[i];
+      }
+      total += n;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_decode_buffer_soa", "mixed", &timer, total, checksum);
+}
+
+static void bench_decode_buffer_packed(const uint8_t *buf, size_t size) {
+  static struct riscv_insn_packed insns[BUFFER_BATCH];
+  uint64_t checksum = 0;
+  uint64_t total = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    size_t offset = 0;
+    size_t n;
+    while ((n = riscv_decode_buffer_packed(buf + offset, size - offset, insns,
+            BUFFER_BATCH)) != 0) {
+      for (size_t i = 0; i < n; ++i) {
+        checksum += insns[i].kind;
+        offset += riscv_packed_length(&insns[i]);
+      }
+      total += n;
+    }
+  }
+  bench_stop(&timer);
+  bench_report("riscv_decode_buffer_pack", "mixed", &timer, total, checksum);
+}
+
+static uint64_t bench_count_starts(const uint64_t *starts, size_t halfwords) {
+  uint64_t count = 0;
+  for (size_t i = 0; i < (halfwords + 63) / 64; ++i) {
+    count += __builtin_popcountll(starts[i]);
+  }
+  return count;
+}
+
+/* Baseline for boundary scanning: step one instruction at a time. */
+static void bench_scan_scalar(const uint8_t *buf, size_t size, uint64_t *starts) {
+  size_t halfwords = size / 2;
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    memset(starts, 0, (halfwords + 63) / 64 * sizeof(*starts));
+    for (size_t i = 0; i < halfwords;) {
+      starts[i / 64] |= 1ull << (i % 64);
+      i += (buf[2 * i] & 0b11) == 0b11 ? 2 : 1;
+    }
+    checksum += starts[it % ((halfwords + 63) / 64)];
+  }
+  bench_stop(&timer);
+  bench_report("scan_scalar_walk", "rvc_dense", &timer,
+      bench_count_starts(starts, halfwords) * ITERATIONS, checksum);
+}
+
+static void bench_scan_boundaries(const uint8_t *buf, size_t size, uint64_t *starts) {
+  size_t halfwords = size / 2;
+  uint64_t checksum = 0;
+  struct bench_timer timer = bench_start();
+  for (int it = 0; it < ITERATIONS; ++it) {
+    riscv_scan_boundaries(buf, size, starts);
+    checksum += starts[it % ((halfwords + 63) / 64)];
+  }
+  bench_stop(&timer);
+  bench_report("riscv_scan_boundaries", "rvc_dense", &timer,
+      bench_count_starts(starts, halfwords) * ITERATIONS, checksum);
+}
+
+int main(int argc, char **argv) {
+  int perf = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--json") == 0) {
+      bench_json = 1;
+    } else if (strcmp(argv[i], "--perf") == 0) {
+      perf = 1;
+    } else {
+      fprintf(stderr, "usage: %s [--json] [--perf]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (perf) {
+    bench_perf_open();
+  }
+
+  uint32_t *corpus = malloc(CORPUS_SIZE * sizeof(*corpus));
+  if (!corpus) {
+    return 1;
+  }
+  bench_json_begin();
+
+  bench_fill_random(corpus, CORPUS_SIZE);
+  bench_decode_fn("riscv_decode", "random", riscv_decode, corpus, CORPUS_SIZE);
+  bench_latency("riscv_decode", "random", riscv_decode, corpus, CORPUS_SIZE);
+  bench_decode_fn("riscv_decode_branchless", "random", riscv_decode_branchless,
+      corpus, CORPUS_SIZE);
+  bench_latency("riscv_decode_branchless", "random", riscv_decode_branchless,
+      corpus, CORPUS_SIZE);
+  bench_fill_illegal(corpus, CORPUS_SIZE);
+  bench_decode_fn("riscv_decode", "illegal", riscv_decode, corpus, CORPUS_SIZE);
+  bench_latency("riscv_decode", "illegal", riscv_decode, corpus, CORPUS_SIZE);
+  bench_decode_fn("riscv_decode_branchless", "illegal", riscv_decode_branchless,
+      corpus, CORPUS_SIZE);
+  bench_latency("riscv_decode_branchless", "illegal", riscv_decode_branchless,
+      corpus, CORPUS_SIZE);
+
+  bench_fill_rv64im(corpus, CORPUS_SIZE);
+  bench_latency("riscv_decode", "rv64im", riscv_decode, corpus, CORPUS_SIZE);
+  bench_decode_fn("hook_chain", "rv64im", hook_chain_decode, corpus, CORPUS_SIZE);
+  bench_decode_fn("riscv_decode", "rv64im", riscv_decode, corpus, CORPUS_SIZE);
+  bench_decode_fn("riscv_decode_exact", "rv64im", riscv_decode_exact, corpus,
+      CORPUS_SIZE);
+  bench_decode_fn("riscv_decode_branchless", "rv64im", riscv_decode_branchless,
+      corpus, CORPUS_SIZE);
+  bench_latency("riscv_decode_branchless", "rv64im", riscv_decode_branchless,
+      corpus, CORPUS_SIZE);
+  if (riscv_decoder_init(&bench_decoder, 64, RISCV_EXT_M)) {
+    bench_decode_fn("riscv_decoder_decode", "rv64im", bench_decoder_decode,
+        corpus, CORPUS_SIZE);
+  }
+  bench_decode_words(corpus, CORPUS_SIZE);
+
+  bench_fill_hot(corpus, CORPUS_SIZE);
+  bench_decode_fn("riscv_decode", "hot", riscv_decode, corpus, CORPUS_SIZE);
+  bench_decode_fn("riscv_decode_branchless", "hot", riscv_decode_branchless,
+      corpus, CORPUS_SIZE);
+  bench_decode_cache(corpus, CORPUS_SIZE);
+  uint8_t *records = bench_make_trace(corpus, CORPUS_SIZE);
+  if (records) {
+    bench_trace_per_record(records, CORPUS_SIZE);
+    bench_trace_decode(records, CORPUS_SIZE);
+    free(records);
+  }
+
+#ifdef SUPPORT_COMPRESSED
+  bench_fill_rvc(corpus, CORPUS_SIZE);
+  bench_decode_fn("hook16_chain", "rvc", hook16_chain_decode, corpus, CORPUS_SIZE);
+  bench_decode_fn("rvc_decode", "rvc", rvc_decode, corpus, CORPUS_SIZE);
+  bench_latency("rvc_decode", "rvc", rvc_decode, corpus, CORPUS_SIZE);
+#endif // SUPPORT_COMPRESSED
+
+  uint8_t *bytes = (uint8_t *)corpus;
+  size_t nbytes = bench_fill_mixed(bytes, CORPUS_SIZE * sizeof(*corpus), 50);
+  bench_walk_per_insn(bytes, nbytes);
+  bench_decode_buffer(bytes, nbytes, "mixed");
+  bench_decode_buffer_parallel(bytes, nbytes);
+  bench_stream(bytes, nbytes);
+  bench_decode_blocks(bytes, nbytes, "mixed");
+  bench_block_dataflow(bytes, nbytes);
+  bench_page_cache(bytes, nbytes);
+  bench_decode_buffer_soa(bytes, nbytes);
+  bench_decode_buffer_packed(bytes, nbytes);
+  bench_decoded(bytes, nbytes);
+
+  nbytes = bench_fill_synthetic(bytes, CORPUS_SIZE * sizeof(*corpus));
+  if (nbytes != 0) {
+    bench_decode_buffer(bytes, nbytes, "synthetic");
+    bench_decode_blocks(bytes, nbytes, "synthetic");
+  }
+
+  uint64_t *starts = malloc((nbytes / 2 + 63) / 64 * sizeof(*starts));
+  if (!starts) {
+    free(corpus);
+    return 1;
+  }
+  nbytes = bench_fill_mixed(bytes, CORPUS_SIZE * sizeof(*corpus), 80);
+  bench_scan_scalar(bytes, nbytes, starts);
+  bench_scan_boundaries(bytes, nbytes, starts);
+  free(starts);
+
+  free(corpus);
+  bench_json_end();
+  return 0;
+}
@@ -0,0 +1,84 @@
+#ifndef RISCV_CORPUS_H
+#define RISCV_CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <rvdec/instruction.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Generator of synthetic instruction streams for benchmarks and fuzzing.
+ *
+ * Every word is a valid encoding of a kind picked from riscv_encodings by
+ * weight, with its register fields, immediate and compressed form drawn from
+ * configurable distributions. The stream depends only on the configuration,
+ * including the seed, so a corpus can be reproduced anywhere instead of
+ * being stored. */
+
+// How immediates are drawn
+enum riscv_imm_model {
+  // Magnitudes spread evenly over their bit lengths, so small values are the
+  // most common as in compiled code, with loads and stores aligned to their
+  // access size and fences ordering everything
+  RISCV_IMM_SMALL,
+  // Uniformly random over the field
+  RISCV_IMM_UNIFORM
+};
+
+struct riscv_corpus_config {
+  uint64_t seed;
+  // Profile every word decodes in, as for riscv_decoder_init()
+  unsigned xlen;
+  uint32_t extensions;
+  // Relative frequency of each kind, RVINSN_ILLEGAL entries, or NULL to
+  // weigh the kinds the same. Kinds outside the profile are never picked.
+  const uint32_t *kind_weights;
+  // Relative frequency of x0-x31 in each register field, or NULL for a
+  // built-in model of compiled code that favors sp, s0 and the a registers
+  const uint32_t *reg_weights;
+  enum riscv_imm_model imm_model;
+  // Percentage of instructions whose kind has a compressed form that are
+  // emitted compressed, with RISCV_EXT_C. Compressed words are picked evenly
+  // among those that expand to the kind and don't follow the register and
+  // immediate models.
+  unsigned rvc_percent;
+};
+
+/* Sets `config` to the profile of config.h with seed 0, every kind weighed
+ * the same, the built-in register model, RISCV_IMM_SMALL and half of the
+ * instructions that can be compressed emitted compressed. */
+void riscv_corpus_config_init(struct riscv_corpus_config *config);
+
+struct riscv_corpus;
+
+/* Returns a generator for `config`, which isn't referenced afterwards, or
+ * NULL if the profile isn't supported, no kind of the profile has weight or
+ * memory runs out. */
+struct riscv_corpus *riscv_corpus_create(const struct riscv_corpus_config *config);
+void riscv_corpus_destroy(struct riscv_corpus *corpus);
+
+/* Generates the next instruction and returns its length, 2 or 4. Stores it
+ * to `*word` with a compressed instruction in the low halfword, and its kind
+ * to `*kind` if `kind` isn't NULL. */
+unsigned riscv_corpus_next(struct riscv_corpus *corpus, uint32_t *word,
+    int *kind);
+
+/* Writes the next instructions to `buf` in little-endian order until the
+ * next one doesn't fit, which is then the first one of the following call,
+ * so the bytes don't depend on how the stream is split. Returns the number
+ * of bytes written. */
+size_t riscv_corpus_fill(struct riscv_corpus *corpus, uint8_t *buf, size_t len);
+
+/* Adds the number of instructions of each kind in `insns` to `weights`,
+ * which has RVINSN_ILLEGAL entries, for generating code that looks like a
+ * real binary. Illegal instructions aren't counted. */
+void riscv_corpus_histogram(const struct riscv_insn *insns, size_t count,
+    uint32_t *weights);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_CORPUS_H
@@ -0,0 +1,67 @@
+#ifndef RISCV_DATAFLOW_H
+#define RISCV_DATAFLOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <rvdec/instruction.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Register dataflow over decoded code, built on riscv_insn_regs(). Register
+ * sets are 64-bit masks laid out as in `struct riscv_reg_masks`, so each set
+ * operation handles every register at once, and x0 is never part of a
+ * dependency. */
+
+// Source that isn't read, such as rs2 of an I-type instruction or x0
+#define RISCV_DEF_NONE UINT32_MAX
+// Source whose value was set before the block
+#define RISCV_DEF_LIVE_IN (UINT32_MAX - 1)
+
+/* Instruction of the block that wrote each source of an instruction, as an
+ * index into the block, or one of the RISCV_DEF_* values. */
+struct riscv_insn_defs {
+  uint32_t rs1;
+  uint32_t rs2;
+};
+
+/* Dataflow summary of a basic block. */
+struct riscv_block_summary {
+  // Registers read before the block writes them
+  uint64_t use;
+  // Registers the block writes
+  uint64_t def;
+  // Instructions on the longest chain of register dependencies in the block,
+  // counting each instruction as one step
+  uint32_t depth;
+};
+
+/* Walks the `count` instructions of a block once, filling `summary` and, if
+ * `defs` isn't NULL, defs[i] for each instruction i. */
+void riscv_block_dataflow(const struct riscv_insn *insns, size_t count,
+    struct riscv_insn_defs *defs, struct riscv_block_summary *summary);
+
+// No successor, for blocks with fewer than two
+#define RISCV_BLOCK_NONE UINT32_MAX
+
+/* Solves liveness for the `nblocks` blocks of a function, where succs[b]
+ * holds up to two indices, below `nblocks`, of the blocks that can follow
+ * block b, such as the fall-through and taken target of riscv_decode_block().
+ *
+ * live_out[b] must hold, on entry, the registers live past block b outside
+ * the function, such as the return value and callee-saved registers after a
+ * return, and usually 0 otherwise. It's extended with the live-in sets of
+ * the successors, and live_in[b] is set to use | (live_out & ~def) of the
+ * block. Blocks are visited last to first, so code laid out in order
+ * mostly settles in two or three passes. Returns the number of passes over
+ * the blocks, the last of which changed nothing. */
+unsigned riscv_liveness(const struct riscv_block_summary *summaries,
+    const uint32_t (*succs)[2], size_t nblocks, uint64_t *live_in,
+    uint64_t *live_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_DATAFLOW_H
@@ -1,6 +1,7 @@
 #ifndef RISCV_DECODE_H
 #define RISCV_DECODE_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <rvdec/instruction.h>
 
@@ -9,6 +10,200 @@ extern "C" {
 #endif
 
 int riscv_decode(struct riscv_insn *insn, uint32_t repr);
+/* Same as riscv_decode(), but only accepts 32-bit words that match the
+ * mask/match encoding of an instruction in insn_set_defs/ exactly, where
+ * riscv_decode() ignores some fixed fields (funct3 of JALR and FENCE, the
+ * upper bits of ECALL and EBREAK, funct7 of SLLI and RV32 SRAI). */
+int riscv_decode_exact(struct riscv_insn *insn, uint32_t repr);
+/* Same kind and fields as riscv_decode(), found with table lookups and
+ * masks instead of branches, so the cost is the same for every word. That
+ * cost is not lower though: within about 10% of riscv_decode() on compiled
+ * code, but 1.5 to 2 times slower on random words and 3 to 4 times slower on
+ * illegal ones, which riscv_decode() rejects early. Only worth it where
+ * rvdec_bench shows mispredictions costing more on the actual input. Words
+ * that don't decode are stored as by riscv_decode_words(), and `pc` is left
+ * alone. */
+int riscv_decode_branchless(struct riscv_insn *insn, uint32_t repr);
+size_t riscv_decode_buffer(const uint8_t *buf, size_t len, uint64_t base_pc,
+    struct riscv_insn *out, size_t cap);
+
+/* Destination of riscv_decode_buffer_soa(), one array per attribute, each
+ * holding at least `cap` elements. Operands are stored as by
+ * riscv_insn_operands(), `len` is the encoding size in bytes. */
+struct riscv_insn_soa {
+  uint16_t *kind;
+  uint8_t *rd;
+  uint8_t *rs1;
+  uint8_t *rs2;
+  int32_t *imm;
+  uint8_t *len;
+};
+
+/* Same walk as riscv_decode_buffer(), storing instruction i to element i of
+ * each array of `out`. Returns the number of instructions stored. */
+size_t riscv_decode_buffer_soa(const uint8_t *buf, size_t len,
+    const struct riscv_insn_soa *out, size_t cap);
+
+/* Same walk as riscv_decode_buffer(), storing packed instructions. The
+ * instruction following out[i] starts riscv_packed_length(&out[i]) bytes
+ * after it. Returns the number of instructions stored. */
+size_t riscv_decode_buffer_packed(const uint8_t *buf, size_t len,
+    struct riscv_insn_packed *out, size_t cap);
+
+/* Same result as riscv_decode_buffer(), decoded by up to `threads` threads
+ * that each take a slice of `buf`. Buffers too small to be worth splitting
+ * are decoded on the calling thread. */
+size_t riscv_decode_buffer_parallel(const uint8_t *buf, size_t len,
+    uint64_t base_pc, struct riscv_insn *out, size_t cap, unsigned threads);
+
+/* Why riscv_decode_block() stopped. */
+enum riscv_block_end {
+  // Ran out of `len` or `cap` before a terminator
+  RISCV_BLOCK_TRUNCATED,
+  // Conditional branch
+  RISCV_BLOCK_BRANCH,
+  // JAL, or JALR with `indirect` set
+  RISCV_BLOCK_JUMP,
+  // ECALL or EBREAK
+  RISCV_BLOCK_TRAP,
+  // Encoding that doesn't decode
+  RISCV_BLOCK_ILLEGAL
+};
+
+/* Straight-line run of instructions decoded by riscv_decode_block(). */
+struct riscv_block {
+  size_t count;
+  // Size of the block in bytes, terminator included
+  size_t length;
+  enum riscv_block_end end;
+  // Kind of the last instruction, RVINSN_ILLEGAL for a truncated block
+  int terminator;
+  // The block ends in a JALR, whose target isn't known until it runs
+  bool indirect;
+  // PC following the terminator
+  uint64_t fallthrough_pc;
+  // Target of the terminating branch or JAL, 0 for other ends
+  uint64_t target_pc;
+};
+
+/* Same walk as riscv_decode_buffer(), stopping after the first branch, jump,
+ * ECALL, EBREAK or illegal encoding, which ends up in out[count - 1]. Fills
+ * `block` and returns the number of instructions stored. */
+size_t riscv_decode_block(const uint8_t *buf, size_t len, uint64_t pc,
+    struct riscv_insn *out, size_t cap, struct riscv_block *block);
+
+/* Marks where instructions begin in `buf`, which must start at an instruction
+ * boundary: bit (i % 64) of starts[i / 64] is set if an instruction starts at
+ * halfword i. `starts` must hold (len / 2 + 63) / 64 words. Returns the number
+ * of halfwords scanned. */
+size_t riscv_scan_boundaries(const uint8_t *buf, size_t len, uint64_t *starts);
+
+/* Decodes `n` 32-bit instruction words, for code without compressed
+ * instructions. Words that don't decode are stored as RVINSN_ILLEGAL. */
+void riscv_decode_words(const uint32_t *words, size_t n, struct riscv_insn *out);
+
+/* Extensions of an ISA profile beyond the base integer set. */
+enum riscv_extension {
+  RISCV_EXT_M = 1 << 0,
+  RISCV_EXT_C = 1 << 1
+};
+
+/* Decoder for one ISA profile, chosen at runtime. Decoders of different
+ * profiles can be used side by side; each is bound to constant tables built
+ * for its profile, so decoding with one costs the same as riscv_decode(). */
+struct riscv_decoder {
+  unsigned xlen;
+  uint32_t extensions;
+  // Tables of the profile, set by riscv_decoder_init()
+  const void *dispatch;
+  const struct riscv_insn *rvc;
+};
+
+/* Sets up `dec` for the base integer set of `xlen` (32 or 64) plus the
+ * `extensions` mask of `enum riscv_extension`. Returns 1 on success and 0 if
+ * the profile isn't supported by this build (see config.h). */
+int riscv_decoder_init(struct riscv_decoder *dec, unsigned xlen,
+    uint32_t extensions);
+/* riscv_decode(), riscv_decode_buffer(), riscv_decode_block() and
+ * riscv_decode_buffer_parallel() for the profile of `dec`. 32-bit words are
+ * checked exactly, as by riscv_decode_exact(). */
+int riscv_decoder_decode(const struct riscv_decoder *dec,
+    struct riscv_insn *insn, uint32_t repr);
+size_t riscv_decoder_decode_buffer(const struct riscv_decoder *dec,
+    const uint8_t *buf, size_t len, uint64_t base_pc,
+    struct riscv_insn *out, size_t cap);
+size_t riscv_decoder_decode_block(const struct riscv_decoder *dec,
+    const uint8_t *buf, size_t len, uint64_t pc,
+    struct riscv_insn *out, size_t cap, struct riscv_block *block);
+size_t riscv_decoder_decode_buffer_parallel(const struct riscv_decoder *dec,
+    const uint8_t *buf, size_t len, uint64_t base_pc,
+    struct riscv_insn *out, size_t cap, unsigned threads);
+
+/* Memo of decoded instructions keyed by the raw word passed to
+ * riscv_decode(), for simulators that decode the same hot words over and
+ * over. Entries only depend on the word, so a cache stays valid when code is
+ * rewritten and can be shared by all harts of a profile, though it isn't
+ * safe to use from several threads at once. */
+struct riscv_decode_cache_entry {
+  uint32_t repr;
+  uint32_t valid;
+  struct riscv_insn insn;
+};
+
+struct riscv_decode_cache {
+  // 2-way set associative, `mask + 1` sets of two consecutive entries, the
+  // most recently used word of a set first
+  struct riscv_decode_cache_entry *entries;
+  uint32_t mask;
+  // Profile to decode with, NULL for riscv_decode()
+  const struct riscv_decoder *dec;
+  uint64_t hits;
+  uint64_t misses;
+};
+
+/* Sets up `cache` over the caller-owned array `entries` of `size` elements,
+ * which must be a power of two of at least 2, and empties it. Misses are
+ * decoded with `dec` or with riscv_decode() if it's NULL. Returns 1 on success
+ * and 0 if `size` isn't valid. */
+int riscv_decode_cache_init(struct riscv_decode_cache *cache,
+    struct riscv_decode_cache_entry *entries, size_t size,
+    const struct riscv_decoder *dec);
+/* Drops every entry, keeping the counters. */
+void riscv_decode_cache_clear(struct riscv_decode_cache *cache);
+/* Decodes `repr` into `set`, the set of `repr` in `cache`, and counts a miss.
+ * Called by riscv_decode_cache_lookup(). */
+const struct riscv_insn *riscv_decode_cache_fill(
+    struct riscv_decode_cache *cache, struct riscv_decode_cache_entry *set,
+    uint32_t repr);
+
+static inline uint32_t riscv_decode_cache_set(
+    const struct riscv_decode_cache *cache, uint32_t repr) {
+  // Words of one opcode differ mostly in their upper bits, fold them down
+  uint32_t hash = repr * 0x9e3779b1u;
+  return (hash ^ (hash >> 16)) & cache->mask;
+}
+
+/* Decoded form of `repr`, as riscv_decode() would store it with a `pc` of 0.
+ * The result points into the cache and stays valid until the next lookup in
+ * the set of `repr`, or riscv_decode_cache_clear(). */
+static inline const struct riscv_insn *riscv_decode_cache_lookup(
+    struct riscv_decode_cache *cache, uint32_t repr) {
+  struct riscv_decode_cache_entry *set =
+    &cache->entries[2 * riscv_decode_cache_set(cache, repr)];
+  if (set[0].valid && set[0].repr == repr) {
+    ++cache->hits;
+    return &set[0].insn;
+  }
+  if (set[1].valid && set[1].repr == repr) {
+    // Move it to the first way, so that misses evict the least recently used
+    struct riscv_decode_cache_entry hit = set[1];
+    set[1] = set[0];
+    set[0] = hit;
+    ++cache->hits;
+    return &set[0].insn;
+  }
+  return riscv_decode_cache_fill(cache, set, repr);
+}
 
 void riscv_decode_r(struct riscv_insn *insn, int kind, uint32_t repr,
     uint32_t opcode);
@@ -0,0 +1,69 @@
+#ifndef RISCV_ELF_H
+#define RISCV_ELF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <rvdec/decode.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Minimal reader of RISC-V ELF32/ELF64 files that finds their code for the
+ * batch decoders. Files are mapped rather than read, and spans point into the
+ * mapping, so decoding a span copies nothing and memory use is whatever the
+ * page cache holds of the file. */
+
+/* Executable bytes of the file and the address they're loaded at. */
+struct riscv_elf_span {
+  const uint8_t *data;
+  size_t size;
+  uint64_t addr;
+  // Section name, NULL for segments
+  const char *name;
+};
+
+struct riscv_elf {
+  // The whole file
+  const uint8_t *data;
+  size_t size;
+  // 32 or 64, from EI_CLASS
+  unsigned xlen;
+  // EF_RISCV_RVC of e_flags: the code may hold compressed instructions
+  bool rvc;
+  uint32_t flags;
+  uint64_t entry;
+  // Sections with SHF_EXECINSTR, in section header order
+  struct riscv_elf_span *sections;
+  size_t nsections;
+  // PT_LOAD segments with PF_X, in program header order
+  struct riscv_elf_span *segments;
+  size_t nsegments;
+
+  bool mapped;
+};
+
+/* Maps the file at `path` and reads its headers into `elf`. Returns 1 on
+ * success and 0 if the file can't be mapped or isn't a little-endian RISC-V
+ * ELF file with well-formed headers. */
+int riscv_elf_open(struct riscv_elf *elf, const char *path);
+
+/* Same as riscv_elf_open() for a file already in memory, which must outlive
+ * `elf`. */
+int riscv_elf_parse(struct riscv_elf *elf, const void *data, size_t size);
+
+/* Releases what riscv_elf_open() or riscv_elf_parse() set up. */
+void riscv_elf_close(struct riscv_elf *elf);
+
+/* Sets up `dec` for the XLEN of `elf` plus `extensions`, and the C extension
+ * if the file is marked as using it. Returns the result of
+ * riscv_decoder_init(). */
+int riscv_elf_decoder_init(const struct riscv_elf *elf,
+    struct riscv_decoder *dec, uint32_t extensions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_ELF_H
@@ -0,0 +1,45 @@
+#ifndef RISCV_FORMAT_H
+#define RISCV_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <rvdec/instruction.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Disassembly in the syntax of objdump -M no-aliases: a lowercase mnemonic,
+ * a tab and the operands separated by commas, with ABI register names,
+ * decimal immediates, loads and stores as `imm(rs1)`, shift amounts and
+ * U-type immediates in hex, and branch and jump targets as absolute hex
+ * addresses. Compressed instructions are written as the instruction they
+ * expand to, and encodings that don't decode as `illegal`.
+ *
+ * Text is built from precomputed strings without printf or allocation. */
+
+// Longest instruction text, including the terminating NUL
+#define RISCV_FORMAT_MAX 32
+// Longest line of riscv_format_batch(), with its address and newline
+#define RISCV_FORMAT_LINE_MAX 56
+
+/* Writes the text of `insn`, located at `pc`, to `buf` as snprintf() would:
+ * at most `cap` - 1 characters followed by a NUL if `cap` isn't 0. Returns
+ * the length of the whole text. */
+size_t riscv_format(const struct riscv_insn *insn, uint64_t pc, char *buf,
+    size_t cap);
+
+/* Writes one line per instruction of `insns`, the instruction's `pc` in hex
+ * padded to 8 columns, a colon, a tab, its text and a newline, into `buf`
+ * without a terminating NUL, ready for a single write(). Stops before an
+ * instruction when fewer than RISCV_FORMAT_LINE_MAX bytes of `buf` are left.
+ * Returns the number of instructions written and stores the number of bytes
+ * to `*length`. */
+size_t riscv_format_batch(const struct riscv_insn *insns, size_t count,
+    char *buf, size_t cap, size_t *length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_FORMAT_H
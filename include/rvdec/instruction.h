@@ -19,9 +19,14 @@ enum InstructionType {
   INSN_FENCE
 };
 
-#define INSN(insn, type) RVINSN_##insn,
-#define INSN_REDECL(insn, type)
-#define CUSTOM_ABI_INSN(insn, type) RVINSN_##insn,
+/* Each instruction set lists its instructions in insn_set_defs/ as
+ * `INSN(name, format, mask, match)`: a word encodes the instruction when
+ * `(word & mask) == match`. CUSTOM_ABI_INSN entries need extraction other than
+ * the plain format's, INSN_REDECL entries give another set's encoding of an
+ * instruction that's already declared. */
+#define INSN(insn, type, mask, match) RVINSN_##insn,
+#define INSN_REDECL(insn, type, mask, match)
+#define CUSTOM_ABI_INSN(insn, type, mask, match) RVINSN_##insn,
 enum RISCVKindInstruction {
 #include "insn_set_defs/rv32i.def"
 #include "insn_set_defs/rv64i.def"
@@ -29,27 +34,111 @@ enum RISCVKindInstruction {
 #include "insn_set_defs/rv64m.def"
 
 #undef INSN
+#undef INSN_REDECL
 #undef CUSTOM_ABI_INSN
   RVINSN_ILLEGAL
 };
 
-#define INSN(insn, type) #insn,
-#define INSN_REDECL(insn, type)
-#define CUSTOM_ABI_INSN(insn, type) #insn,
+#define INSN(insn, type, mask, match) #insn,
+#define INSN_REDECL(insn, type, mask, match)
+#define CUSTOM_ABI_INSN(insn, type, mask, match) #insn,
 static const char *riscv_kind_names[] = {
 #include "insn_set_defs/rv32i.def"
 #include "insn_set_defs/rv64i.def"
 #include "insn_set_defs/rv32m.def"
 #include "insn_set_defs/rv64m.def"
 #undef INSN
+#undef INSN_REDECL
 #undef CUSTOM_ABI_INSN
   "RVINSN_ILLEGAL"
 };
 
+enum riscv_insn_set {
+  RISCV_SET_RV32I,
+  RISCV_SET_RV64I,
+  RISCV_SET_RV32M,
+  RISCV_SET_RV64M
+};
+
+/* Encoding of an instruction kind as declared in insn_set_defs/, for the set
+ * that first declares it. Generated at build time by insn_table_gen. */
+struct riscv_encoding {
+  uint32_t mask;
+  uint32_t match;
+  // enum InstructionType
+  uint8_t type;
+  // enum riscv_insn_set
+  uint8_t set;
+};
+
+extern const struct riscv_encoding riscv_encodings[RVINSN_ILLEGAL];
+
+// Operand slots of an instruction that can name a register
+enum riscv_operand_slot {
+  RISCV_SLOT_RD = 1 << 0,
+  RISCV_SLOT_RS1 = 1 << 1,
+  RISCV_SLOT_RS2 = 1 << 2
+};
+
+/* Slots each kind reads and writes as masks of `enum riscv_operand_slot`,
+ * generated at build time from insn_set_defs/. Fields a format has that an
+ * instruction doesn't use as registers, such as the rd and rs1 of FENCE,
+ * ECALL and EBREAK, are in neither mask. RVINSN_ILLEGAL has no slots. */
+struct riscv_operand_slots {
+  uint8_t reads;
+  uint8_t writes;
+};
+
+extern const struct riscv_operand_slots riscv_operand_slots[RVINSN_ILLEGAL + 1];
+
+/* Classes of an instruction kind, set in riscv_kind_flags. */
+enum riscv_kind_flag {
+  // Conditional branch
+  RISCV_FLAG_BRANCH = 1 << 0,
+  // JAL and JALR
+  RISCV_FLAG_JUMP = 1 << 1,
+  // Jump to a register, JALR
+  RISCV_FLAG_INDIRECT = 1 << 2,
+  RISCV_FLAG_LOAD = 1 << 3,
+  RISCV_FLAG_STORE = 1 << 4,
+  // MUL, MULH* and MULW
+  RISCV_FLAG_MUL = 1 << 5,
+  // DIV*, REM* and their W-variants
+  RISCV_FLAG_DIV = 1 << 6,
+  // ECALL and EBREAK
+  RISCV_FLAG_SYSTEM = 1 << 7,
+  RISCV_FLAG_FENCE = 1 << 8,
+  // RV64 instruction operating on the low 32 bits, such as ADDW or SLLIW
+  RISCV_FLAG_WORD = 1 << 9,
+  // Load that zero-extends, such as LBU
+  RISCV_FLAG_UNSIGNED = 1 << 10,
+  // Only in riscv_insn_flags(), for an instruction expanded from RVC
+  RISCV_FLAG_COMPRESSED = 1 << 11,
+  // Only for RVINSN_ILLEGAL
+  RISCV_FLAG_ILLEGAL = 1 << 12,
+
+  // log2 of the bytes a load or store accesses, in bits 16-17
+  RISCV_FLAG_SIZE_SHIFT = 16,
+  RISCV_FLAG_SIZE_MASK = 3 << 16
+};
+
+/* Flags of each kind as `enum riscv_kind_flag`, generated at build time
+ * from insn_set_defs/ like riscv_encodings, so any class is one load and a
+ * mask away. */
+extern const uint32_t riscv_kind_flags[RVINSN_ILLEGAL + 1];
+
+// Bytes a load or store with `flags` accesses, 0 for other kinds
+static inline unsigned riscv_access_size(uint32_t flags) {
+  unsigned size = 1u << ((flags & RISCV_FLAG_SIZE_MASK) >> RISCV_FLAG_SIZE_SHIFT);
+  return size & -(unsigned)!!(flags & (RISCV_FLAG_LOAD | RISCV_FLAG_STORE));
+}
+
 struct riscv_insn {
   int type;
   int kind;
   bool is_compressed;
+  // Size of the encoding in bytes, 2 or 4
+  uint8_t length;
   union {
 /* R Type Instruction
  *  31           25 24   20 19   15 14      12 11           7 6      0
@@ -144,8 +233,86 @@ struct riscv_insn {
     } fence;
 
   };
+  // Address of the instruction, only set by riscv_decode_buffer(). The
+  // decoders of single words leave it alone
+  uint64_t pc;
+};
+
+/* Operands of an instruction independent of its format. Registers the format
+ * doesn't have are 0. `imm` is sign-extended, branch and jump offsets are in
+ * bytes and the U-type immediate is already shifted to bits 31:12. */
+struct riscv_operands {
+  uint8_t rd;
+  uint8_t rs1;
+  uint8_t rs2;
+  int32_t imm;
 };
 
+void riscv_insn_operands(const struct riscv_insn *insn, struct riscv_operands *ops);
+
+/* Registers an instruction reads and writes: bit i of each mask stands for
+ * xi and bit 32 + i for fi. x0 is never set, since reading it gives a
+ * constant and writing it does nothing. */
+struct riscv_reg_masks {
+  uint64_t read;
+  uint64_t write;
+};
+
+/* Fills `masks` from riscv_operand_slots with table lookups and bit
+ * operations only, without branching on the format. */
+void riscv_insn_regs(const struct riscv_insn *insn, struct riscv_reg_masks *masks);
+
+/* riscv_kind_flags of the kind of `insn`, with RISCV_FLAG_COMPRESSED if it
+ * was expanded from a compressed instruction. */
+static inline uint32_t riscv_insn_flags(const struct riscv_insn *insn) {
+  return riscv_kind_flags[insn->kind]
+    | (uint32_t)insn->is_compressed * RISCV_FLAG_COMPRESSED;
+}
+
+/* 8-byte form of a decoded instruction for large predecoded caches. Operand
+ * fields are at fixed positions regardless of the format and `imm` holds the
+ * value riscv_insn_operands() returns, so reading them takes no
+ * sign-extension or scaling. */
+struct riscv_insn_packed {
+  uint16_t kind;
+  /* rd in bits 4:0, rs1 in bits 9:5, rs2 in bits 14:10, bit 15 set for
+   * 16-bit encodings. */
+  uint16_t regs;
+  int32_t imm;
+};
+
+#define RISCV_PACKED_REGS(rd, rs1, rs2, compressed) \
+  (uint16_t)((rd) | ((rs1) << 5) | ((rs2) << 10) | ((compressed) << 15))
+
+static inline unsigned riscv_packed_rd(const struct riscv_insn_packed *p) {
+  return p->regs & 0b11111;
+}
+
+static inline unsigned riscv_packed_rs1(const struct riscv_insn_packed *p) {
+  return (p->regs >> 5) & 0b11111;
+}
+
+static inline unsigned riscv_packed_rs2(const struct riscv_insn_packed *p) {
+  return (p->regs >> 10) & 0b11111;
+}
+
+static inline bool riscv_packed_is_compressed(const struct riscv_insn_packed *p) {
+  return p->regs >> 15;
+}
+
+// Size of the encoding in bytes, 2 or 4
+static inline unsigned riscv_packed_length(const struct riscv_insn_packed *p) {
+  return 4 - 2 * (p->regs >> 15);
+}
+
+void riscv_insn_pack(const struct riscv_insn *insn, struct riscv_insn_packed *packed);
+
+/* Rebuilds the `riscv_insn` of a packed instruction. The encoding fields the
+ * packed form doesn't keep (opcode, funct3, funct7 and FENCE's fm, pred and
+ * succ aside from `imm`) are set to the values the kind is encoded with, or
+ * left zero for compressed instructions as riscv_decode() does. `pc` is 0. */
+void riscv_insn_unpack(const struct riscv_insn_packed *packed, struct riscv_insn *insn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,78 @@
+#ifndef RISCV_PAGE_CACHE_H
+#define RISCV_PAGE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Predecoded guest code for simulators, kept per 4 KiB page.
+ *
+ * A page holds the decoded instruction starting at each of its halfwords,
+ * so execution may enter it at any 2-byte aligned PC whatever the earlier
+ * instructions were. Pages are fetched and decoded on first use, dropped by
+ * riscv_page_cache_invalidate() when the guest writes to them and evicted in
+ * least recently used order once the cache holds `max_pages`. */
+
+#define RISCV_PAGE_SHIFT 12
+#define RISCV_PAGE_SIZE (1 << RISCV_PAGE_SHIFT)
+// Decoded instructions per page, one per halfword
+#define RISCV_PAGE_SLOTS (RISCV_PAGE_SIZE / 2)
+
+/* Reads `len` bytes of guest memory at `addr` into `buf`, returning how many
+ * could be read. A page fills from a single call which asks for the page and
+ * the first halfword of the next, for 32-bit instructions that cross into
+ * it. */
+typedef size_t (*riscv_fetch_fn)(void *ctx, uint64_t addr, uint8_t *buf,
+    size_t len);
+
+struct riscv_page_cache;
+
+struct riscv_page_cache_stats {
+  // Lookups served from a decoded page
+  uint64_t hits;
+  // Lookups that decoded their page first
+  uint64_t misses;
+  uint64_t evictions;
+  // Pages dropped by riscv_page_cache_invalidate()
+  uint64_t invalidations;
+};
+
+/* Returns a cache of up to `max_pages` decoded pages, decoded with `dec` or
+ * for the profile of config.h if it's NULL, or NULL if `max_pages` is 0 or
+ * memory runs out. Each page takes RISCV_PAGE_SLOTS * sizeof(struct
+ * riscv_insn) bytes. */
+struct riscv_page_cache *riscv_page_cache_create(size_t max_pages,
+    const struct riscv_decoder *dec, riscv_fetch_fn fetch, void *ctx);
+void riscv_page_cache_destroy(struct riscv_page_cache *cache);
+
+/* Decoded page holding `addr`: element i is the instruction starting at the
+ * page address plus 2 * i, with its `pc` set. Slots whose instruction
+ * couldn't be fetched in full have a `length` of 0. Returns NULL if `fetch`
+ * read nothing. The page stays valid until it is evicted or invalidated. */
+const struct riscv_insn *riscv_page_cache_page(struct riscv_page_cache *cache,
+    uint64_t addr);
+
+/* Decoded instruction at `pc`, NULL if `pc` is odd or its page couldn't be
+ * fetched. Same lifetime as riscv_page_cache_page(). */
+const struct riscv_insn *riscv_page_cache_lookup(
+    struct riscv_page_cache *cache, uint64_t pc);
+
+/* Drops every page whose instructions overlap the `len` bytes at `addr`,
+ * including the page ending right before `addr`, whose last slot may reach
+ * into it. Call on every guest store to code. */
+void riscv_page_cache_invalidate(struct riscv_page_cache *cache,
+    uint64_t addr, uint64_t len);
+
+void riscv_page_cache_stats(const struct riscv_page_cache *cache,
+    struct riscv_page_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_PAGE_CACHE_H
@@ -0,0 +1,64 @@
+#ifndef RISCV_STATS_H
+#define RISCV_STATS_H
+
+#include <stdint.h>
+#include <rvdec/instruction.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Decode statistics of instrumented builds.
+ *
+ * Configuring with -DENABLE_DECODE_STATS=ON makes every decoder entry point
+ * count what it does in counters private to the calling thread, so no
+ * atomics or locks are taken while decoding. Threads the library starts for
+ * the parallel decoders add their counts to the calling thread's when they
+ * finish. In other builds the counting compiles away and the counters read
+ * as zero. */
+
+struct riscv_decode_stats {
+  uint64_t decodes;
+  // Decodes by resulting kind, RVINSN_ILLEGAL included
+  uint64_t kinds[RVINSN_ILLEGAL + 1];
+  // The same by format, indexed by enum InstructionType, with illegal
+  // results under INSN_UNDEFINED
+  uint64_t formats[INSN_FENCE + 1];
+  uint64_t illegal;
+
+  // Lookups of 32-bit words in the dispatch table, which holds what the
+  // per-set hooks decode for each opcode[6:2] and funct3, and how many of
+  // them gave no instruction
+  uint64_t dispatch_attempts[32][8];
+  uint64_t dispatch_failures[32][8];
+
+  // Compressed instruction lookups by op[1:0] and funct3, the fields the
+  // rvc_decode_* hooks switch on first, and how many of them gave no
+  // instruction. Row 3 counts words that aren't compressed at all.
+  uint64_t rvc_attempts[4][8];
+  uint64_t rvc_failures[4][8];
+  // 32-bit words that riscv_decode(), riscv_decode_exact() or
+  // riscv_decoder_decode() tried as a compressed instruction in the upper
+  // halfword after the 32-bit decode failed
+  uint64_t rvc_fallbacks;
+};
+
+// 1 if the library was built with ENABLE_DECODE_STATS, 0 otherwise
+int riscv_decode_stats_enabled(void);
+
+/* Copies the counters of the calling thread to `stats`. */
+void riscv_decode_stats_snapshot(struct riscv_decode_stats *stats);
+
+/* Clears the counters of the calling thread. */
+void riscv_decode_stats_reset(void);
+
+/* Adds the counters of `src` to `dst`, for totals over threads that took
+ * their own snapshots. */
+void riscv_decode_stats_merge(struct riscv_decode_stats *dst,
+    const struct riscv_decode_stats *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_STATS_H
@@ -0,0 +1,56 @@
+#ifndef RISCV_STREAM_H
+#define RISCV_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Decoder for code that arrives in pieces, such as trace data read from a
+ * pipe or socket, where there's no whole buffer to hand to
+ * riscv_decode_buffer().
+ *
+ * Chunks of any size are decoded where they lie. Only the bytes of an
+ * instruction cut off by the end of a chunk are copied, at most 3 of them,
+ * and they are completed from the start of the next chunk. Instructions are
+ * gathered into a batch of fixed size that is passed to a callback whenever
+ * it fills, so memory use doesn't grow with the length of the stream. */
+
+/* Receives `count` decoded instructions, with `pc` set from the base PC of
+ * the stream. The array is reused for the next batch once this returns. */
+typedef void (*riscv_emit_fn)(void *ctx, const struct riscv_insn *insns,
+    size_t count);
+
+struct riscv_stream;
+
+/* Returns a stream whose first byte is at `base_pc`, emitting batches of
+ * `batch` instructions decoded with `dec`, or for the profile of config.h if
+ * it's NULL. Returns NULL if `batch` is 0 or memory runs out. */
+struct riscv_stream *riscv_stream_create(size_t batch,
+    const struct riscv_decoder *dec, uint64_t base_pc, riscv_emit_fn emit,
+    void *ctx);
+void riscv_stream_destroy(struct riscv_stream *stream);
+
+/* Decodes the next `len` bytes of the stream. Full batches are emitted
+ * before this returns, the rest is held until the batch fills or
+ * riscv_stream_flush() is called. */
+void riscv_stream_feed(struct riscv_stream *stream, const uint8_t *data,
+    size_t len);
+
+/* Emits the instructions decoded so far, if any. Returns how many bytes of a
+ * partial instruction are still held waiting for the rest of it, which at
+ * the end of the stream is a truncated instruction. */
+size_t riscv_stream_flush(struct riscv_stream *stream);
+
+/* PC of the next instruction to be decoded. */
+uint64_t riscv_stream_pc(const struct riscv_stream *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_STREAM_H
@@ -0,0 +1,65 @@
+#ifndef RISCV_TRACE_H
+#define RISCV_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <rvdec/decode.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Decoder for binary commit traces, such as those written by RTL simulation,
+ * made of fixed-size records of one retired instruction each.
+ *
+ * A record holds the PC as a little-endian 64-bit value at
+ * RISCV_TRACE_PC_OFFSET and the instruction as a little-endian 32-bit value
+ * at RISCV_TRACE_INSN_OFFSET, with compressed instructions in its low
+ * halfword. Records may be longer than RISCV_TRACE_MIN_RECORD bytes and hold
+ * other fields past these.
+ *
+ * Traces repeat a small set of words over and over, so each thread keeps
+ * the decoded operands of the words it has seen in a 2-way set associative
+ * cache like riscv_decode_cache, and mostly decodes each word once. */
+
+#define RISCV_TRACE_PC_OFFSET 0
+#define RISCV_TRACE_INSN_OFFSET 8
+#define RISCV_TRACE_MIN_RECORD 12
+
+struct riscv_trace {
+  const uint8_t *data;
+  size_t size;
+  size_t record_size;
+  // Whole records in `data`, a partial one at the end is ignored
+  size_t nrecords;
+
+  bool mapped;
+};
+
+/* Maps the trace file at `path`. Returns 1 on success and 0 if the file can't
+ * be mapped or `record_size` is less than RISCV_TRACE_MIN_RECORD. */
+int riscv_trace_open(struct riscv_trace *trace, const char *path,
+    size_t record_size);
+
+/* Same as riscv_trace_open() for a trace already in memory, which must
+ * outlive `trace`. */
+int riscv_trace_init(struct riscv_trace *trace, const void *data,
+    size_t size, size_t record_size);
+
+void riscv_trace_close(struct riscv_trace *trace);
+
+/* Decodes `count` records of `trace` starting at record `first`, as
+ * riscv_decoder_decode_buffer() with `dec` or riscv_decode_buffer() if it's
+ * NULL would, on up to `threads` threads. Record i goes to element
+ * i - `first` of `pc` and of each array of `out`. Returns the number of
+ * records decoded, less than `count` if the trace ends first. */
+size_t riscv_trace_decode(const struct riscv_trace *trace, size_t first,
+    size_t count, const struct riscv_decoder *dec, uint64_t *pc,
+    const struct riscv_insn_soa *out, unsigned threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_TRACE_H
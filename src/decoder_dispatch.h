@@ -0,0 +1,289 @@
+#ifndef DECODER_DISPATCH_H
+#define DECODER_DISPATCH_H
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#include "riscv_operands.h"
+#include "riscv_stats.h"
+
+/* Single-lookup dispatch for 32-bit instructions.
+ *
+ * The table is indexed by opcode[6:2] (opcode[1:0] is always 0b11 for 32-bit
+ * encodings) and funct3. Each entry names the operand-extraction routine and
+ * holds the decoded kind for each class of funct7 value, so that resolving
+ * `repr` to its kind takes two loads instead of walking the per-set hooks.
+ *
+ * The tables are generated by insn_table_gen from the mask/match encodings
+ * of insn_set_defs/, tried in the order the `riscv_decode_rv*` hooks used to
+ * be (RV64I, RV32I, RV64M, RV32M). The table of config.h keeps the few
+ * fields those hooks didn't check, see `dispatch_leniencies` there, while
+ * the runtime-selectable ones check funct3 and funct7 exactly. There is one
+ * table per ISA profile holding only the sets of the profile, so the
+ * profile costs nothing at decode time. */
+
+enum riscv_dispatch_format {
+  DISPATCH_NONE,
+  DISPATCH_R,
+  DISPATCH_I,
+  DISPATCH_I_SHAMT_RV32,
+  DISPATCH_I_SHAMT_RV64,
+  DISPATCH_S,
+  DISPATCH_B,
+  DISPATCH_U,
+  DISPATCH_J,
+  // FENCE when rd and rs1 are zero, otherwise decoded as DISPATCH_SYSTEM
+  DISPATCH_FENCE,
+  // ECALL or EBREAK, selected by imm[6:0]
+  DISPATCH_SYSTEM,
+  // Same as DISPATCH_FENCE and DISPATCH_SYSTEM for the runtime-selectable
+  // profiles, which also need the fields riscv_decode() leaves unchecked
+  DISPATCH_FENCE_EXACT,
+  DISPATCH_SYSTEM_EXACT
+};
+
+enum riscv_funct7_class {
+  FUNCT7_OTHER,
+  FUNCT7_0000000,
+  FUNCT7_0100000,
+  FUNCT7_0000001,
+  // SRAI with shamt[5] set on RV64
+  FUNCT7_0100001,
+  FUNCT7_CLASSES
+};
+
+static const uint8_t FUNCT7_CLASS_TABLE[128] = {
+  [0b0000000] = FUNCT7_0000000,
+  [0b0100000] = FUNCT7_0100000,
+  [0b0000001] = FUNCT7_0000001,
+  [0b0100001] = FUNCT7_0100001
+};
+
+struct riscv_dispatch_entry {
+  uint8_t format;
+  // Indexed by `enum riscv_funct7_class`
+  uint8_t kind[FUNCT7_CLASSES];
+};
+
+/* The table of the profile selected in config.h, used by riscv_decode() and
+ * the other entry points that don't take a `struct riscv_decoder`. */
+extern const struct riscv_dispatch_entry riscv_dispatch_table[32][8];
+
+/* Tables of the runtime-selectable profiles. Unlike the table of config.h,
+ * RV32 profiles don't accept RV64-only encodings. */
+extern const struct riscv_dispatch_entry riscv_dispatch_rv32i[32][8];
+extern const struct riscv_dispatch_entry riscv_dispatch_rv32im[32][8];
+extern const struct riscv_dispatch_entry riscv_dispatch_rv64i[32][8];
+extern const struct riscv_dispatch_entry riscv_dispatch_rv64im[32][8];
+
+/* Runs the operand-extraction routine chosen by a dispatch table entry.
+ * Returns 1 if the instruction was stored to `insn` and 0 otherwise. */
+static inline int riscv_dispatch_extract(struct riscv_insn *insn, int format,
+    int kind, uint32_t repr) {
+  uint32_t opcode = repr & 0b1111111;
+  switch (format) {
+    case DISPATCH_R:
+      riscv_decode_r(insn, kind, repr, opcode);
+      return 1;
+    case DISPATCH_I:
+      riscv_decode_i(insn, kind, repr, opcode);
+      return 1;
+    case DISPATCH_I_SHAMT_RV32:
+      riscv_decode_i_shamt(insn, kind, repr, opcode, 5);
+      return 1;
+    case DISPATCH_I_SHAMT_RV64:
+      riscv_decode_i_shamt(insn, kind, repr, opcode, 6);
+      return 1;
+    case DISPATCH_S:
+      riscv_decode_s(insn, kind, repr, opcode);
+      return 1;
+    case DISPATCH_B:
+      riscv_decode_b(insn, kind, repr, opcode);
+      return 1;
+    case DISPATCH_U:
+      riscv_decode_u(insn, kind, repr, opcode);
+      return 1;
+    case DISPATCH_J:
+      riscv_decode_j(insn, kind, repr, opcode);
+      return 1;
+    case DISPATCH_FENCE:
+      if (riscv_try_decode_fence(insn, repr, opcode)) {
+        return 1;
+      }
+      // Not a FENCE, try ECALL/EBREAK just like the RV32I hook does
+      // fallthrough
+    case DISPATCH_SYSTEM: {
+      uint32_t funct7 = (repr >> 20) & 0b1111111;
+      if (funct7 == 0) {
+        riscv_decode_i(insn, RVINSN_ECALL, repr, opcode);
+        return 1;
+      } else if (funct7 == 1) {
+        riscv_decode_i(insn, RVINSN_EBREAK, repr, opcode);
+        return 1;
+      }
+      break;
+    }
+    case DISPATCH_FENCE_EXACT:
+      return riscv_try_decode_fence(insn, repr, opcode);
+    case DISPATCH_SYSTEM_EXACT:
+      // rd, funct3, rs1 and imm[11:1] are zero, imm[0] tells EBREAK
+      if ((repr & 0xffefff80) != 0) {
+        break;
+      }
+      riscv_decode_i(insn, (repr >> 20) ? RVINSN_EBREAK : RVINSN_ECALL, repr,
+          opcode);
+      return 1;
+  }
+  return 0;
+}
+
+/* Decodes `repr` as a 32-bit instruction of the profile whose dispatch table is
+ * `table` only, without trying the compressed encodings. Returns the kind or
+ * RVINSN_ILLEGAL. */
+static inline int riscv_decode32_with(struct riscv_insn *insn, uint32_t repr,
+    const struct riscv_dispatch_entry (*table)[8]) {
+  if ((repr & 0b11) == 0b11) {
+    const struct riscv_dispatch_entry *entry =
+      &table[(repr >> 2) & 0b11111][(repr >> 12) & 0b111];
+    int kind = entry->kind[FUNCT7_CLASS_TABLE[repr >> 25]];
+    RISCV_STATS_DISPATCH(repr);
+    if (kind != RVINSN_ILLEGAL
+        && riscv_dispatch_extract(insn, entry->format, kind, repr)) {
+      insn->is_compressed = false;
+      insn->length = 4;
+      return insn->kind;
+    }
+    RISCV_STATS_DISPATCH_FAILED(repr);
+  }
+  return RVINSN_ILLEGAL;
+}
+
+/* Same as riscv_decode32_with() for the profile selected in config.h. */
+static inline int riscv_decode32(struct riscv_insn *insn, uint32_t repr) {
+  return riscv_decode32_with(insn, repr, riscv_dispatch_table);
+}
+
+/* Decodes the instruction at the start of `buf`, `len` bytes long, to `insn`
+ * for the profile with dispatch table `table` and compressed instruction table
+ * `rvc`, NULL if the profile has no compressed instructions. Encodings that
+ * don't decode are stored as RVINSN_ILLEGAL of the length their low bits
+ * tell. Returns that length, or 0 if `buf` ends within the instruction. */
+static inline size_t riscv_decode_next_with(const uint8_t *buf, size_t len,
+    struct riscv_insn *insn, const struct riscv_dispatch_entry (*table)[8],
+    const struct riscv_insn *rvc) {
+  if (len < 2) {
+    return 0;
+  }
+  uint32_t repr = buf[0] | (buf[1] << 8);
+
+  // The low two bits of the first halfword tell the instruction length,
+  // whether or not the rest of the encoding is legal. The length is returned
+  // as a constant so the walk doesn't wait on the stores to `insn`.
+  if ((repr & 0b11) == 0b11) {
+    if (len < 4) {
+      return 0;
+    }
+    repr |= (uint32_t)(buf[2] | (buf[3] << 8)) << 16;
+    if (riscv_decode32_with(insn, repr, table) == RVINSN_ILLEGAL) {
+      insn->type = INSN_UNDEFINED;
+      insn->kind = RVINSN_ILLEGAL;
+      insn->is_compressed = false;
+      insn->length = 4;
+    }
+    RISCV_STATS_KIND(insn->kind);
+    return 4;
+  }
+
+  if (rvc) {
+    *insn = rvc[repr];
+    RISCV_STATS_RVC(repr, insn->kind);
+  } else {
+    insn->type = INSN_UNDEFINED;
+    insn->kind = RVINSN_ILLEGAL;
+    insn->is_compressed = false;
+    insn->length = 2;
+  }
+  RISCV_STATS_KIND(insn->kind);
+  return 2;
+}
+
+/* riscv_decode_buffer() for the profile of riscv_decode_next_with(). */
+static inline size_t riscv_decode_buffer_with(const uint8_t *buf, size_t len,
+    uint64_t base_pc, struct riscv_insn *out, size_t cap,
+    const struct riscv_dispatch_entry (*table)[8],
+    const struct riscv_insn *rvc) {
+  size_t offset = 0;
+  size_t count = 0;
+
+  while (count < cap) {
+    struct riscv_insn *insn = &out[count];
+    size_t length = riscv_decode_next_with(buf + offset, len - offset, insn,
+        table, rvc);
+    if (length == 0) {
+      break;
+    }
+    insn->pc = base_pc + offset;
+    offset += length;
+    ++count;
+  }
+
+  return count;
+}
+
+/* riscv_decode_block() for the profile of riscv_decode_next_with(). */
+static inline size_t riscv_decode_block_with(const uint8_t *buf, size_t len,
+    uint64_t base_pc, struct riscv_insn *out, size_t cap,
+    struct riscv_block *block, const struct riscv_dispatch_entry (*table)[8],
+    const struct riscv_insn *rvc) {
+  size_t offset = 0;
+  size_t count = 0;
+
+  block->end = RISCV_BLOCK_TRUNCATED;
+  block->terminator = RVINSN_ILLEGAL;
+  block->indirect = false;
+  block->target_pc = 0;
+
+  while (count < cap) {
+    struct riscv_insn *insn = &out[count];
+    size_t length = riscv_decode_next_with(buf + offset, len - offset, insn,
+        table, rvc);
+    if (length == 0) {
+      break;
+    }
+    uint64_t pc = base_pc + offset;
+    insn->pc = pc;
+    offset += length;
+    ++count;
+
+    uint32_t flags = riscv_kind_flags[insn->kind];
+    if (!(flags & (RISCV_FLAG_BRANCH | RISCV_FLAG_JUMP | RISCV_FLAG_SYSTEM
+            | RISCV_FLAG_ILLEGAL))) {
+      continue;
+    }
+    if (flags & RISCV_FLAG_INDIRECT) {
+      block->end = RISCV_BLOCK_JUMP;
+      block->indirect = true;
+    } else if (flags & (RISCV_FLAG_BRANCH | RISCV_FLAG_JUMP)) {
+      struct riscv_operands ops;
+      riscv_operands_of(insn, &ops);
+      block->end = flags & RISCV_FLAG_JUMP ? RISCV_BLOCK_JUMP
+                                           : RISCV_BLOCK_BRANCH;
+      block->target_pc = pc + (int64_t)ops.imm;
+    } else if (flags & RISCV_FLAG_SYSTEM) {
+      block->end = RISCV_BLOCK_TRAP;
+    } else {
+      block->end = RISCV_BLOCK_ILLEGAL;
+    }
+    block->terminator = insn->kind;
+    break;
+  }
+
+  block->count = count;
+  block->length = offset;
+  block->fallthrough_pc = base_pc + offset;
+  return count;
+}
+
+#endif // DECODER_DISPATCH_H
@@ -6,35 +6,6 @@
 
 #include "decoder_hooks_def.h"
 
-struct decoder_hooks {
-  /* Hooks must return 1 if instruction is identified, parsed and stored to `insn`
-   * and 0 if it's undefined */
-  int (*riscv_decode_r)(struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
-  int (*riscv_decode_i)(struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
-  int (*riscv_decode_s)(struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
-  int (*riscv_decode_b)(struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
-  int (*riscv_decode_u)(struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
-  int (*riscv_decode_j)(struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
-};
-
-struct decoder_hooks decoder_hooks[] = {
-#ifdef SUPPORT_RV64I
-  RV64I_HOOKS_INIT,
-#endif
-
-#if defined(SUPPORT_RV32I) || defined(SUPPORT_RV64I)
-  RV32I_HOOKS_INIT,
-#endif
-
-#ifdef SUPPORT_RV64M
-  RV64M_HOOKS_INIT,
-#endif
-
-#if defined(SUPPORT_RV32M) || defined(SUPPORT_RV64M)
-  RV32M_HOOKS_INIT,
-#endif
-};
-
 #ifdef SUPPORT_COMPRESSED
 
 // Hooks for 16-bit compressed instructions
@@ -52,14 +23,15 @@ struct decoder_hooks16 {
   int (*rvc_decode_cj) (struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
 };
 
-struct decoder_hooks16 decoder_hooks16[] = {
-#if  defined(SUPPORT_RV64I)
+/* Hooks of each XLEN profile in the order they are tried. RV64 tries its own
+ * encodings before falling back to the ones shared with RV32. */
+static const struct decoder_hooks16 decoder_hooks16_rv64[] = {
   RVC_HOOKS_INIT_RV64,
-#endif
+  RVC_HOOKS_INIT_RV32
+};
 
-#if defined(SUPPORT_RV32I) || defined(SUPPORT_RV64I)
+static const struct decoder_hooks16 decoder_hooks16_rv32[] = {
   RVC_HOOKS_INIT_RV32
-#endif
 };
 
 #endif // SUPPORT_COMPRESSED
@@ -0,0 +1,77 @@
+#ifndef INSN_TABLE_H
+#define INSN_TABLE_H
+
+#include <rvdec/instruction.h>
+
+#include "decoder_dispatch.h"
+
+/* Exact decoder, generated at build time by insn_table_gen from the
+ * mask/match encodings of insn_set_defs/.
+ *
+ * opcode[6:2] and funct3 select a row of `riscv_exact_cells`, which is indexed
+ * by funct7 and gives the offset of a run of candidates in
+ * `riscv_exact_candidates`. The candidates are in the order the decoder hooks
+ * used to be tried and the run ends in an RVINSN_ILLEGAL entry that matches
+ * any word, so the instruction is the first candidate with
+ * `(repr & mask) == match`. Most runs hold a single candidate. */
+
+struct riscv_exact_candidate {
+  uint32_t mask;
+  uint32_t match;
+  uint8_t kind;
+  // enum riscv_dispatch_format
+  uint8_t format;
+};
+
+// Indexed by opcode[6:2] << 3 | funct3
+extern const uint8_t riscv_exact_rows[256];
+extern const uint16_t riscv_exact_cells[][128];
+extern const struct riscv_exact_candidate riscv_exact_candidates[];
+
+/* Assembler syntax of the operands of a kind, as riscv_format() writes them,
+ * derived from the format and opcode of its encoding. */
+enum riscv_syntax {
+  SYNTAX_NONE,
+  // rd,rs1,rs2
+  SYNTAX_R,
+  // rd,rs1,imm in decimal
+  SYNTAX_I,
+  // rd,rs1,shamt in hex
+  SYNTAX_SHIFT,
+  // rd,imm(rs1), loads and JALR
+  SYNTAX_LOAD,
+  // rs2,imm(rs1)
+  SYNTAX_STORE,
+  // rs1,rs2,target
+  SYNTAX_BRANCH,
+  // rd,imm[31:12] in hex
+  SYNTAX_U,
+  // rd,target
+  SYNTAX_JUMP,
+  // pred,succ
+  SYNTAX_FENCE
+};
+
+/* Lowercase mnemonic of each kind and of RVINSN_ILLEGAL, NUL-padded so it
+ * can be copied as a whole. */
+struct riscv_mnemonic {
+  char name[8];
+  uint8_t length;
+  // enum riscv_syntax
+  uint8_t syntax;
+};
+
+extern const struct riscv_mnemonic riscv_mnemonics[RVINSN_ILLEGAL + 1];
+
+/* Bit positions of rd, rs1 and rs2 in the 32-bit operand union of struct
+ * riscv_insn for each `enum InstructionType`, as laid out by the compiler
+ * that built insn_table_gen. 0 where the format lacks the field. */
+enum riscv_slot_field {
+  SLOT_FIELD_RD,
+  SLOT_FIELD_RS1,
+  SLOT_FIELD_RS2
+};
+
+extern const uint8_t riscv_slot_shifts[INSN_FENCE + 1][3];
+
+#endif // INSN_TABLE_H
@@ -0,0 +1,744 @@
+/* Build-time generator of the instruction tables declared in insn_table.h
+ * and decoder_dispatch.h and of `riscv_encodings`. Reads the mask/match
+ * encodings of insn_set_defs/ and emits the dispatch tables of each
+ * profile, the exact decoder's tables, the formatter's mnemonics and the
+ * flags and register slots of each kind as constant C arrays. */
+
+#include "config.h"
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rvdec/instruction.h>
+
+#include "decoder_dispatch.h"
+#include "insn_table.h"
+
+struct def_entry {
+  int kind;
+  int type;
+  uint32_t mask;
+  uint32_t match;
+};
+
+#define INSN(insn, type, mask, match) { RVINSN_##insn, type, mask, match },
+#define INSN_REDECL INSN
+#define CUSTOM_ABI_INSN INSN
+
+static const struct def_entry defs_rv32i[] = {
+#include <rvdec/insn_set_defs/rv32i.def>
+};
+static const struct def_entry defs_rv64i[] = {
+#include <rvdec/insn_set_defs/rv64i.def>
+};
+static const struct def_entry defs_rv32m[] = {
+#include <rvdec/insn_set_defs/rv32m.def>
+};
+static const struct def_entry defs_rv64m[] = {
+#include <rvdec/insn_set_defs/rv64m.def>
+};
+
+#undef CUSTOM_ABI_INSN
+#undef INSN_REDECL
+#undef INSN
+
+#define COUNT(array) (sizeof(array) / sizeof(*array))
+
+struct def_set {
+  const struct def_entry *defs;
+  size_t count;
+  int set;
+};
+
+// Order in which the sets declare their kinds
+static const struct def_set def_sets[] = {
+  { defs_rv32i, COUNT(defs_rv32i), RISCV_SET_RV32I },
+  { defs_rv64i, COUNT(defs_rv64i), RISCV_SET_RV64I },
+  { defs_rv32m, COUNT(defs_rv32m), RISCV_SET_RV32M },
+  { defs_rv64m, COUNT(defs_rv64m), RISCV_SET_RV64M },
+};
+
+// Sets enabled in config.h, in the order the decoder hooks used to be tried
+static const struct def_set decode_sets[] = {
+#ifdef SUPPORT_RV64I
+  { defs_rv64i, COUNT(defs_rv64i), RISCV_SET_RV64I },
+#endif
+#if defined(SUPPORT_RV32I) || defined(SUPPORT_RV64I)
+  { defs_rv32i, COUNT(defs_rv32i), RISCV_SET_RV32I },
+#endif
+#ifdef SUPPORT_RV64M
+  { defs_rv64m, COUNT(defs_rv64m), RISCV_SET_RV64M },
+#endif
+#if defined(SUPPORT_RV32M) || defined(SUPPORT_RV64M)
+  { defs_rv32m, COUNT(defs_rv32m), RISCV_SET_RV32M },
+#endif
+};
+
+// Sets of the runtime-selectable profiles of riscv_decoder_init(), tried in
+// the same order. RV32 profiles don't accept RV64-only encodings.
+static const struct def_set profile_rv32i[] = {
+  { defs_rv32i, COUNT(defs_rv32i), RISCV_SET_RV32I },
+};
+static const struct def_set profile_rv32im[] = {
+  { defs_rv32i, COUNT(defs_rv32i), RISCV_SET_RV32I },
+  { defs_rv32m, COUNT(defs_rv32m), RISCV_SET_RV32M },
+};
+static const struct def_set profile_rv64i[] = {
+  { defs_rv64i, COUNT(defs_rv64i), RISCV_SET_RV64I },
+  { defs_rv32i, COUNT(defs_rv32i), RISCV_SET_RV32I },
+};
+static const struct def_set profile_rv64im[] = {
+  { defs_rv64i, COUNT(defs_rv64i), RISCV_SET_RV64I },
+  { defs_rv32i, COUNT(defs_rv32i), RISCV_SET_RV32I },
+  { defs_rv64m, COUNT(defs_rv64m), RISCV_SET_RV64M },
+  { defs_rv32m, COUNT(defs_rv32m), RISCV_SET_RV32M },
+};
+
+struct dispatch_profile {
+  const char *name;
+  const struct def_set *sets;
+  size_t count;
+  // Whether `dispatch_leniencies` leave some fields unchecked
+  int lenient;
+};
+
+static const struct dispatch_profile dispatch_profiles[] = {
+  { "riscv_dispatch_table", decode_sets, COUNT(decode_sets), 1 },
+  { "riscv_dispatch_rv32i", profile_rv32i, COUNT(profile_rv32i), 0 },
+  { "riscv_dispatch_rv32im", profile_rv32im, COUNT(profile_rv32im), 0 },
+  { "riscv_dispatch_rv64i", profile_rv64i, COUNT(profile_rv64i), 0 },
+  { "riscv_dispatch_rv64im", profile_rv64im, COUNT(profile_rv64im), 0 },
+};
+
+/* Fields that riscv_decode() doesn't check for some encodings, as the
+ * decoder hooks it replaced didn't either. Only the table of config.h
+ * leaves them unchecked, riscv_decode_exact() and the runtime-selectable
+ * profiles check all of them. `format` replaces the one of the encoding
+ * unless DISPATCH_NONE, in every table. */
+struct dispatch_leniency {
+  int set;
+  int kind;
+  uint32_t unchecked;
+  int format;
+};
+
+static const struct dispatch_leniency dispatch_leniencies[] = {
+  // funct3
+  { RISCV_SET_RV32I, RVINSN_JALR, 0x00007000, DISPATCH_NONE },
+  // funct3, DISPATCH_FENCE checks rd and rs1 itself
+  { RISCV_SET_RV32I, RVINSN_FENCE, 0x00007000, DISPATCH_NONE },
+  // funct3 and imm[11:5], DISPATCH_SYSTEM checks imm[6:0] itself
+  { RISCV_SET_RV32I, RVINSN_ECALL, 0xfe007000, DISPATCH_SYSTEM },
+  { RISCV_SET_RV32I, RVINSN_EBREAK, 0xfe007000, DISPATCH_SYSTEM },
+  // funct7 of the left shifts
+  { RISCV_SET_RV32I, RVINSN_SLLI, 0xfe000000, DISPATCH_NONE },
+  { RISCV_SET_RV64I, RVINSN_SLLI, 0xfe000000, DISPATCH_NONE },
+  { RISCV_SET_RV64I, RVINSN_SLLIW, 0xfe000000, DISPATCH_NONE },
+  // Any funct7 that SRLI doesn't take
+  { RISCV_SET_RV32I, RVINSN_SRAI, 0xfe000000, DISPATCH_NONE },
+};
+
+// Bits of a word that select its bucket and cell: funct7, funct3 and opcode
+#define CELL_KEY_MASK 0xfe00707fu
+
+// Upper bounds, checked as the tables are built
+#define MAX_CANDIDATES 256
+#define MAX_RUN 8
+#define MAX_RUNS 1024
+#define MAX_ROWS 256
+
+static int dispatch_format(const struct def_entry *def) {
+  switch (def->type) {
+    case INSN_R: return DISPATCH_R;
+    case INSN_S: return DISPATCH_S;
+    case INSN_B: return DISPATCH_B;
+    case INSN_U: return DISPATCH_U;
+    case INSN_J: return DISPATCH_J;
+    case INSN_FENCE: return DISPATCH_FENCE;
+    case INSN_I:
+      // Shifts fix funct7 (all of it, or its upper 6 bits on RV64) but not
+      // the shamt field below it
+      if ((def->mask & 0xfc000000) && !(def->mask & 0x01f00000)) {
+        return (def->mask & (1u << 25)) ? DISPATCH_I_SHAMT_RV32
+                                        : DISPATCH_I_SHAMT_RV64;
+      }
+      return DISPATCH_I;
+  }
+  return DISPATCH_NONE;
+}
+
+/* First encoding of `profile` whose opcode, funct3 and funct7 are those of
+ * `key`, less the fields of its leniency, or NULL. Stores the format of its
+ * dispatch table entry to `format`. */
+static const struct def_entry *dispatch_match(
+    const struct dispatch_profile *profile, uint32_t key, int *format) {
+  for (size_t s = 0; s < profile->count; ++s) {
+    const struct def_set *set = &profile->sets[s];
+    for (size_t i = 0; i < set->count; ++i) {
+      const struct def_entry *def = &set->defs[i];
+      uint32_t mask = def->mask & CELL_KEY_MASK;
+      *format = dispatch_format(def);
+      for (size_t l = 0; l < COUNT(dispatch_leniencies); ++l) {
+        const struct dispatch_leniency *leniency = &dispatch_leniencies[l];
+        if (leniency->set == set->set && leniency->kind == def->kind) {
+          if (profile->lenient) {
+            mask &= ~leniency->unchecked;
+          }
+          if (leniency->format != DISPATCH_NONE) {
+            *format = leniency->format;
+          }
+        }
+      }
+      if (((key ^ def->match) & mask) == 0) {
+        if (!profile->lenient && *format == DISPATCH_FENCE) {
+          *format = DISPATCH_FENCE_EXACT;
+        } else if (!profile->lenient && *format == DISPATCH_SYSTEM) {
+          *format = DISPATCH_SYSTEM_EXACT;
+        }
+        return def;
+      }
+    }
+  }
+  *format = DISPATCH_NONE;
+  return NULL;
+}
+
+/* Format of an entry with encodings of formats `a` and `b`, or -1 if they
+ * can't share one. The shifts of RV32I and RV64I share the RV32I width, as
+ * riscv_decode_i_shamt() keeps one bit more than it's asked for, which is
+ * shamt[5] on RV64. */
+static int merge_format(int a, int b) {
+  if (a == DISPATCH_NONE || a == b) {
+    return b;
+  }
+  if (b == DISPATCH_NONE) {
+    return a;
+  }
+  if ((a == DISPATCH_I_SHAMT_RV32 || a == DISPATCH_I_SHAMT_RV64)
+      && (b == DISPATCH_I_SHAMT_RV32 || b == DISPATCH_I_SHAMT_RV64)) {
+    return DISPATCH_I_SHAMT_RV32;
+  }
+  return -1;
+}
+
+/* Builds the entry of `profile` for opcode[6:2] `row` and `funct3`. Each
+ * funct7 class has to decode to a single kind for all its funct7 values. */
+static int build_dispatch_entry(const struct dispatch_profile *profile,
+    uint32_t row, uint32_t funct3, struct riscv_dispatch_entry *entry) {
+  int kinds[FUNCT7_CLASSES];
+  int format = DISPATCH_NONE;
+  for (int c = 0; c < FUNCT7_CLASSES; ++c) {
+    kinds[c] = -1;
+  }
+
+  for (uint32_t funct7 = 0; funct7 < 128; ++funct7) {
+    uint32_t key = (funct7 << 25) | (funct3 << 12) | (row << 2) | 0b11;
+    int def_format;
+    const struct def_entry *def = dispatch_match(profile, key, &def_format);
+    int kind = def ? def->kind : RVINSN_ILLEGAL;
+    int c = FUNCT7_CLASS_TABLE[funct7];
+    if (kinds[c] >= 0 && kinds[c] != kind) {
+      fprintf(stderr, "%s: funct7 class of %08x has several kinds\n",
+          profile->name, key);
+      return 0;
+    }
+    kinds[c] = kind;
+    if ((format = merge_format(format, def_format)) < 0) {
+      fprintf(stderr, "%s: %08x has several formats\n", profile->name, key);
+      return 0;
+    }
+  }
+
+  entry->format = format;
+  for (int c = 0; c < FUNCT7_CLASSES; ++c) {
+    entry->kind[c] = kinds[c];
+  }
+  return 1;
+}
+
+static struct riscv_dispatch_entry
+  dispatch_tables[COUNT(dispatch_profiles)][32][8];
+
+static int build_dispatch_tables(void) {
+  for (size_t i = 0; i < COUNT(dispatch_profiles); ++i) {
+    for (uint32_t row = 0; row < 32; ++row) {
+      for (uint32_t funct3 = 0; funct3 < 8; ++funct3) {
+        if (!build_dispatch_entry(&dispatch_profiles[i], row, funct3,
+              &dispatch_tables[i][row][funct3])) {
+          return 0;
+        }
+      }
+    }
+  }
+  return 1;
+}
+
+// Candidates for the decoder in the order they're tried
+static const struct def_entry *candidates[MAX_CANDIDATES];
+static size_t ncandidates;
+
+// Runs of candidate indices, each ending in -1
+static int runs[MAX_RUNS][MAX_RUN + 1];
+static size_t nruns;
+
+static int rows[MAX_ROWS][128];
+static size_t nrows;
+
+static int bucket_rows[256];
+
+static size_t run_length(const int *run) {
+  size_t n = 0;
+  while (run[n] >= 0) {
+    ++n;
+  }
+  return n;
+}
+
+static int intern_run(const int *run) {
+  size_t len = run_length(run);
+  for (size_t i = 0; i < nruns; ++i) {
+    if (run_length(runs[i]) == len
+        && memcmp(runs[i], run, len * sizeof(*run)) == 0) {
+      return i;
+    }
+  }
+  if (nruns == MAX_RUNS) {
+    fprintf(stderr, "too many candidate runs\n");
+    return -1;
+  }
+  memcpy(runs[nruns], run, (len + 1) * sizeof(*run));
+  return nruns++;
+}
+
+static int intern_row(const int *row) {
+  for (size_t i = 0; i < nrows; ++i) {
+    if (memcmp(rows[i], row, sizeof(rows[i])) == 0) {
+      return i;
+    }
+  }
+  if (nrows == MAX_ROWS) {
+    fprintf(stderr, "too many rows\n");
+    return -1;
+  }
+  memcpy(rows[nrows], row, sizeof(rows[nrows]));
+  return nrows++;
+}
+
+/* Builds the run of candidates that can match words whose key fields are
+ * those of `key`. Candidates whose whole mask is covered by the key match
+ * every such word, so the run stops at the first of them. */
+static int build_cell(uint32_t key) {
+  int run[MAX_RUN + 1];
+  size_t len = 0;
+  for (size_t i = 0; i < ncandidates; ++i) {
+    const struct def_entry *def = candidates[i];
+    if (((key ^ def->match) & def->mask & CELL_KEY_MASK) != 0) {
+      continue;
+    }
+    if (len == MAX_RUN) {
+      fprintf(stderr, "too many candidates for %08x\n", key);
+      return -1;
+    }
+    run[len++] = i;
+    if ((def->mask & ~CELL_KEY_MASK) == 0) {
+      break;
+    }
+  }
+  run[len] = -1;
+  return intern_run(run);
+}
+
+static int build_tables(void) {
+  for (size_t s = 0; s < COUNT(decode_sets); ++s) {
+    for (size_t i = 0; i < decode_sets[s].count; ++i) {
+      if (ncandidates == MAX_CANDIDATES) {
+        fprintf(stderr, "too many candidates\n");
+        return 0;
+      }
+      candidates[ncandidates++] = &decode_sets[s].defs[i];
+    }
+  }
+
+  // The empty run comes first, so unassigned encodings share its sentinel
+  int empty[1] = { -1 };
+  intern_run(empty);
+
+  for (uint32_t bucket = 0; bucket < 256; ++bucket) {
+    int row[128];
+    for (uint32_t funct7 = 0; funct7 < 128; ++funct7) {
+      uint32_t key = (funct7 << 25) | ((bucket & 0b111) << 12)
+        | ((bucket >> 3) << 2) | 0b11;
+      if ((row[funct7] = build_cell(key)) < 0) {
+        return 0;
+      }
+    }
+    if ((bucket_rows[bucket] = intern_row(row)) < 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void emit_encodings(FILE *out) {
+  struct riscv_encoding encodings[RVINSN_ILLEGAL];
+  int declared[RVINSN_ILLEGAL];
+  memset(encodings, 0, sizeof(encodings));
+  memset(declared, 0, sizeof(declared));
+
+  for (size_t s = 0; s < COUNT(def_sets); ++s) {
+    for (size_t i = 0; i < def_sets[s].count; ++i) {
+      const struct def_entry *def = &def_sets[s].defs[i];
+      if (declared[def->kind]) {
+        continue;
+      }
+      declared[def->kind] = 1;
+      encodings[def->kind].mask = def->mask;
+      encodings[def->kind].match = def->match;
+      encodings[def->kind].type = def->type;
+      encodings[def->kind].set = def_sets[s].set;
+    }
+  }
+
+  fprintf(out, "const struct riscv_encoding riscv_encodings[RVINSN_ILLEGAL] = {\n");
+  for (int kind = 0; kind < RVINSN_ILLEGAL; ++kind) {
+    fprintf(out, "  /* %-7s */ { 0x%08x, 0x%08x, %u, %u },\n",
+        riscv_kind_names[kind], encodings[kind].mask, encodings[kind].match,
+        encodings[kind].type, encodings[kind].set);
+  }
+  fprintf(out, "};\n\n");
+}
+
+static int syntax(const struct def_entry *def) {
+  uint32_t opcode = def->match & 0b1111111;
+  uint32_t funct3 = (def->match >> 12) & 0b111;
+  switch (def->type) {
+    case INSN_R:
+      return SYNTAX_R;
+    case INSN_I:
+      switch (opcode) {
+        case 0b0000011:
+        case 0b1100111:
+          return SYNTAX_LOAD;
+        case 0b1110011:
+          return SYNTAX_NONE;
+        case 0b0010011:
+        case 0b0011011:
+          return funct3 == 0b001 || funct3 == 0b101 ? SYNTAX_SHIFT : SYNTAX_I;
+      }
+      return SYNTAX_I;
+    case INSN_S:
+      return SYNTAX_STORE;
+    case INSN_B:
+      return SYNTAX_BRANCH;
+    case INSN_U:
+      return SYNTAX_U;
+    case INSN_J:
+      return SYNTAX_JUMP;
+    case INSN_FENCE:
+      return SYNTAX_FENCE;
+  }
+  return SYNTAX_NONE;
+}
+
+static void emit_mnemonics(FILE *out) {
+  int syntaxes[RVINSN_ILLEGAL];
+  int declared[RVINSN_ILLEGAL];
+  memset(declared, 0, sizeof(declared));
+  for (size_t s = 0; s < COUNT(def_sets); ++s) {
+    for (size_t i = 0; i < def_sets[s].count; ++i) {
+      const struct def_entry *def = &def_sets[s].defs[i];
+      if (!declared[def->kind]) {
+        declared[def->kind] = 1;
+        syntaxes[def->kind] = syntax(def);
+      }
+    }
+  }
+
+  fprintf(out, "const struct riscv_mnemonic riscv_mnemonics[RVINSN_ILLEGAL + 1] = {\n");
+  for (int kind = 0; kind <= RVINSN_ILLEGAL; ++kind) {
+    char name[16];
+    const char *src = kind == RVINSN_ILLEGAL ? "illegal" : riscv_kind_names[kind];
+    size_t length = strlen(src);
+    for (size_t i = 0; i <= length; ++i) {
+      name[i] = tolower((unsigned char)src[i]);
+    }
+    fprintf(out, "  { \"%s\", %zu, %d },\n", name, length,
+        kind == RVINSN_ILLEGAL ? SYNTAX_NONE : syntaxes[kind]);
+  }
+  fprintf(out, "};\n\n");
+}
+
+static uint32_t kind_flags(const struct def_entry *def) {
+  uint32_t opcode = def->match & 0b1111111;
+  uint32_t funct3 = (def->match >> 12) & 0b111;
+  uint32_t funct7 = def->match >> 25;
+  uint32_t size = (funct3 & 0b11) << RISCV_FLAG_SIZE_SHIFT;
+  uint32_t flags = 0;
+  switch (opcode) {
+    case 0b1100011:
+      flags = RISCV_FLAG_BRANCH;
+      break;
+    case 0b1101111:
+      flags = RISCV_FLAG_JUMP;
+      break;
+    case 0b1100111:
+      flags = RISCV_FLAG_JUMP | RISCV_FLAG_INDIRECT;
+      break;
+    case 0b0000011:
+      flags = RISCV_FLAG_LOAD | size;
+      if (funct3 & 0b100) {
+        flags |= RISCV_FLAG_UNSIGNED;
+      }
+      break;
+    case 0b0100011:
+      flags = RISCV_FLAG_STORE | size;
+      break;
+    case 0b0001111:
+      flags = RISCV_FLAG_FENCE;
+      break;
+    case 0b1110011:
+      flags = RISCV_FLAG_SYSTEM;
+      break;
+    case 0b0011011:
+      flags = RISCV_FLAG_WORD;
+      break;
+    case 0b0111011:
+      flags = RISCV_FLAG_WORD;
+      // fallthrough
+    case 0b0110011:
+      if (funct7 == 0b0000001) {
+        flags |= funct3 < 0b100 ? RISCV_FLAG_MUL : RISCV_FLAG_DIV;
+      }
+      break;
+  }
+  return flags;
+}
+
+static void emit_kind_flags(FILE *out) {
+  uint32_t flags[RVINSN_ILLEGAL + 1];
+  int declared[RVINSN_ILLEGAL];
+  memset(declared, 0, sizeof(declared));
+  for (size_t s = 0; s < COUNT(def_sets); ++s) {
+    for (size_t i = 0; i < def_sets[s].count; ++i) {
+      const struct def_entry *def = &def_sets[s].defs[i];
+      if (!declared[def->kind]) {
+        declared[def->kind] = 1;
+        flags[def->kind] = kind_flags(def);
+      }
+    }
+  }
+  flags[RVINSN_ILLEGAL] = RISCV_FLAG_ILLEGAL;
+
+  fprintf(out, "const uint32_t riscv_kind_flags[RVINSN_ILLEGAL + 1] = {\n");
+  for (int kind = 0; kind <= RVINSN_ILLEGAL; ++kind) {
+    fprintf(out, "  /* %-7s */ 0x%05x,\n",
+        kind == RVINSN_ILLEGAL ? "ILLEGAL" : riscv_kind_names[kind],
+        flags[kind]);
+  }
+  fprintf(out, "};\n\n");
+}
+
+static void operand_slots(const struct def_entry *def,
+    struct riscv_operand_slots *slots) {
+  uint32_t opcode = def->match & 0b1111111;
+  slots->reads = 0;
+  slots->writes = 0;
+  switch (def->type) {
+    case INSN_R:
+      slots->reads = RISCV_SLOT_RS1 | RISCV_SLOT_RS2;
+      slots->writes = RISCV_SLOT_RD;
+      break;
+    case INSN_I:
+      // ECALL and EBREAK keep zero rd and rs1 fields
+      if (opcode != 0b1110011) {
+        slots->reads = RISCV_SLOT_RS1;
+        slots->writes = RISCV_SLOT_RD;
+      }
+      break;
+    case INSN_S:
+    case INSN_B:
+      slots->reads = RISCV_SLOT_RS1 | RISCV_SLOT_RS2;
+      break;
+    case INSN_U:
+    case INSN_J:
+      slots->writes = RISCV_SLOT_RD;
+      break;
+  }
+}
+
+static void emit_operand_slots(FILE *out) {
+  struct riscv_operand_slots slots[RVINSN_ILLEGAL + 1];
+  int declared[RVINSN_ILLEGAL];
+  memset(slots, 0, sizeof(slots));
+  memset(declared, 0, sizeof(declared));
+  for (size_t s = 0; s < COUNT(def_sets); ++s) {
+    for (size_t i = 0; i < def_sets[s].count; ++i) {
+      const struct def_entry *def = &def_sets[s].defs[i];
+      if (!declared[def->kind]) {
+        declared[def->kind] = 1;
+        operand_slots(def, &slots[def->kind]);
+      }
+    }
+  }
+
+  fprintf(out, "const struct riscv_operand_slots riscv_operand_slots[RVINSN_ILLEGAL + 1] = {\n");
+  for (int kind = 0; kind <= RVINSN_ILLEGAL; ++kind) {
+    fprintf(out, "  /* %-7s */ { 0x%x, 0x%x },\n",
+        kind == RVINSN_ILLEGAL ? "ILLEGAL" : riscv_kind_names[kind],
+        slots[kind].reads, slots[kind].writes);
+  }
+  fprintf(out, "};\n\n");
+}
+
+/* Position of the lowest set bit of the operand union of `insn`, in which
+ * one field was set to 1, so the table follows the bitfield layout of the
+ * compiler. Resets `insn` for the next field. */
+static int field_shift(struct riscv_insn *insn) {
+  uint32_t word;
+  memcpy(&word, (const char *)insn + offsetof(struct riscv_insn, r),
+      sizeof(word));
+  memset(insn, 0, sizeof(*insn));
+  int shift = 0;
+  while (word != 0 && !(word & 1)) {
+    word >>= 1;
+    ++shift;
+  }
+  return shift;
+}
+
+static void emit_slot_shifts(FILE *out) {
+  int shifts[INSN_FENCE + 1][3];
+  struct riscv_insn insn;
+  memset(shifts, 0, sizeof(shifts));
+  memset(&insn, 0, sizeof(insn));
+#define SHIFT(type, member, field, slot) \
+  insn.member.field = 1; \
+  shifts[type][slot] = field_shift(&insn)
+  SHIFT(INSN_R, r, rd, SLOT_FIELD_RD);
+  SHIFT(INSN_R, r, rs1, SLOT_FIELD_RS1);
+  SHIFT(INSN_R, r, rs2, SLOT_FIELD_RS2);
+  SHIFT(INSN_I, i, rd, SLOT_FIELD_RD);
+  SHIFT(INSN_I, i, rs1, SLOT_FIELD_RS1);
+  SHIFT(INSN_S, s, rs1, SLOT_FIELD_RS1);
+  SHIFT(INSN_S, s, rs2, SLOT_FIELD_RS2);
+  SHIFT(INSN_B, b, rs1, SLOT_FIELD_RS1);
+  SHIFT(INSN_B, b, rs2, SLOT_FIELD_RS2);
+  SHIFT(INSN_U, u, rd, SLOT_FIELD_RD);
+  SHIFT(INSN_J, j, rd, SLOT_FIELD_RD);
+  SHIFT(INSN_FENCE, fence, rd, SLOT_FIELD_RD);
+  SHIFT(INSN_FENCE, fence, rs1, SLOT_FIELD_RS1);
+#undef SHIFT
+
+  fprintf(out, "const uint8_t riscv_slot_shifts[INSN_FENCE + 1][3] = {\n");
+  for (int type = 0; type <= INSN_FENCE; ++type) {
+    fprintf(out, "  { %d, %d, %d },\n", shifts[type][SLOT_FIELD_RD],
+        shifts[type][SLOT_FIELD_RS1], shifts[type][SLOT_FIELD_RS2]);
+  }
+  fprintf(out, "};\n\n");
+}
+
+static void emit_dispatch(FILE *out) {
+  for (size_t i = 0; i < COUNT(dispatch_profiles); ++i) {
+    fprintf(out, "const struct riscv_dispatch_entry %s[32][8] = {\n",
+        dispatch_profiles[i].name);
+    for (uint32_t row = 0; row < 32; ++row) {
+      fprintf(out, "  { // opcode 0x%02x\n", (row << 2) | 0b11);
+      for (uint32_t funct3 = 0; funct3 < 8; ++funct3) {
+        const struct riscv_dispatch_entry *entry =
+          &dispatch_tables[i][row][funct3];
+        fprintf(out, "    { %d, {", entry->format);
+        for (int c = 0; c < FUNCT7_CLASSES; ++c) {
+          fprintf(out, "%s %d", c ? "," : "", entry->kind[c]);
+        }
+        fprintf(out, " } },");
+        if (entry->format != DISPATCH_NONE) {
+          fprintf(out, " //");
+          for (int c = 0; c < FUNCT7_CLASSES; ++c) {
+            fprintf(out, " %s", entry->kind[c] == RVINSN_ILLEGAL ? "ILLEGAL"
+                : riscv_kind_names[entry->kind[c]]);
+          }
+        }
+        fprintf(out, "\n");
+      }
+      fprintf(out, "  },\n");
+    }
+    fprintf(out, "};\n\n");
+  }
+}
+
+static void emit_decoder(FILE *out) {
+  // Offset of each run in the flattened candidate array
+  size_t offsets[MAX_RUNS];
+  size_t total = 0;
+  for (size_t i = 0; i < nruns; ++i) {
+    offsets[i] = total;
+    total += run_length(runs[i]) + 1;
+  }
+
+  fprintf(out, "const uint8_t riscv_exact_rows[256] = {");
+  for (int bucket = 0; bucket < 256; ++bucket) {
+    fprintf(out, "%s%d,", bucket % 16 ? " " : "\n  ", bucket_rows[bucket]);
+  }
+  fprintf(out, "\n};\n\n");
+
+  fprintf(out, "const uint16_t riscv_exact_cells[%zu][128] = {\n", nrows);
+  for (size_t row = 0; row < nrows; ++row) {
+    fprintf(out, "  {");
+    for (int funct7 = 0; funct7 < 128; ++funct7) {
+      fprintf(out, "%s%zu,", funct7 % 16 ? " " : "\n    ",
+          offsets[rows[row][funct7]]);
+    }
+    fprintf(out, "\n  },\n");
+  }
+  fprintf(out, "};\n\n");
+
+  fprintf(out, "const struct riscv_exact_candidate riscv_exact_candidates[%zu] = {\n",
+      total);
+  for (size_t i = 0; i < nruns; ++i) {
+    for (const int *c = runs[i]; *c >= 0; ++c) {
+      const struct def_entry *def = candidates[*c];
+      fprintf(out, "  /* %-7s */ { 0x%08x, 0x%08x, %d, %d },\n",
+          riscv_kind_names[def->kind], def->mask, def->match, def->kind,
+          dispatch_format(def));
+    }
+    fprintf(out, "  { 0, 0, RVINSN_ILLEGAL, DISPATCH_NONE },\n");
+  }
+  fprintf(out, "};\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s OUTPUT\n", argv[0]);
+    return 1;
+  }
+
+  if (!build_tables() || !build_dispatch_tables()) {
+    return 1;
+  }
+
+  FILE *out = fopen(argv[1], "w");
+  if (!out) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  fprintf(out, "/* Generated by insn_table_gen, do not edit. */\n\n");
+  fprintf(out, "#include \"config.h\"\n\n");
+  fprintf(out, "#include \"insn_table.h\"\n\n");
+
+  emit_dispatch(out);
+  emit_encodings(out);
+  emit_mnemonics(out);
+  emit_operand_slots(out);
+  emit_kind_flags(out);
+  emit_slot_shifts(out);
+  emit_decoder(out);
+
+  if (fclose(out) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  return 0;
+}
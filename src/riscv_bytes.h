@@ -0,0 +1,16 @@
+#ifndef RISCV_BYTES_H
+#define RISCV_BYTES_H
+
+#include <stdint.h>
+
+/* Reads the `size`-byte little-endian value at `p` byte by byte, so it works
+ * whatever the alignment of `p` and the byte order of the host. */
+static inline uint64_t riscv_read_le(const uint8_t *p, int size) {
+  uint64_t value = 0;
+  for (int i = size - 1; i >= 0; --i) {
+    value = (value << 8) | p[i];
+  }
+  return value;
+}
+
+#endif // RISCV_BYTES_H
@@ -0,0 +1,298 @@
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rvdec/corpus.h>
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+// Register use of compiled code, roughly: sp and a0 dominate, then s0,
+// a1-a5 and ra, and the upper s and t registers are rare
+static const uint32_t default_reg_weights[32] = {
+  /* zero */ 4, /* ra */ 6, /* sp */ 14, /* gp */ 1,
+  /* tp */ 1, /* t0 */ 4, /* t1 */ 4, /* t2 */ 3,
+  /* s0 */ 8, /* s1 */ 6, /* a0 */ 16, /* a1 */ 10,
+  /* a2 */ 8, /* a3 */ 6, /* a4 */ 6, /* a5 */ 8,
+  /* a6 */ 3, /* a7 */ 3, /* s2 */ 4, /* s3 */ 3,
+  /* s4 */ 3, /* s5 */ 2, /* s6 */ 2, /* s7 */ 2,
+  /* s8 */ 2, /* s9 */ 2, /* s10 */ 2, /* s11 */ 2,
+  /* t3 */ 2, /* t4 */ 2, /* t5 */ 2, /* t6 */ 2,
+};
+
+struct riscv_corpus {
+  uint64_t state;
+  enum riscv_imm_model imm_model;
+  unsigned rvc_percent;
+
+  // Running sums of the weights, searched with a uniform draw below the last
+  uint64_t kind_sums[RVINSN_ILLEGAL];
+  uint64_t reg_sums[32];
+
+  // Instruction generated but not yet written by riscv_corpus_fill()
+  bool pending;
+  unsigned pending_length;
+  uint32_t pending_word;
+
+  // Compressed words that expand to kind k are
+  // rvc_words[rvc_starts[k]] to rvc_words[rvc_starts[k + 1] - 1]
+  uint32_t rvc_starts[RVINSN_ILLEGAL + 1];
+  uint16_t rvc_words[];
+};
+
+void riscv_corpus_config_init(struct riscv_corpus_config *config) {
+  config->seed = 0;
+#ifdef SUPPORT_RV64I
+  config->xlen = 64;
+#else
+  config->xlen = 32;
+#endif
+  config->extensions = 0;
+#if defined(SUPPORT_RV64I) && defined(SUPPORT_RV64M) \
+  || !defined(SUPPORT_RV64I) && defined(SUPPORT_RV32M)
+  config->extensions |= RISCV_EXT_M;
+#endif
+#ifdef SUPPORT_COMPRESSED
+  config->extensions |= RISCV_EXT_C;
+#endif
+  config->kind_weights = NULL;
+  config->reg_weights = NULL;
+  config->imm_model = RISCV_IMM_SMALL;
+  config->rvc_percent = 50;
+}
+
+// splitmix64, to spread the seed over the state
+static uint64_t corpus_mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+// xorshift64*, the same sequence on every platform
+static uint64_t corpus_rand(struct riscv_corpus *corpus) {
+  uint64_t x = corpus->state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  corpus->state = x;
+  return x * 0x2545f4914f6cdd1dull;
+}
+
+static uint64_t corpus_below(struct riscv_corpus *corpus, uint64_t n) {
+  return corpus_rand(corpus) % n;
+}
+
+// Index of the first running sum above a uniform draw
+static unsigned corpus_pick(struct riscv_corpus *corpus, const uint64_t *sums,
+    unsigned n) {
+  uint64_t draw = corpus_below(corpus, sums[n - 1]);
+  unsigned lo = 0, hi = n - 1;
+  while (lo < hi) {
+    unsigned mid = (lo + hi) / 2;
+    if (sums[mid] > draw) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+static bool kind_in_profile(int kind, unsigned xlen, uint32_t extensions) {
+  switch (riscv_encodings[kind].set) {
+    case RISCV_SET_RV32I: return true;
+    case RISCV_SET_RV64I: return xlen == 64;
+    case RISCV_SET_RV32M: return extensions & RISCV_EXT_M;
+    case RISCV_SET_RV64M: return xlen == 64 && (extensions & RISCV_EXT_M);
+  }
+  return false;
+}
+
+struct riscv_corpus *riscv_corpus_create(const struct riscv_corpus_config *config) {
+  struct riscv_decoder dec;
+  if (!riscv_decoder_init(&dec, config->xlen, config->extensions)) {
+    return NULL;
+  }
+
+  size_t nrvc = 0;
+  if (dec.rvc) {
+    for (uint32_t w = 0; w < 1 << 16; ++w) {
+      nrvc += (w & 0b11) != 0b11 && dec.rvc[w].kind != RVINSN_ILLEGAL;
+    }
+  }
+
+  struct riscv_corpus *corpus = malloc(sizeof(*corpus)
+      + nrvc * sizeof(corpus->rvc_words[0]));
+  if (!corpus) {
+    return NULL;
+  }
+
+  corpus->state = corpus_mix(config->seed);
+  if (corpus->state == 0) {
+    corpus->state = 1;
+  }
+  corpus->imm_model = config->imm_model;
+  corpus->rvc_percent = config->rvc_percent;
+  corpus->pending = false;
+
+  uint64_t sum = 0;
+  for (int kind = 0; kind < RVINSN_ILLEGAL; ++kind) {
+    if (kind_in_profile(kind, config->xlen, config->extensions)) {
+      sum += config->kind_weights ? config->kind_weights[kind] : 1;
+    }
+    corpus->kind_sums[kind] = sum;
+  }
+  if (sum == 0) {
+    free(corpus);
+    return NULL;
+  }
+
+  const uint32_t *reg_weights = config->reg_weights
+    ? config->reg_weights : default_reg_weights;
+  sum = 0;
+  for (int reg = 0; reg < 32; ++reg) {
+    sum += reg_weights[reg];
+    corpus->reg_sums[reg] = sum;
+  }
+  if (sum == 0) {
+    free(corpus);
+    return NULL;
+  }
+
+  // Counting sort of the compressed words by the kind they expand to
+  memset(corpus->rvc_starts, 0, sizeof(corpus->rvc_starts));
+  if (dec.rvc) {
+    for (uint32_t w = 0; w < 1 << 16; ++w) {
+      if ((w & 0b11) != 0b11 && dec.rvc[w].kind != RVINSN_ILLEGAL) {
+        ++corpus->rvc_starts[dec.rvc[w].kind + 1];
+      }
+    }
+    for (int kind = 0; kind < RVINSN_ILLEGAL; ++kind) {
+      corpus->rvc_starts[kind + 1] += corpus->rvc_starts[kind];
+    }
+    uint32_t next[RVINSN_ILLEGAL];
+    memcpy(next, corpus->rvc_starts, sizeof(next));
+    for (uint32_t w = 0; w < 1 << 16; ++w) {
+      if ((w & 0b11) != 0b11 && dec.rvc[w].kind != RVINSN_ILLEGAL) {
+        corpus->rvc_words[next[dec.rvc[w].kind]++] = w;
+      }
+    }
+  }
+
+  return corpus;
+}
+
+void riscv_corpus_destroy(struct riscv_corpus *corpus) {
+  free(corpus);
+}
+
+/* Immediate of a `bits` wide field as a two's complement value the encoders
+ * below cut to the field. Small ones have their low `align` bits clear. */
+static uint32_t corpus_imm(struct riscv_corpus *corpus, unsigned bits,
+    unsigned align) {
+  if (corpus->imm_model == RISCV_IMM_UNIFORM) {
+    return (uint32_t)corpus_rand(corpus);
+  }
+  // Bit length uniform below the sign bit, a quarter of them negative
+  unsigned length = corpus_below(corpus, bits);
+  uint32_t imm = (uint32_t)corpus_rand(corpus) & ((1u << length) - 1);
+  if (corpus_below(corpus, 4) == 0) {
+    imm = -imm;
+  }
+  return imm & ~((1u << align) - 1);
+}
+
+static uint32_t corpus_reg(struct riscv_corpus *corpus) {
+  return corpus_pick(corpus, corpus->reg_sums, 32);
+}
+
+static uint32_t corpus_encode(struct riscv_corpus *corpus, int kind) {
+  const struct riscv_encoding *enc = &riscv_encodings[kind];
+  uint32_t flags = riscv_kind_flags[kind];
+  uint32_t word = corpus_reg(corpus) << 7
+    | corpus_reg(corpus) << 15
+    | corpus_reg(corpus) << 20;
+  uint32_t imm;
+
+  switch (enc->type) {
+    case INSN_I:
+      // Loads keep their offsets aligned
+      imm = corpus_imm(corpus, 12, (flags & RISCV_FLAG_SIZE_MASK)
+          >> RISCV_FLAG_SIZE_SHIFT);
+      word = (word & 0x000fffff) | imm << 20;
+      break;
+    case INSN_S:
+      imm = corpus_imm(corpus, 12, (flags & RISCV_FLAG_SIZE_MASK)
+          >> RISCV_FLAG_SIZE_SHIFT);
+      word = (word & 0x01fff07f) | (imm >> 5 & 0x7f) << 25 | (imm & 0x1f) << 7;
+      break;
+    case INSN_B:
+      imm = corpus_imm(corpus, 13, 1);
+      word = (word & 0x01fff07f) | (imm >> 12 & 1) << 31
+        | (imm >> 5 & 0x3f) << 25 | (imm >> 1 & 0xf) << 8 | (imm >> 11 & 1) << 7;
+      break;
+    case INSN_U:
+      imm = corpus_imm(corpus, 20, 0);
+      word = (word & 0x00000fff) | imm << 12;
+      break;
+    case INSN_J:
+      imm = corpus_imm(corpus, 21, 1);
+      word = (word & 0x00000fff) | (imm >> 20 & 1) << 31
+        | (imm >> 1 & 0x3ff) << 21 | (imm >> 11 & 1) << 20 | (imm >> 12 & 0xff) << 12;
+      break;
+    case INSN_FENCE:
+      // pred and succ of iorw unless drawn uniformly
+      imm = corpus->imm_model == RISCV_IMM_UNIFORM
+        ? (uint32_t)corpus_rand(corpus) & 0xff : 0xff;
+      word = (word & 0x000fffff) | imm << 20;
+      break;
+  }
+  // Fixed fields, such as funct7 of shifts, override what was drawn
+  return (word & ~enc->mask) | enc->match;
+}
+
+unsigned riscv_corpus_next(struct riscv_corpus *corpus, uint32_t *word,
+    int *kind) {
+  int k = corpus_pick(corpus, corpus->kind_sums, RVINSN_ILLEGAL);
+  if (kind) {
+    *kind = k;
+  }
+
+  uint32_t nrvc = corpus->rvc_starts[k + 1] - corpus->rvc_starts[k];
+  if (nrvc != 0 && corpus_below(corpus, 100) < corpus->rvc_percent) {
+    *word = corpus->rvc_words[corpus->rvc_starts[k] + corpus_below(corpus, nrvc)];
+    return 2;
+  }
+  *word = corpus_encode(corpus, k);
+  return 4;
+}
+
+size_t riscv_corpus_fill(struct riscv_corpus *corpus, uint8_t *buf, size_t len) {
+  size_t offset = 0;
+  for (;;) {
+    if (!corpus->pending) {
+      corpus->pending_length = riscv_corpus_next(corpus, &corpus->pending_word,
+          NULL);
+      corpus->pending = true;
+    }
+    if (len - offset < corpus->pending_length) {
+      return offset;
+    }
+    for (unsigned i = 0; i < corpus->pending_length; ++i) {
+      buf[offset++] = corpus->pending_word >> (8 * i);
+    }
+    corpus->pending = false;
+  }
+}
+
+void riscv_corpus_histogram(const struct riscv_insn *insns, size_t count,
+    uint32_t *weights) {
+  for (size_t i = 0; i < count; ++i) {
+    unsigned kind = (unsigned)insns[i].kind;
+    if (kind < RVINSN_ILLEGAL) {
+      ++weights[kind];
+    }
+  }
+}
@@ -0,0 +1,80 @@
+#include "config.h"
+
+#include <stdbool.h>
+
+#include <rvdec/dataflow.h>
+#include <rvdec/instruction.h>
+
+#include "riscv_regs.h"
+
+void riscv_block_dataflow(const struct riscv_insn *insns, size_t count,
+    struct riscv_insn_defs *defs, struct riscv_block_summary *summary) {
+  // Last writer of each register in the block and the step its value is
+  // ready at, only meaningful for registers in `def`, so blocks, which are
+  // mostly short, don't pay for clearing them
+  uint32_t writer[32];
+  uint32_t ready[32];
+
+  uint64_t use = 0, def = 0;
+  uint32_t depth = 0;
+  for (size_t i = 0; i < count; ++i) {
+    struct riscv_slot_regs regs;
+    riscv_slot_regs_of(&insns[i], &regs);
+
+    // x0 is never in `def`, so reading it adds no step. The selects keep
+    // the unwritten slots of `ready` from being read at all
+    bool written1 = (def >> regs.rs1) & 1;
+    bool written2 = (def >> regs.rs2) & 1;
+    uint32_t ready1 = written1 ? ready[regs.rs1] : 0;
+    uint32_t ready2 = written2 ? ready[regs.rs2] : 0;
+    uint32_t step = (ready1 > ready2 ? ready1 : ready2) + 1;
+    depth = step > depth ? step : depth;
+
+    if (defs) {
+      defs[i].rs1 = regs.rs1 == 0 ? RISCV_DEF_NONE
+        : written1 ? writer[regs.rs1] : RISCV_DEF_LIVE_IN;
+      defs[i].rs2 = regs.rs2 == 0 ? RISCV_DEF_NONE
+        : written2 ? writer[regs.rs2] : RISCV_DEF_LIVE_IN;
+    }
+
+    uint64_t read = ((uint64_t)1 << regs.rs1 | (uint64_t)1 << regs.rs2)
+      & ~(uint64_t)1;
+    use |= read & ~def;
+    // Writes to x0 land in the unused slots 0 and are dropped from `def`
+    writer[regs.rd] = i;
+    ready[regs.rd] = step;
+    def |= ((uint64_t)1 << regs.rd) & ~(uint64_t)1;
+  }
+
+  summary->use = use;
+  summary->def = def;
+  summary->depth = depth;
+}
+
+unsigned riscv_liveness(const struct riscv_block_summary *summaries,
+    const uint32_t (*succs)[2], size_t nblocks, uint64_t *live_in,
+    uint64_t *live_out) {
+  for (size_t b = 0; b < nblocks; ++b) {
+    live_in[b] = 0;
+  }
+
+  unsigned passes = 0;
+  bool changed;
+  do {
+    changed = false;
+    ++passes;
+    for (size_t b = nblocks; b-- > 0;) {
+      uint64_t out = live_out[b];
+      for (int k = 0; k < 2; ++k) {
+        if (succs[b][k] != RISCV_BLOCK_NONE) {
+          out |= live_in[succs[b][k]];
+        }
+      }
+      uint64_t in = summaries[b].use | (out & ~summaries[b].def);
+      changed |= out != live_out[b] || in != live_in[b];
+      live_out[b] = out;
+      live_in[b] = in;
+    }
+  } while (changed);
+  return passes;
+}
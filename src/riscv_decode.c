@@ -1,201 +1,213 @@
 #include "config.h"
 
+#include <string.h>
+
 #include <rvdec/decode.h>
 #include <rvdec/instruction.h>
 #include <rvdec/register.h>
 
-#include "decoder_hooks.h"
-
-static const enum InstructionType OPCODE_TYPES_TABLE[] = {
-  /* 0b0000000 */ INSN_UNDEFINED,
-  /* 0b0000001 */ INSN_UNDEFINED,
-  /* 0b0000010 */ INSN_UNDEFINED,
-  /* 0b0000011 */ INSN_I,
-  /* 0b0000100 */ INSN_UNDEFINED,
-  /* 0b0000101 */ INSN_UNDEFINED,
-  /* 0b0000110 */ INSN_UNDEFINED,
-  /* 0b0000111 */ INSN_UNDEFINED,
-  /* 0b0001000 */ INSN_UNDEFINED,
-  /* 0b0001001 */ INSN_UNDEFINED,
-  /* 0b0001010 */ INSN_UNDEFINED,
-  /* 0b0001011 */ INSN_UNDEFINED,
-  /* 0b0001100 */ INSN_UNDEFINED,
-  /* 0b0001101 */ INSN_UNDEFINED,
-  /* 0b0001110 */ INSN_UNDEFINED,
-  /* 0b0001111 */ INSN_I,
-  /* 0b0010000 */ INSN_UNDEFINED,
-  /* 0b0010001 */ INSN_UNDEFINED,
-  /* 0b0010010 */ INSN_UNDEFINED,
-  /* 0b0010011 */ INSN_I,
-  /* 0b0010100 */ INSN_UNDEFINED,
-  /* 0b0010101 */ INSN_UNDEFINED,
-  /* 0b0010110 */ INSN_UNDEFINED,
-  /* 0b0010111 */ INSN_U,
-  /* 0b0011000 */ INSN_UNDEFINED,
-  /* 0b0011001 */ INSN_UNDEFINED,
-  /* 0b0011010 */ INSN_UNDEFINED,
-  /* 0b0011011 */ INSN_I,
-  /* 0b0011100 */ INSN_UNDEFINED,
-  /* 0b0011101 */ INSN_UNDEFINED,
-  /* 0b0011110 */ INSN_UNDEFINED,
-  /* 0b0011111 */ INSN_UNDEFINED,
-  /* 0b0100000 */ INSN_UNDEFINED,
-  /* 0b0100001 */ INSN_UNDEFINED,
-  /* 0b0100010 */ INSN_UNDEFINED,
-  /* 0b0100011 */ INSN_S,
-  /* 0b0100100 */ INSN_UNDEFINED,
-  /* 0b0100101 */ INSN_UNDEFINED,
-  /* 0b0100110 */ INSN_UNDEFINED,
-  /* 0b0100111 */ INSN_UNDEFINED,
-  /* 0b0101000 */ INSN_UNDEFINED,
-  /* 0b0101001 */ INSN_UNDEFINED,
-  /* 0b0101010 */ INSN_UNDEFINED,
-  /* 0b0101011 */ INSN_UNDEFINED,
-  /* 0b0101100 */ INSN_UNDEFINED,
-  /* 0b0101101 */ INSN_UNDEFINED,
-  /* 0b0101110 */ INSN_UNDEFINED,
-  /* 0b0101111 */ INSN_UNDEFINED,
-  /* 0b0110000 */ INSN_UNDEFINED,
-  /* 0b0110001 */ INSN_UNDEFINED,
-  /* 0b0110010 */ INSN_UNDEFINED,
-  /* 0b0110011 */ INSN_R,
-  /* 0b0110100 */ INSN_UNDEFINED,
-  /* 0b0110101 */ INSN_UNDEFINED,
-  /* 0b0110110 */ INSN_UNDEFINED,
-  /* 0b0110111 */ INSN_U,
-  /* 0b0111000 */ INSN_UNDEFINED,
-  /* 0b0111001 */ INSN_UNDEFINED,
-  /* 0b0111010 */ INSN_UNDEFINED,
-  /* 0b0111011 */ INSN_R,
-  /* 0b0111100 */ INSN_UNDEFINED,
-  /* 0b0111101 */ INSN_UNDEFINED,
-  /* 0b0111110 */ INSN_UNDEFINED,
-  /* 0b0111111 */ INSN_UNDEFINED,
-  /* 0b1000000 */ INSN_UNDEFINED,
-  /* 0b1000001 */ INSN_UNDEFINED,
-  /* 0b1000010 */ INSN_UNDEFINED,
-  /* 0b1000011 */ INSN_UNDEFINED,
-  /* 0b1000100 */ INSN_UNDEFINED,
-  /* 0b1000101 */ INSN_UNDEFINED,
-  /* 0b1000110 */ INSN_UNDEFINED,
-  /* 0b1000111 */ INSN_UNDEFINED,
-  /* 0b1001000 */ INSN_UNDEFINED,
-  /* 0b1001001 */ INSN_UNDEFINED,
-  /* 0b1001010 */ INSN_UNDEFINED,
-  /* 0b1001011 */ INSN_UNDEFINED,
-  /* 0b1001100 */ INSN_UNDEFINED,
-  /* 0b1001101 */ INSN_UNDEFINED,
-  /* 0b1001110 */ INSN_UNDEFINED,
-  /* 0b1001111 */ INSN_UNDEFINED,
-  /* 0b1010000 */ INSN_UNDEFINED,
-  /* 0b1010001 */ INSN_UNDEFINED,
-  /* 0b1010010 */ INSN_UNDEFINED,
-  /* 0b1010011 */ INSN_UNDEFINED,
-  /* 0b1010100 */ INSN_UNDEFINED,
-  /* 0b1010101 */ INSN_UNDEFINED,
-  /* 0b1010110 */ INSN_UNDEFINED,
-  /* 0b1010111 */ INSN_UNDEFINED,
-  /* 0b1011000 */ INSN_UNDEFINED,
-  /* 0b1011001 */ INSN_UNDEFINED,
-  /* 0b1011010 */ INSN_UNDEFINED,
-  /* 0b1011011 */ INSN_UNDEFINED,
-  /* 0b1011100 */ INSN_UNDEFINED,
-  /* 0b1011101 */ INSN_UNDEFINED,
-  /* 0b1011110 */ INSN_UNDEFINED,
-  /* 0b1011111 */ INSN_UNDEFINED,
-  /* 0b1100000 */ INSN_UNDEFINED,
-  /* 0b1100001 */ INSN_UNDEFINED,
-  /* 0b1100010 */ INSN_UNDEFINED,
-  /* 0b1100011 */ INSN_B,
-  /* 0b1100100 */ INSN_UNDEFINED,
-  /* 0b1100101 */ INSN_UNDEFINED,
-  /* 0b1100110 */ INSN_UNDEFINED,
-  /* 0b1100111 */ INSN_I,
-  /* 0b1101000 */ INSN_UNDEFINED,
-  /* 0b1101001 */ INSN_UNDEFINED,
-  /* 0b1101010 */ INSN_UNDEFINED,
-  /* 0b1101011 */ INSN_UNDEFINED,
-  /* 0b1101100 */ INSN_UNDEFINED,
-  /* 0b1101101 */ INSN_UNDEFINED,
-  /* 0b1101110 */ INSN_UNDEFINED,
-  /* 0b1101111 */ INSN_J,
-  /* 0b1110000 */ INSN_UNDEFINED,
-  /* 0b1110001 */ INSN_UNDEFINED,
-  /* 0b1110010 */ INSN_UNDEFINED,
-  /* 0b1110011 */ INSN_I,
-  /* 0b1110100 */ INSN_UNDEFINED,
-  /* 0b1110101 */ INSN_UNDEFINED,
-  /* 0b1110110 */ INSN_UNDEFINED,
-  /* 0b1110111 */ INSN_UNDEFINED,
-  /* 0b1111000 */ INSN_UNDEFINED,
-  /* 0b1111001 */ INSN_UNDEFINED,
-  /* 0b1111010 */ INSN_UNDEFINED,
-  /* 0b1111011 */ INSN_UNDEFINED,
-  /* 0b1111100 */ INSN_UNDEFINED,
-  /* 0b1111101 */ INSN_UNDEFINED,
-  /* 0b1111110 */ INSN_UNDEFINED,
-  /* 0b1111111 */ INSN_UNDEFINED
-};
+#include "decoder_dispatch.h"
+#include "insn_table.h"
+#include "riscv_operands.h"
+#include "riscv_stats.h"
+#include "rvc_table.h"
+
+#ifdef SUPPORT_COMPRESSED
+
+#ifdef SUPPORT_RV64I
+#define rvc_table rvc_table_rv64
+#else
+#define rvc_table rvc_table_rv32
+#endif
+
+/* Body of rvc_decode(), which the 32-bit entry points fall back to without
+ * counting a second decode. Leaves `pc` alone like the 32-bit decoders. */
+static inline int rvc_lookup(struct riscv_insn *insn, uint32_t repr) {
+  const struct riscv_insn *entry = &rvc_table[repr & 0xffff];
+  RISCV_STATS_RVC(repr, entry->kind);
+  if (entry->kind == RVINSN_ILLEGAL) {
+    insn->is_compressed = false;
+    return RVINSN_ILLEGAL;
+  }
+  uint64_t pc = insn->pc;
+  *insn = *entry;
+  insn->pc = pc;
+  return insn->kind;
+}
+
+#endif // SUPPORT_COMPRESSED
 
 int riscv_decode(struct riscv_insn *insn, uint32_t repr) {
-  uint32_t opcode = repr & 0b1111111;
-  switch (OPCODE_TYPES_TABLE[opcode]) {
-    case INSN_R:
-      for (int i = 0; i < sizeof(decoder_hooks) / sizeof(*decoder_hooks); ++i) {
-        if (decoder_hooks[i].riscv_decode_r(insn, repr, opcode)) {
-          return insn->kind;
-        }
-      }
-      break;
-    case INSN_I:
-      for (int i = 0; i < sizeof(decoder_hooks) / sizeof(*decoder_hooks); ++i) {
-        if (decoder_hooks[i].riscv_decode_i(insn, repr, opcode)) {
-          return insn->kind;
-        }
-      }
-      break;
-    case INSN_S:
-      for (int i = 0; i < sizeof(decoder_hooks) / sizeof(*decoder_hooks); ++i) {
-        if (decoder_hooks[i].riscv_decode_s(insn, repr, opcode)) {
-          return insn->kind;
-        }
-      }
-      break;
-    case INSN_B:
-      for (int i = 0; i < sizeof(decoder_hooks) / sizeof(*decoder_hooks); ++i) {
-        if (decoder_hooks[i].riscv_decode_b(insn, repr, opcode)) {
-          return insn->kind;
-        }
-      }
-      break;
-    case INSN_U:
-      for (int i = 0; i < sizeof(decoder_hooks) / sizeof(*decoder_hooks); ++i) {
-        if (decoder_hooks[i].riscv_decode_u(insn, repr, opcode)) {
-          return insn->kind;
-        }
-      }
-      break;
-    case INSN_J:
-      for (int i = 0; i < sizeof(decoder_hooks) / sizeof(*decoder_hooks); ++i) {
-        if (decoder_hooks[i].riscv_decode_j(insn, repr, opcode)) {
-          return insn->kind;
-        }
-      }
-      break;
+  if (riscv_decode32(insn, repr) != RVINSN_ILLEGAL) {
+    RISCV_STATS_KIND(insn->kind);
+    return insn->kind;
   }
 
 #ifdef SUPPORT_COMPRESSED
 
-  if (rvc_decode(insn, (repr >> 16) & 0xffff) != RVINSN_ILLEGAL) {
+  RISCV_STATS_RVC_FALLBACK();
+  if (rvc_lookup(insn, (repr >> 16) & 0xffff) != RVINSN_ILLEGAL) {
+    RISCV_STATS_KIND(insn->kind);
     return insn->kind;
   }
 
 #endif // SUPPORT_COMPRESSED
 
   insn->kind = RVINSN_ILLEGAL;
+  RISCV_STATS_KIND(RVINSN_ILLEGAL);
   return insn->kind;
 }
 
+int riscv_decode_exact(struct riscv_insn *insn, uint32_t repr) {
+  const struct riscv_exact_candidate *c = &riscv_exact_candidates[
+    riscv_exact_cells[riscv_exact_rows[(((repr >> 2) & 0b11111) << 3)
+      | ((repr >> 12) & 0b111)]][repr >> 25]];
+  while ((repr & c->mask) != c->match) {
+    ++c;
+  }
+
+  if ((repr & 0b11) == 0b11) {
+    RISCV_STATS_DISPATCH(repr);
+    if (c->kind != RVINSN_ILLEGAL
+        && riscv_dispatch_extract(insn, c->format, c->kind, repr)) {
+      insn->is_compressed = false;
+      insn->length = 4;
+      RISCV_STATS_KIND(insn->kind);
+      return insn->kind;
+    }
+    RISCV_STATS_DISPATCH_FAILED(repr);
+  }
+
+#ifdef SUPPORT_COMPRESSED
+
+  RISCV_STATS_RVC_FALLBACK();
+  if (rvc_lookup(insn, (repr >> 16) & 0xffff) != RVINSN_ILLEGAL) {
+    RISCV_STATS_KIND(insn->kind);
+    return insn->kind;
+  }
+
+#endif // SUPPORT_COMPRESSED
+
+  insn->kind = RVINSN_ILLEGAL;
+  RISCV_STATS_KIND(RVINSN_ILLEGAL);
+  return insn->kind;
+}
+
+/* `a` if `cond` is 1 and `b` if it's 0, by masking rather than branching. */
+static inline uint32_t riscv_select(uint32_t cond, uint32_t a, uint32_t b) {
+  uint32_t mask = -cond;
+  return (a & mask) | (b & ~mask);
+}
+
+// Instruction type of each dispatch format, DISPATCH_NONE for illegal words
+static const uint8_t BRANCHLESS_TYPES[DISPATCH_SYSTEM + 1] = {
+  [DISPATCH_NONE] = INSN_UNDEFINED,
+  [DISPATCH_R] = INSN_R,
+  [DISPATCH_I] = INSN_I,
+  [DISPATCH_I_SHAMT_RV32] = INSN_I,
+  [DISPATCH_I_SHAMT_RV64] = INSN_I,
+  [DISPATCH_S] = INSN_S,
+  [DISPATCH_B] = INSN_B,
+  [DISPATCH_U] = INSN_U,
+  [DISPATCH_J] = INSN_J,
+  [DISPATCH_FENCE] = INSN_FENCE,
+  [DISPATCH_SYSTEM] = INSN_I,
+};
+
+int riscv_decode_branchless(struct riscv_insn *insn, uint32_t repr) {
+  const struct riscv_dispatch_entry *entry =
+    &riscv_dispatch_table[(repr >> 2) & 0b11111][(repr >> 12) & 0b111];
+  uint32_t format = entry->format;
+  uint32_t entry_kind = entry->kind[FUNCT7_CLASS_TABLE[repr >> 25]];
+
+  uint32_t opcode = repr & 0b1111111;
+  uint32_t rd = (repr >> 7) & 0b11111;
+  uint32_t funct3 = (repr >> 12) & 0b111;
+  uint32_t rs1 = (repr >> 15) & 0b11111;
+  uint32_t rs2 = (repr >> 20) & 0b11111;
+
+  // FENCE needs rd and rs1 zero, other words of its opcode are decoded as
+  // SYSTEM ones, which are ECALL, EBREAK or illegal by imm[6:0]
+  uint32_t is_fence = (format == DISPATCH_FENCE) & ((rd | rs1) == 0);
+  uint32_t is_system = (format == DISPATCH_SYSTEM)
+    | ((format == DISPATCH_FENCE) & !is_fence);
+  // Kinds of the SYSTEM opcode by imm[6:0], as riscv_dispatch_extract()
+  // tells them apart
+  uint32_t imm7 = (repr >> 20) & 0b1111111;
+  uint32_t system_kind = riscv_select(imm7 == 0, RVINSN_ECALL,
+      riscv_select(imm7 == 1, RVINSN_EBREAK, RVINSN_ILLEGAL));
+  uint32_t kind = riscv_select(is_system, system_kind,
+      riscv_select(is_fence, RVINSN_FENCE, entry_kind));
+  format = riscv_select(is_system, DISPATCH_SYSTEM, format);
+
+  uint32_t legal = ((repr & 0b11) == 0b11) & (format != DISPATCH_NONE)
+    & (entry_kind != RVINSN_ILLEGAL) & (kind != RVINSN_ILLEGAL);
+  format = riscv_select(legal, format, DISPATCH_NONE);
+  kind = riscv_select(legal, kind, RVINSN_ILLEGAL);
+
+  // Bitfield union of every format, the one of `format` is picked by index
+  uint32_t rd_op = rd << 20 | opcode << 25;
+  uint32_t rs1_f3 = rs1 << 12 | funct3 << 17;
+  uint32_t sb_regs = rs2 << 12 | rs1 << 17 | funct3 << 22 | opcode << 25;
+  uint32_t imm_s = ((repr >> 7) & 0x1f) | ((repr >> 20) & 0xfe0);
+  uint32_t imm_b = ((repr >> 8) & 0xf) | ((repr >> 21) & 0x3f0)
+    | ((repr << 3) & 0x400) | ((repr >> 20) & 0x800);
+  uint32_t imm_j = ((repr >> 21) & 0x3ff) | ((repr >> 10) & 0x400)
+    | ((repr >> 1) & 0x7f800) | ((repr >> 12) & 0x80000);
+  uint32_t fence_sets = ((repr >> 28) & 0xf) | ((repr >> 20) & 0xf0)
+    | ((repr >> 12) & 0xf00);
+  const uint32_t fields[DISPATCH_SYSTEM + 1] = {
+    [DISPATCH_NONE] = 0,
+    [DISPATCH_R] = repr >> 25 | rs2 << 7 | rs1_f3 | rd_op,
+    [DISPATCH_I] = repr >> 20 | rs1_f3 | rd_op,
+    // Same widths riscv_decode_i_shamt() keeps
+    [DISPATCH_I_SHAMT_RV32] = ((repr >> 20) & 0b111111) | rs1_f3 | rd_op,
+    [DISPATCH_I_SHAMT_RV64] = ((repr >> 20) & 0b1111111) | rs1_f3 | rd_op,
+    [DISPATCH_S] = imm_s | sb_regs,
+    [DISPATCH_B] = imm_b | sb_regs,
+    [DISPATCH_U] = repr >> 12 | rd_op,
+    [DISPATCH_J] = imm_j | rd_op,
+    [DISPATCH_FENCE] = fence_sets | rs1_f3 | rd_op,
+    [DISPATCH_SYSTEM] = repr >> 20 | rs1_f3 | rd_op,
+  };
+  uint32_t word = fields[format];
+  uint32_t type = BRANCHLESS_TYPES[format];
+  uint32_t compressed = 0;
+
+  if ((repr & 0b11) == 0b11) {
+    RISCV_STATS_DISPATCH(repr);
+    if (!legal) {
+      RISCV_STATS_DISPATCH_FAILED(repr);
+    }
+  }
+
+#ifdef SUPPORT_COMPRESSED
+
+  // Same fallback to the upper halfword as riscv_decode(), looked up always
+  const struct riscv_insn *rvc = &rvc_table[repr >> 16];
+  uint32_t rvc_word;
+  memcpy(&rvc_word, &rvc->r, sizeof(rvc_word));
+  compressed = !legal & (rvc->kind != RVINSN_ILLEGAL);
+  kind = riscv_select(compressed, rvc->kind, kind);
+  type = riscv_select(compressed, rvc->type, type);
+  word = riscv_select(compressed, rvc_word, word);
+
+  if (!legal) {
+    RISCV_STATS_RVC_FALLBACK();
+    RISCV_STATS_RVC(repr >> 16, rvc->kind);
+  }
+
+#endif // SUPPORT_COMPRESSED
+
+  insn->type = type;
+  insn->kind = kind;
+  insn->is_compressed = compressed;
+  insn->length = 4 - 2 * compressed;
+  memcpy(&insn->r, &word, sizeof(word));
+  RISCV_STATS_KIND(kind);
+  return kind;
+}
+
 int riscv_decode_rv32i_r(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
   if (opcode == 0b0110011) {
     uint32_t funct7 = (repr >> 25) & 0b1111111;
@@ -455,11 +467,12 @@ int riscv_decode_rv64i_i(struct riscv_insn *insn, uint32_t repr, uint32_t opcode
         riscv_decode_i_shamt(insn, RVINSN_SLLI, repr, opcode, 6);
         return 1;
       } else if (funct3 == 0b101) {
-        uint32_t funct7 = (repr >> 25) & 0b1111111;
-        if (funct7 == 0) {
+        // funct6, as bit 25 is shamt[5]
+        uint32_t funct6 = (repr >> 26) & 0b111111;
+        if (funct6 == 0) {
           riscv_decode_i_shamt(insn, RVINSN_SRLI, repr, opcode, 6);
           return 1;
-        } else if (funct7 == 0b010000) {
+        } else if (funct6 == 0b010000) {
           riscv_decode_i_shamt(insn, RVINSN_SRAI, repr, opcode, 6);
           return 1;
         }
@@ -567,651 +580,186 @@ int riscv_decode_rv64m_r(struct riscv_insn *insn, uint32_t repr, uint32_t opcode
 
 #ifdef SUPPORT_COMPRESSED
 
-#define RVREG16(reg) (RVREG_s0 + reg)
-
-inline static void riscv_init_r(
-    struct riscv_insn *insn,
-    int kind,
-    uint32_t rs2,
-    uint32_t rs1,
-    uint32_t rd
-) {
-  insn->type = INSN_R;
-  insn->kind = kind;
-  insn->r.rs2 = rs2;
-  insn->r.rs1 = rs1;
-  insn->r.rd = rd;
-}
-
-inline static void riscv_init_i(
-    struct riscv_insn *insn,
-    int kind,
-    uint32_t imm,
-    uint32_t rs1,
-    uint32_t rd
-) {
-  insn->type = INSN_I;
-  insn->kind = kind;
-  insn->i.imm = imm;
-  insn->i.rs1 = rs1;
-  insn->i.rd = rd;
-}
-
-inline static void riscv_init_s(
-    struct riscv_insn *insn,
-    int kind,
-    uint32_t imm,
-    uint32_t rs2,
-    uint32_t rs1
-) {
-  insn->type = INSN_S;
-  insn->kind = kind;
-  insn->s.imm = imm;
-  insn->s.rs2 = rs2;
-  insn->s.rs1 = rs1;
-}
-
-inline static void riscv_init_b(
-    struct riscv_insn *insn,
-    int kind,
-    uint32_t imm,
-    uint32_t rs2,
-    uint32_t rs1
-) {
-  insn->type = INSN_B;
-  insn->kind = kind;
-  insn->b.imm = imm;
-  insn->b.rs2 = rs2;
-  insn->b.rs1 = rs1;
-}
-
-
-inline static void riscv_init_u(
-    struct riscv_insn *insn,
-    int kind,
-    uint32_t imm,
-    uint32_t rd
-) {
-  insn->type = INSN_U;
-  insn->kind = kind;
-  insn->u.imm = imm;
-  insn->u.rd = rd;
+int rvc_decode(struct riscv_insn *insn, uint32_t repr) {
+  int kind = rvc_lookup(insn, repr);
+  RISCV_STATS_KIND(kind);
+  return kind;
 }
 
-inline static void riscv_init_j(
-    struct riscv_insn *insn,
-    int kind,
-    uint32_t imm
-) {
-  insn->type = INSN_J;
-  insn->kind = kind;
-  insn->j.imm = imm;
-}
+#endif // SUPPORT_COMPRESSED
 
-static inline int64_t sign_extend_to(int64_t value, int sign_bit_pos, int target_length) {
-  // If value had negative bit set, sign-extend it to target length, otherwise it's a nop
-  if (value & (1 << (sign_bit_pos))) {
-    return ~((value ^ ~(0xffffffffffffffff << sign_bit_pos + 1)));
-  }
-  return value;
+size_t riscv_decode_buffer(const uint8_t *buf, size_t len, uint64_t base_pc,
+    struct riscv_insn *out, size_t cap) {
+#ifdef SUPPORT_COMPRESSED
+  return riscv_decode_buffer_with(buf, len, base_pc, out, cap,
+      riscv_dispatch_table, rvc_table);
+#else
+  return riscv_decode_buffer_with(buf, len, base_pc, out, cap,
+      riscv_dispatch_table, NULL);
+#endif // SUPPORT_COMPRESSED
 }
 
-int rvc_decode(struct riscv_insn *insn, uint32_t repr) {
-  if (repr == 0) {
-    return RVINSN_ILLEGAL;
-  }
-
-  insn->is_compressed = true;
-  uint8_t opcode = repr & 0b11;
-  for (int i = 0; i < sizeof(decoder_hooks16) / sizeof(*decoder_hooks16); ++i) {
-    if (decoder_hooks16[i].rvc_decode_cr(insn, repr, opcode))  { return insn->kind; }
-    if (decoder_hooks16[i].rvc_decode_ci(insn, repr, opcode))  { return insn->kind; }
-    if (decoder_hooks16[i].rvc_decode_css(insn, repr, opcode)) { return insn->kind; }
-    if (decoder_hooks16[i].rvc_decode_ciw(insn, repr, opcode)) { return insn->kind; }
-    if (decoder_hooks16[i].rvc_decode_cl(insn, repr, opcode))  { return insn->kind; }
-    if (decoder_hooks16[i].rvc_decode_cs(insn, repr, opcode))  { return insn->kind; }
-    if (decoder_hooks16[i].rvc_decode_ca(insn, repr, opcode))  { return insn->kind; }
-    if (decoder_hooks16[i].rvc_decode_cb(insn, repr, opcode))  { return insn->kind; }
-    if (decoder_hooks16[i].rvc_decode_cj(insn, repr, opcode))  { return insn->kind; }
-  }
-
-  insn->is_compressed = false;
-  return RVINSN_ILLEGAL;
+size_t riscv_decode_block(const uint8_t *buf, size_t len, uint64_t pc,
+    struct riscv_insn *out, size_t cap, struct riscv_block *block) {
+#ifdef SUPPORT_COMPRESSED
+  return riscv_decode_block_with(buf, len, pc, out, cap, block,
+      riscv_dispatch_table, rvc_table);
+#else
+  return riscv_decode_block_with(buf, len, pc, out, cap, block,
+      riscv_dispatch_table, NULL);
+#endif // SUPPORT_COMPRESSED
 }
 
-int rvc_decode_cr_rv32(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  /* uint32_t funct3 = (repr & (0b111 << 12)) >> 12; */
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  uint32_t funct4 = (repr >> 12) & 1;
-  switch (opcode) {
-    case 0b10: {
-      if (funct3 == 0b100) {
-        // C.JR -> `jalr x0, 0(rs1)`
-        // | C.JALR -> `jalr x1, 0(rs1)`
-        // | C.MV -> `add rd, x0, rs2`
-        // | C.ADD -> `add rd, rd, rs2`
-        // | C.EBREAK -> `ebreak`
-        uint32_t rs2 = (repr >> 2) & 0b11111;
-        uint32_t rs1 = (repr >> 7) & 0b11111;
-
-        if (rs1 == 0) {
-          if (rs2 == 0 && funct4 == 0b1) {
-            // C.EBREAK -> `ebreak`
-            riscv_init_i(insn, RVINSN_EBREAK, 0, 0, 0);
-            return 1;
-          }
-          break;
-        }
-
-        if (rs2 != 0) {
-          if (funct4 == 0b1) {
-            // C.ADD -> `add rd, rd, rs2`
-            riscv_init_r(insn, RVINSN_ADD, rs2, /* rd */ rs1, /* rd */ rs1);
-          } else {
-            // C.MV -> `add rd, x0, rs2`
-            riscv_init_r(insn, RVINSN_ADD, rs2, /* rs1 */ RVREG_zero, /* rd */ rs1);
-          }
-          return 1;
-        }
+/* Register slots of each dispatch format, as masks applied to the fields. */
+static const struct {
+  uint8_t rd;
+  uint8_t rs1;
+  uint8_t rs2;
+} OPERAND_REGS[] = {
+  [DISPATCH_R] = { 0b11111, 0b11111, 0b11111 },
+  [DISPATCH_I] = { 0b11111, 0b11111, 0 },
+  [DISPATCH_I_SHAMT_RV32] = { 0b11111, 0b11111, 0 },
+  [DISPATCH_I_SHAMT_RV64] = { 0b11111, 0b11111, 0 },
+  [DISPATCH_S] = { 0, 0b11111, 0b11111 },
+  [DISPATCH_B] = { 0, 0b11111, 0b11111 },
+  [DISPATCH_U] = { 0b11111, 0, 0 },
+  [DISPATCH_J] = { 0b11111, 0, 0 },
+};
 
-        if (funct4 == 0b1) {
-          // C.JALR -> `jalr x1, 0(rs1)`
-          riscv_init_i(insn, RVINSN_JALR, 0, RVREG_ra, rs1);
-        } else {
-          // C.JR -> `jalr x0, 0(rs1)`
-          riscv_init_i(insn, RVINSN_JALR, 0, RVREG_zero, rs1);
-        }
-        return 1;
-      }
-      break;
+/* Decodes the 32-bit instruction `repr` to its kind and the operands
+ * riscv_insn_operands() would return, taking them straight from the encoding.
+ * The immediates of all formats are computed and the one of the
+ * instruction's format picked by index, so the cost doesn't depend on the
+ * format. Unassigned encodings and FENCE, ECALL and EBREAK, whose kind
+ * depends on the operand fields, go through riscv_decode32(). */
+static inline int riscv_decode32_operands(uint32_t repr,
+    struct riscv_operands *ops) {
+  const struct riscv_dispatch_entry *entry =
+    &riscv_dispatch_table[(repr >> 2) & 0b11111][(repr >> 12) & 0b111];
+  int kind = entry->kind[FUNCT7_CLASS_TABLE[repr >> 25]];
+  int format = entry->format;
+
+  if (kind == RVINSN_ILLEGAL || format == DISPATCH_NONE
+      || format >= DISPATCH_FENCE) {
+    struct riscv_insn insn;
+    if (riscv_decode32(&insn, repr) == RVINSN_ILLEGAL) {
+      insn.type = INSN_UNDEFINED;
+      insn.kind = RVINSN_ILLEGAL;
     }
+    riscv_operands_of(&insn, ops);
+    return insn.kind;
   }
-  return 0;
+  RISCV_STATS_DISPATCH(repr);
+
+  int32_t sign = (int32_t)repr >> 31;
+  int32_t imm_i = (int32_t)repr >> 20;
+  int32_t imms[DISPATCH_FENCE] = {
+    [DISPATCH_R] = 0,
+    [DISPATCH_I] = imm_i,
+    // Same widths riscv_decode_i_shamt() keeps
+    [DISPATCH_I_SHAMT_RV32] = (repr >> 20) & 0b111111,
+    [DISPATCH_I_SHAMT_RV64] = (repr >> 20) & 0b1111111,
+    [DISPATCH_S] = (imm_i & ~0b11111) | ((repr >> 7) & 0b11111),
+    [DISPATCH_B] = (int32_t)((uint32_t)sign << 12) | ((repr << 4) & 0x800)
+      | ((repr >> 20) & 0x7e0) | ((repr >> 7) & 0x1e),
+    [DISPATCH_U] = (int32_t)(repr & 0xfffff000),
+    [DISPATCH_J] = (int32_t)((uint32_t)sign << 20) | (repr & 0xff000)
+      | ((repr >> 9) & 0x800) | ((repr >> 20) & 0x7fe),
+  };
+
+  ops->rd = (repr >> 7) & OPERAND_REGS[format].rd;
+  ops->rs1 = (repr >> 15) & OPERAND_REGS[format].rs1;
+  ops->rs2 = (repr >> 20) & OPERAND_REGS[format].rs2;
+  ops->imm = imms[format];
+  return kind;
+}
+
+/* Same as riscv_decode32_operands() for the 16-bit instruction `repr`. */
+static inline int riscv_decode16_operands(uint32_t repr,
+    struct riscv_operands *ops) {
+#ifdef SUPPORT_COMPRESSED
+  const struct riscv_insn *insn = &rvc_table[repr];
+  RISCV_STATS_RVC(repr, insn->kind);
+  riscv_operands_of(insn, ops);
+  return insn->kind;
+#else
+  ops->rd = 0;
+  ops->rs1 = 0;
+  ops->rs2 = 0;
+  ops->imm = 0;
+  return RVINSN_ILLEGAL;
+#endif // SUPPORT_COMPRESSED
 }
 
-int rvc_decode_ci_rv32(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b01: {
-      if (funct3 == 0b010) {
-        // C.LI -> `addi rd, x0, imm[5:0]`
-        uint32_t imm = (((repr >> 12) & 1) << 5) | ((repr >> 2) & 0b11111);
-        uint32_t rd = (repr >> 7) & 0b11111;
-        if (rd == 0) {
-          // Points to undefined HINT.
-          break;
-        }
-        riscv_init_i(insn, RVINSN_ADDI, imm, /* rs1 */ RVREG_zero, /* rd */ rd);
-        return 1;
-      } else if (funct3 == 0b011) {
-        // C.LUI -> `lui rd, nzimm[17:12]`
-        // | C.ADDI16SP -> `addi x2, x2, nzimm[9:4]`
-        uint32_t rd = (repr >> 7) & 0b11111;
-
-        if (rd == 2) {
-          // C.ADDI16SP -> `addi x2, x2, nzimm[9:4]`
-          // TODO: This insrtuction has bit-shuffling in it's immediate,
-          // need to implement it, right now it has junk in immediate.
-          uint32_t imm = (((repr >> 6) & 1) |
-             (((repr >> 2) & 1) << 1) |
-             (((repr >> 5) & 1) << 2) |
-             (((repr >> 3) & 0b11) << 3) |
-             (((repr >> 12) & 1) << 5))
-            << 4; // bitshit 4 is declared in abi
-          riscv_init_i(insn, RVINSN_ADDI, imm, rd, rd);
-          return 1;
-        }
+size_t riscv_decode_buffer_soa(const uint8_t *buf, size_t len,
+    const struct riscv_insn_soa *out, size_t cap) {
+  size_t offset = 0;
+  size_t count = 0;
 
-        uint32_t imm = (((repr >> 12) & 1) << 5) | ((repr >> 2) & 0b11111);
-        if (rd == 0 || imm == 0) {
-          // Points to undefined HINT.
-          break;
-        }
+  while (count < cap && len - offset >= 2) {
+    uint32_t repr = buf[offset] | (buf[offset + 1] << 8);
+    struct riscv_operands ops;
+    int kind;
+    uint8_t length;
 
-        riscv_init_u(insn, RVINSN_LUI, imm, rd);
-        return 1;
-      } else if (funct3 == 0b000) {
-        // C.ADDI -> `addi rd, rd, nzimm[5:0]`
-        // | C.NOP -> `addi x0, x0, 0`
-        uint32_t imm = (((repr >> 12) & 1) << 5) | ((repr >> 2) & 0b11111);
-        uint32_t rd = (repr >> 7) & 0b11111;
-        if (rd == 0 && imm == 0) {
-          // C.NOP -> `addi x0, x0, 0`
-          riscv_init_i(insn, RVINSN_ADDI, imm, rd, rd);
-          return 1;
-        }
-        if (rd == 0 || imm == 0) {
-          break;
-        }
-        riscv_init_i(insn, RVINSN_ADDI, sign_extend_to(imm, 5, 12), rd, rd);
-        return 1;
-      }
-      break;
-    }
-    case 0b10: {
-      if (funct3 == 0b000) {
-        // C.SLLI -> `slli rd, rd, shamt[5:0]`
-        uint32_t shamt_5 = ((repr >> 12) & 1) << 5;
-        uint32_t shamt =  shamt_5 | (((repr >> 2) & 0b11111) << 1);
-        uint32_t rd = (repr >> 7) & 0b11111;
-        if (rd == 0 || shamt == 0) {
-          break;
-        }
-
-        if (shamt_5 == 1) {
-          // Reserved for custom extension
-          break;
-        }
-
-        riscv_init_i(insn, RVINSN_SLLI, shamt, rd, rd);
-        return 1;
-      } else if (funct3 == 0b010) {
-        // C.LWSP -> `lw rd, offset[7:2](x2)`
-        uint32_t imm = ((repr >> 2) & 0b11) |
-          (((repr >> 12) & 1) << 2) |
-          (((repr >> 4) & 0b111) << 3);
-        uint32_t rd = (repr >> 7) & 0b11111;
-        if (rd == 0) {
-          break;
-        }
-        riscv_init_i(insn, RVINSN_LW, imm, rd, RVREG_sp);
-        return 1;
-      } else if (funct3 == 0b001) {
-        // C.LQSP -> `lq rd, offset[9:4](x2)`
-        // | C.FLDSP ->  `flw rd, offset[7:2](x2)`
-        // TODO: Implement RV128I for lq instruction, for now just treat it like illegal instruction.
-        // Future: if (rd == 0) {
-        //   // Handle C.FLDSP -> `flw rd, offset[7:2](x2)`
-        // }
-        break;
-      } else if (funct3 == 0b011) {
-        // C.FLWSP -> `flw rd, offset[7:2](x2)`
-        // TODO: implement RV32FC instruction set.
+    if ((repr & 0b11) == 0b11) {
+      if (len - offset < 4) {
         break;
       }
-      break;
-    }
-  }
-  return 0;
-}
-
-int rvc_decode_css_rv32(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b10: {
-      if (funct3 == 0b110) {
-        // C.SWSP -> `sw rs2, offset[7:2](x2)`
-        uint32_t rs2 = (repr >> 2) & 0b11111;
-        uint32_t imm =
-          (((repr >> 9) & 0b1111) |
-          (((repr >> 7) & 0b11) << 4)) << 2;
-        riscv_init_s(insn, RVINSN_SW, imm, rs2, RVREG_sp);
-        return 1;
-      } else if (funct3 == 0b101) {
-        // C.SQSP -> `sq rs2, offset[9:4](x2)`
-        // TODO: Implement RV128I for sq instruction, for now just treat it like illegal instruction.
-        // Also expands to in RV32I code:
-        // C.FSDSP -> `fsd rs2, offset[8:3](x2)`
-        // TODO: Implement RV32FC
-      }
-      break;
-    }
-  }
-  return 0;
-}
-
-int rvc_decode_ciw_rv32(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b00: {
-      if (funct3 == 0b000) {
-        // C.ADDI4SPN -> `addi rd′, x2, nzuimm[9:2]`
-        uint32_t rd = (repr >> 2) & 0b111;
-        uint32_t imm =
-          (((repr >> 6) & 1) |
-          (((repr >> 5) & 1) << 1) |
-          (((repr >> 11) & 0b11) << 2) |
-          (((repr >> 7) & 0b1111) << 4)) << 2;
-        riscv_init_i(insn, RVINSN_ADDI, imm, RVREG_sp, RVREG16(rd));
-        return 1;
-      }
-      break;
+      repr |= (uint32_t)(buf[offset + 2] | (buf[offset + 3] << 8)) << 16;
+      kind = riscv_decode32_operands(repr, &ops);
+      length = 4;
+    } else {
+      kind = riscv_decode16_operands(repr, &ops);
+      length = 2;
     }
-  }
-  return 0;
-}
 
-int rvc_decode_cl_rv32(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b00: {
-      if (funct3 == 0b010) {
-        // C.LW -> `lw rd′, offset[6:2](rs1′)`
-        uint32_t rd = (repr >> 2) & 0b111;
-        uint32_t imm =
-          (((repr >> 6) & 1) |
-           (((repr >> 10) & 0b111) << 1) |
-           (((repr >> 5) & 1) << 4)) << 2;
-        uint32_t rs1 = (repr >> 7) & 0b111;
-        riscv_init_i(insn, RVINSN_LW, imm, RVREG16(rs1), RVREG16(rd));
-        return 1;
-      } else if (funct3 == 0b001) {
-        // C.LQ -> `lq rd′, offset[8:4](rs1′)`
-        // TODO: Implement RV128I for lq instruction, for now just treat it like illegal instruction.
-        // Also expands to in RV32I code:
-        // C.FLD -> `fld rd′, offset[6:2](rs1′)`
-        // TODO: Implement RV32FC
-      }
-      break;
-    }
-  }
-  return 0;
-}
+    RISCV_STATS_KIND(kind);
+    out->kind[count] = kind;
+    out->rd[count] = ops.rd;
+    out->rs1[count] = ops.rs1;
+    out->rs2[count] = ops.rs2;
+    out->imm[count] = ops.imm;
+    out->len[count] = length;
 
-int rvc_decode_cs_rv32(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b00: {
-      if (funct3 == 0b110) {
-        // C.SW -> `sw rs2′, offset[6:2](rs1′)`
-        uint32_t rs2 = (repr >> 2) & 0b111;
-        uint32_t imm =
-          (((repr >> 6) & 1) |
-          (((repr >> 10) & 0b111) << 1) |
-          (((repr >> 5) & 1) << 4)) << 2;
-        uint32_t rs1 = (repr >> 7) & 0b111;
-        riscv_init_s(insn, RVINSN_SW, imm, RVREG16(rs2), RVREG16(rs1));
-        return 1;
-      } else if (funct3 == 0b101) {
-        // C.SQ -> `sq rs2′, offset[8:4](rs1′)`
-        // TODO: Implement RV128I for sq instruction, for now just treat it like illegal instruction.
-        // Also expands to in RV32I code:
-        // C.FSD -> `fsd rs2′,offset[7:3](rs1′)`
-        // TODO: Implement RV32FC
-      }
-      break;
-    }
-  }
-  return 0;
-}
-
-int rvc_decode_ca_rv32(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  uint32_t funct4 = (repr >> 12) & 1;
-  uint32_t funct6 = (repr >> 10) & 0b11;
-  switch (opcode) {
-    case 0b01: {
-      if (funct3 == 0b100) {
-        // C.AND -> `and rd′, rd′, rs2′`
-        // | C.OR -> `or rd′, rd′, rs2′`
-        // | C.XOR -> `xor rd′, rd′, rs2′`
-        // | C.SUB -> `sub rd′, rd′, rs2′`
-        uint32_t funct2 = (repr >> 5) & 0b11;
-        uint32_t rs1 = (repr >> 7) & 0b111; // Also `rd`
-        uint32_t rs2 = (repr >> 2) & 0b111;
-        if (funct6 == 0b11) {
-          if (funct4 == 0b0) {
-            if (funct2 == 0b11) {
-              // C.AND -> `and rd′, rd′, rs2′`
-              riscv_init_r(insn, RVINSN_AND, RVREG16(rs2), RVREG16(rs1), RVREG16(rs1));
-              return 1;
-            } else if (funct2 == 0b10) {
-              // C.OR -> `or rd′, rd′, rs2′`
-              riscv_init_r(insn, RVINSN_OR, RVREG16(rs2), RVREG16(rs1), RVREG16(rs1));
-              return 1;
-            } else if (funct2 == 0b01) {
-              // C.XOR -> `xor rd′, rd′, rs2′`
-              riscv_init_r(insn, RVINSN_XOR, RVREG16(rs2), RVREG16(rs1), RVREG16(rs1));
-              return 1;
-            } else if (funct2 == 0b00) {
-              // C.SUB -> `sub rd′, rd′, rs2′`
-              riscv_init_r(insn, RVINSN_SUB, RVREG16(rs2), RVREG16(rs1), RVREG16(rs1));
-              return 1;
-            }
-          }
-        }
-      }
-      break;
-    }
-  }
-  return 0;
-}
-
-int rvc_decode_cb_rv32(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b01: {
-      if (funct3 == 0b110) {
-        // C.BEQZ -> `beq rs1′, x0, offset[8:1]`
-        uint32_t rs1 = (repr >> 7) & 0b111;
-        uint32_t imm =
-          (((repr >> 3) & 0b11) |
-           (((repr >> 10) & 0b11) << 2) |
-           (((repr >> 2) & 1) << 4) |
-           (((repr >> 5) & 0b11) << 5) |
-           (((repr >> 12) & 1) << 7)) << 1;
-        riscv_init_b(insn, RVINSN_BEQ, imm, RVREG_zero, RVREG16(rs1));
-        return 1;
-      } else if (funct3 == 0b111) {
-        // C.BNEZ -> `bne rs1′, x0, offset[8:1]`
-        uint32_t rs1 = (repr >> 7) & 0b111;
-        uint32_t imm =
-          (((repr >> 3) & 0b11) |
-           (((repr >> 10) & 0b11) << 2) |
-           (((repr >> 2) & 1) << 4) |
-           (((repr >> 5) & 0b11) << 5) |
-           (((repr >> 12) & 1) << 7)) << 1;
-        riscv_init_b(insn, RVINSN_BNE, imm, RVREG_zero, RVREG16(rs1));
-        return 1;
-      } else if (funct3 == 0b100) {
-        // C.SRLI -> `srli rd′,rd′, shamt[5:0]`
-        // | C.SRAI -> `srai rd′, rd′, shamt[5:0]`
-        // | C.ANDI -> `andi rd′, rd′, imm[5:0]`
-        uint32_t rd = ((repr >> 7) & 0b111);
-        uint32_t shamt = ((repr >> 2) & 0b11111) | (((repr >> 12) & 1) << 5);
-        uint32_t funct2 = (repr >> 10) & 0b11;
-        if (funct2 == 0b00) {
-          // C.SRLI -> srli rd′, rd′, shamt[5:0]
-          riscv_init_i(insn, RVINSN_SRLI, shamt, RVREG16(rd), RVREG16(rd));
-          return 1;
-        } else if (funct2 == 0b01) {
-          // C.SRAI -> srai rd′, rd′, shamt[5:0]
-          riscv_init_i(insn, RVINSN_SRAI, shamt, RVREG16(rd), RVREG16(rd));
-          return 1;
-        } else if (funct2 == 0b10) {
-          // C.ANDI -> andi rd′, rd′, imm[5:0]
-          riscv_init_i(insn, RVINSN_ANDI, sign_extend_to(shamt, 5, 12), RVREG16(rd), RVREG16(rd));
-          return 1;
-        }
-      }
-      break;
-    }
+    offset += length;
+    ++count;
   }
-  return 0;
-}
 
-int rvc_decode_cj_rv32(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b01: {
-      if (funct3 == 0b101) {
-        // C.J -> `jal x0, offset[11:1]`
-        uint32_t imm =
-          (((repr >> 3) & 0b111) |
-           (((repr >> 11)  & 1) << 3) |
-           (((repr >> 2)  & 1) << 4) |
-           (((repr >> 7)  & 1) << 5) |
-           (((repr >> 6)  & 1) << 6) |
-           (((repr >> 9)  & 0b11) << 7) |
-           (((repr >> 8) & 1) << 9) |
-           (((repr >> 12) & 1) << 10)) << 1;
-        riscv_init_j(insn, RVINSN_JAL, sign_extend_to(imm, 11, 20));
-        return 1;
-      }
-      break;
-    }
-  }
-  return 0;
+  return count;
 }
 
-int rvc_decode_ci_rv64(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b01: {
-      if (funct3 == 0b001) {
-        // C.ADDIW -> `addiw rd,rd, imm[5:0]`, when imm == 0 -> `sext.w rd`
-        uint32_t imm = (((repr >> 12) & 1) << 5) | ((repr >> 2) & 0b11111);
-        uint32_t rd = (repr >> 7) & 0b11111;
-        if (rd == 0) {
-          break;
-        }
-        riscv_init_i(insn, RVINSN_ADDIW, sign_extend_to(imm, 5, 12), rd, rd);
-        return 1;
-      }
-      break;
-      // TODO: C.SLLI64
-    }
-    case 0b10: {
-      if (funct3 == 0b011) {
-        // C.LDSP -> `ld rd, offset[8:3](x2)`
-        uint32_t imm = (((repr >> 5) & 0b11) |
-          (((repr >> 12) & 1) << 2) |
-          (((repr >> 2) & 0b111) << 3)) << 3;
-        uint32_t rd = (repr >> 7) & 0b11111;
-        if (rd == 0) {
-          break;
-        }
-        riscv_init_i(insn, RVINSN_LD, imm, rd, RVREG_sp);
-        return 1;
-      }
-      break;
-    }
-  }
-  return 0;
-}
+size_t riscv_decode_buffer_packed(const uint8_t *buf, size_t len,
+    struct riscv_insn_packed *out, size_t cap) {
+  size_t offset = 0;
+  size_t count = 0;
 
-int rvc_decode_css_rv64(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b10: {
-      if (funct3 == 0b111) {
-        // C.SDSP -> `sd rs2, offset[8:3](x2)`
-        // Also expands to in RV32I code:
-        // C.FSWSP -> `fsw rs2, offset[7:2](x2)`
-        // TODO: Implement RV32FC
-        uint32_t rs2 = (repr >> 2) & 0b11111;
-        uint32_t imm =
-          (((repr >> 10) & 0b111) |
-          (((repr >> 7) & 0b111) << 3)) << 3;
-        riscv_init_s(insn, RVINSN_SD, imm, rs2, RVREG_sp);
-        return 1;
-      }
-      break;
-    }
-  }
-  return 0;
-}
+  while (count < cap && len - offset >= 2) {
+    uint32_t repr = buf[offset] | (buf[offset + 1] << 8);
+    struct riscv_operands ops;
+    int kind;
+    uint32_t compressed;
 
-int rvc_decode_cl_rv64(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b00: {
-      if (funct3 == 0b011) {
-        // C.LD -> `ld rd′, offset[7:3](rs1′)`
-        // Also expands to in RV32I code:
-        // C.FLW -> `flw rd′, offset[6:2](rs1′)`
-        // TODO: Implement RV32FC
-        uint32_t rd = (repr >> 2) & 0b111;
-        uint32_t imm =
-          (((repr >> 10) & 0b111) |
-           (((repr >> 5) & 0b11) << 3)) << 3;
-        uint32_t rs1 = (repr >> 7) & 0b111;
-        riscv_init_i(insn, RVINSN_LD, imm, RVREG16(rs1), RVREG16(rd));
-        return 1;
+    if ((repr & 0b11) == 0b11) {
+      if (len - offset < 4) {
+        break;
       }
-      break;
+      repr |= (uint32_t)(buf[offset + 2] | (buf[offset + 3] << 8)) << 16;
+      kind = riscv_decode32_operands(repr, &ops);
+      compressed = 0;
+    } else {
+      kind = riscv_decode16_operands(repr, &ops);
+      compressed = 1;
     }
-  }
-  return 0;
-}
 
-int rvc_decode_cs_rv64(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b00: {
-      if (funct3 == 0b111) {
-        // C.SD -> `sd rs2′, offset[7:3](rs1′)`
-        // Also expands to in RV32I code:
-        // C.FSW -> `fsw rs2′, offset[6:2](rs1′)`
-        // TODO: Implement RV32FC
-        uint32_t rs2 = (repr >> 2) & 0b111;
-        uint32_t imm =
-          (((repr >> 10) & 0b111) |
-          (((repr >> 5) & 0b11) << 3)) << 3;
-        uint32_t rs1 = (repr >> 7) & 0b111;
-        riscv_init_s(insn, RVINSN_SD, imm, RVREG16(rs2), RVREG16(rs1));
-        return 1;
-      }
-      break;
-    }
-  }
-  return 0;
-}
+    RISCV_STATS_KIND(kind);
+    out[count].kind = kind;
+    out[count].regs = RISCV_PACKED_REGS(ops.rd, ops.rs1, ops.rs2, compressed);
+    out[count].imm = ops.imm;
 
-int rvc_decode_ca_rv64(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  uint32_t funct4 = (repr >> 12) & 1;
-  uint32_t funct6 = (repr >> 10) & 0b11;
-  switch (opcode) {
-    case 0b01: {
-      if (funct3 == 0b100) {
-        // C.ADDW -> `addw rd′, rd′, rs2′`
-        // | C.SUBW -> `subw rd′, rd′, rs2′`
-        uint32_t funct2 = (repr >> 5) & 0b11;
-        uint32_t rs1 = (repr >> 7) & 0b111; // Also `rd`
-        uint32_t rs2 = (repr >> 2) & 0b111;
-        if (funct6 == 0b11) {
-          if (funct4 == 0b1) {
-            if (funct2 == 0b01) {
-              // C.ADDW -> `addw rd′, rd′, rs2′`
-              riscv_init_r(insn, RVINSN_ADDW, RVREG16(rs2), RVREG16(rs1), RVREG16(rs1));
-              return 1;
-            } else if (funct2 == 0b00) {
-              // C.SUBW -> `subw rd′, rd′, rs2′`
-              riscv_init_r(insn, RVINSN_SUBW, RVREG16(rs2), RVREG16(rs1), RVREG16(rs1));
-              return 1;
-            }
-          }
-        }
-      }
-      break;
-    }
+    offset += 4 - 2 * compressed;
+    ++count;
   }
-  return 0;
-}
 
-int rvc_decode_cj_rv64(struct riscv_insn *insn, uint32_t repr, uint32_t opcode) {
-  uint32_t funct3 = (repr >> 13) & 0b111;
-  switch (opcode) {
-    case 0b01: {
-      if (funct3 == 0b001) {
-        // C.JAL -> `jal x1, offset[11:1]`
-        uint32_t imm =
-          (((repr >> 3) & 0b111) |
-           (((repr >> 11)  & 1) << 3) |
-           (((repr >> 2)  & 1) << 4) |
-           (((repr >> 7)  & 1) << 5) |
-           (((repr >> 6)  & 1) << 6) |
-           (((repr >> 9)  & 0b11) << 7) |
-           (((repr >> 8) & 1) << 9) |
-           (((repr >> 12) & 1) << 10));
-        riscv_init_j(insn, RVINSN_JAL, sign_extend_to(imm, 11, 20));
-        return 1;
-      }
-      break;
-    }
-  }
-  return 0;
+  return count;
 }
-
-#endif // SUPPORT_COMPRESSED
@@ -0,0 +1,49 @@
+#include "config.h"
+
+#include <string.h>
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+int riscv_decode_cache_init(struct riscv_decode_cache *cache,
+    struct riscv_decode_cache_entry *entries, size_t size,
+    const struct riscv_decoder *dec) {
+  if (size < 2 || (size & (size - 1)) != 0 || size / 2 - 1 > UINT32_MAX) {
+    return 0;
+  }
+
+  cache->entries = entries;
+  cache->mask = size / 2 - 1;
+  cache->dec = dec;
+  cache->hits = 0;
+  cache->misses = 0;
+  riscv_decode_cache_clear(cache);
+  return 1;
+}
+
+void riscv_decode_cache_clear(struct riscv_decode_cache *cache) {
+  memset(cache->entries, 0,
+      2 * ((size_t)cache->mask + 1) * sizeof(*cache->entries));
+}
+
+const struct riscv_insn *riscv_decode_cache_fill(
+    struct riscv_decode_cache *cache, struct riscv_decode_cache_entry *set,
+    uint32_t repr) {
+  ++cache->misses;
+
+  // The first way holds the most recently used word, so the second one is
+  // evicted
+  set[1] = set[0];
+  struct riscv_decode_cache_entry *entry = &set[0];
+
+  // Fields the decoders leave alone are the same on every miss
+  memset(&entry->insn, 0, sizeof(entry->insn));
+  if (cache->dec) {
+    riscv_decoder_decode(cache->dec, &entry->insn, repr);
+  } else {
+    riscv_decode(&entry->insn, repr);
+  }
+  entry->repr = repr;
+  entry->valid = 1;
+  return &entry->insn;
+}
@@ -0,0 +1,184 @@
+#include "config.h"
+
+#include <stdlib.h>
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#include "decoder_dispatch.h"
+#include "riscv_threads.h"
+#include "rvc_table.h"
+
+/* Parallel buffer decoding.
+ *
+ * The buffer is cut into one chunk per thread at even offsets. Instructions
+ * are at most 4 bytes long, so the serial walk enters each chunk either at its
+ * first halfword or at its second one, when a 32-bit instruction straddles the
+ * cut. Which one isn't known until the previous chunk is walked, so each
+ * thread first walks its chunk from both, only looking at the length bits of
+ * each instruction. The two walks mostly meet after a few instructions, past
+ * which they share the rest of the chunk. A serial pass then follows the
+ * chunks from the start of the buffer to pick the phase each is entered at and
+ * where its instructions go in `out`, and the threads decode their chunks
+ * there in a second parallel pass. */
+
+typedef const struct riscv_dispatch_entry (*dispatch_table)[8];
+
+// Below this many bytes per thread, threads cost more than they save
+#define MIN_CHUNK_SIZE (64 * 1024)
+
+struct chunk_phase {
+  // Number of instructions starting in the chunk
+  size_t count;
+  // Offset of the first instruction past the chunk, or `len` if the walk
+  // ran off the end of the buffer
+  size_t end;
+};
+
+struct chunk {
+  const uint8_t *buf;
+  size_t len;
+  uint64_t base_pc;
+  size_t start;
+  size_t limit;
+  // Walks entered at `start` and `start + 2`
+  struct chunk_phase phases[2];
+
+  // Set by the serial pass
+  size_t entry;
+  size_t first;
+  size_t count;
+
+  struct riscv_insn *out;
+  dispatch_table table;
+  const struct riscv_insn *rvc;
+};
+
+/* Moves `*offset` past the instruction there, or to `len` if it doesn't fit
+ * in the buffer. Returns 1 if there was a whole instruction. */
+static inline int step(const uint8_t *buf, size_t len, size_t *offset) {
+  size_t size = (buf[*offset] & 0b11) == 0b11 ? 4 : 2;
+  if (len - *offset < size) {
+    *offset = len;
+    return 0;
+  }
+  *offset += size;
+  return 1;
+}
+
+static void *scan_chunk(void *arg) {
+  struct chunk *chunk = arg;
+  const uint8_t *buf = chunk->buf;
+  size_t len = chunk->len;
+  size_t limit = chunk->limit;
+
+  size_t a = chunk->start, na = 0;
+  size_t b = chunk->start + 2 < len ? chunk->start + 2 : len, nb = 0;
+
+  // Step whichever walk is behind until they meet or leave the chunk
+  while (a != b && (a < limit || b < limit)) {
+    if (a < b) {
+      na += step(buf, len, &a);
+    } else {
+      nb += step(buf, len, &b);
+    }
+  }
+
+  // From where they met on, the walks are the same
+  if (a == b) {
+    size_t n = 0;
+    while (a < limit) {
+      n += step(buf, len, &a);
+    }
+    na += n;
+    nb += n;
+    b = a;
+  }
+
+  chunk->phases[0].count = na;
+  chunk->phases[0].end = a;
+  chunk->phases[1].count = nb;
+  chunk->phases[1].end = b;
+  return NULL;
+}
+
+static void *decode_chunk(void *arg) {
+  struct chunk *chunk = arg;
+  riscv_decode_buffer_with(chunk->buf + chunk->entry, chunk->len - chunk->entry,
+      chunk->base_pc + chunk->entry, chunk->out + chunk->first, chunk->count,
+      chunk->table, chunk->rvc);
+  return NULL;
+}
+
+static size_t decode_buffer_parallel(const uint8_t *buf, size_t len,
+    uint64_t base_pc, struct riscv_insn *out, size_t cap, unsigned threads,
+    dispatch_table table, const struct riscv_insn *rvc) {
+  if (threads > RISCV_MAX_THREADS) {
+    threads = RISCV_MAX_THREADS;
+  }
+  if (threads > len / MIN_CHUNK_SIZE) {
+    threads = len / MIN_CHUNK_SIZE;
+  }
+  if (threads <= 1) {
+    return riscv_decode_buffer_with(buf, len, base_pc, out, cap, table, rvc);
+  }
+
+  struct chunk *chunks = calloc(threads, sizeof(*chunks));
+  if (!chunks) {
+    return riscv_decode_buffer_with(buf, len, base_pc, out, cap, table, rvc);
+  }
+
+  size_t chunk_size = (len / threads) & ~(size_t)1;
+  for (unsigned i = 0; i < threads; ++i) {
+    struct chunk *chunk = &chunks[i];
+    chunk->buf = buf;
+    chunk->len = len;
+    chunk->base_pc = base_pc;
+    chunk->start = i * chunk_size;
+    chunk->limit = i + 1 == threads ? len : (i + 1) * chunk_size;
+    chunk->out = out;
+    chunk->table = table;
+    chunk->rvc = rvc;
+  }
+  riscv_run_threads(scan_chunk, chunks, threads, sizeof(*chunks));
+
+  // Follow the true walk through the chunks
+  size_t offset = 0;
+  size_t total = 0;
+  for (unsigned i = 0; i < threads; ++i) {
+    struct chunk *chunk = &chunks[i];
+    const struct chunk_phase *phase = &chunk->phases[offset != chunk->start];
+    chunk->entry = offset;
+    chunk->first = total;
+    chunk->count = phase->count;
+    if (chunk->count > cap - total) {
+      chunk->count = cap - total;
+    }
+    total += chunk->count;
+    offset = phase->end;
+  }
+  riscv_run_threads(decode_chunk, chunks, threads, sizeof(*chunks));
+
+  free(chunks);
+  return total;
+}
+
+size_t riscv_decode_buffer_parallel(const uint8_t *buf, size_t len,
+    uint64_t base_pc, struct riscv_insn *out, size_t cap, unsigned threads) {
+#if defined(SUPPORT_COMPRESSED) && defined(SUPPORT_RV64I)
+  const struct riscv_insn *rvc = rvc_table_rv64;
+#elif defined(SUPPORT_COMPRESSED)
+  const struct riscv_insn *rvc = rvc_table_rv32;
+#else
+  const struct riscv_insn *rvc = NULL;
+#endif
+  return decode_buffer_parallel(buf, len, base_pc, out, cap, threads,
+      riscv_dispatch_table, rvc);
+}
+
+size_t riscv_decoder_decode_buffer_parallel(const struct riscv_decoder *dec,
+    const uint8_t *buf, size_t len, uint64_t base_pc,
+    struct riscv_insn *out, size_t cap, unsigned threads) {
+  return decode_buffer_parallel(buf, len, base_pc, out, cap, threads,
+      (dispatch_table)dec->dispatch, dec->rvc);
+}
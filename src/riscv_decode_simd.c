@@ -0,0 +1,283 @@
+#include "config.h"
+
+#include <string.h>
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#include "decoder_dispatch.h"
+#include "riscv_decode_simd.h"
+#include "riscv_stats.h"
+
+#ifdef RVDEC_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/* Bulk decoding of 32-bit instructions.
+ *
+ * The vector kernels extract the operand fields and the immediates of all six
+ * formats for 8 (AVX2) or 16 (AVX-512) words at once, select the immediate
+ * by the format of each word's major opcode and pack the result into the
+ * 32-bit bitfield union of `struct riscv_insn`. The kind still comes from the
+ * dispatch table, one lookup per word, which also picks out the words (shifts,
+ * FENCE, ECALL/EBREAK) whose operands need the scalar path.
+ *
+ * Packing relies on bitfields being allocated from the least significant bit,
+ * as the SysV ABI specifies; the tests check the result against the scalar
+ * path bit for bit. */
+
+// Format of the immediate of each major opcode, indexed by opcode[6:2]
+static const int32_t OPCODE_TYPES_TABLE[32] = {
+  [0b0000011 >> 2] = INSN_I,
+  [0b0001111 >> 2] = INSN_I,
+  [0b0010011 >> 2] = INSN_I,
+  [0b0010111 >> 2] = INSN_U,
+  [0b0011011 >> 2] = INSN_I,
+  [0b0100011 >> 2] = INSN_S,
+  [0b0110011 >> 2] = INSN_R,
+  [0b0110111 >> 2] = INSN_U,
+  [0b0111011 >> 2] = INSN_R,
+  [0b1100011 >> 2] = INSN_B,
+  [0b1100111 >> 2] = INSN_I,
+  [0b1101111 >> 2] = INSN_J,
+  [0b1110011 >> 2] = INSN_I,
+};
+
+static const uint8_t DISPATCH_TYPES[] = {
+  [DISPATCH_R] = INSN_R,
+  [DISPATCH_I] = INSN_I,
+  [DISPATCH_I_SHAMT_RV32] = INSN_I,
+  [DISPATCH_I_SHAMT_RV64] = INSN_I,
+  [DISPATCH_S] = INSN_S,
+  [DISPATCH_B] = INSN_B,
+  [DISPATCH_U] = INSN_U,
+  [DISPATCH_J] = INSN_J,
+};
+
+static inline void riscv_decode_word(struct riscv_insn *insn, uint32_t repr) {
+  if (riscv_decode32(insn, repr) == RVINSN_ILLEGAL) {
+    insn->type = INSN_UNDEFINED;
+    insn->kind = RVINSN_ILLEGAL;
+    insn->is_compressed = false;
+    insn->length = 4;
+  }
+  RISCV_STATS_KIND(insn->kind);
+}
+
+/* Stores the instruction `repr` whose bitfield union has already been packed
+ * into `fields`. */
+static inline void riscv_store_packed(struct riscv_insn *insn, uint32_t repr,
+    uint32_t fields) {
+  const struct riscv_dispatch_entry *entry =
+    &riscv_dispatch_table[(repr >> 2) & 0b11111][(repr >> 12) & 0b111];
+  int kind = entry->kind[FUNCT7_CLASS_TABLE[repr >> 25]];
+
+  if ((repr & 0b11) != 0b11 || kind == RVINSN_ILLEGAL
+      || entry->format == DISPATCH_NONE) {
+    riscv_decode_word(insn, repr);
+    return;
+  }
+
+  switch (entry->format) {
+    case DISPATCH_I_SHAMT_RV32:
+      fields = (fields & ~0xfffu) | ((repr >> 20) & 0b111111);
+      break;
+    case DISPATCH_I_SHAMT_RV64:
+      fields = (fields & ~0xfffu) | ((repr >> 20) & 0b1111111);
+      break;
+    case DISPATCH_FENCE:
+    case DISPATCH_SYSTEM:
+      riscv_decode_word(insn, repr);
+      return;
+  }
+
+  RISCV_STATS_DISPATCH(repr);
+  RISCV_STATS_KIND(kind);
+  insn->type = DISPATCH_TYPES[entry->format];
+  insn->kind = kind;
+  insn->is_compressed = false;
+  insn->length = 4;
+  memcpy(&insn->r, &fields, sizeof(fields));
+}
+
+#ifdef RVDEC_SIMD_X86
+
+__attribute__((target("avx2")))
+void riscv_decode_words_avx2(const uint32_t *words, size_t n,
+    struct riscv_insn *out) {
+  const __m256i mask5 = _mm256_set1_epi32(0b11111);
+  const __m256i mask12 = _mm256_set1_epi32(0xfff);
+  const __m256i mask20 = _mm256_set1_epi32(0xfffff);
+  uint32_t packed[8];
+
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i w = _mm256_loadu_si256((const __m256i *)(words + i));
+
+    __m256i opcode = _mm256_and_si256(w, _mm256_set1_epi32(0b1111111));
+    __m256i rd = _mm256_and_si256(_mm256_srli_epi32(w, 7), mask5);
+    __m256i funct3 = _mm256_and_si256(_mm256_srli_epi32(w, 12), _mm256_set1_epi32(0b111));
+    __m256i rs1 = _mm256_and_si256(_mm256_srli_epi32(w, 15), mask5);
+    __m256i rs2 = _mm256_and_si256(_mm256_srli_epi32(w, 20), mask5);
+    __m256i funct7 = _mm256_srli_epi32(w, 25);
+
+    // Sign-extended immediates, B and J scaled to bytes
+    __m256i sign = _mm256_srai_epi32(w, 31);
+    __m256i imm_i = _mm256_srai_epi32(w, 20);
+    __m256i imm_s = _mm256_or_si256(
+        _mm256_andnot_si256(mask5, imm_i), rd);
+    __m256i imm_b = _mm256_or_si256(
+        _mm256_or_si256(_mm256_slli_epi32(sign, 12),
+          _mm256_and_si256(_mm256_slli_epi32(w, 4), _mm256_set1_epi32(0x800))),
+        _mm256_or_si256(
+          _mm256_and_si256(_mm256_srli_epi32(w, 20), _mm256_set1_epi32(0x7e0)),
+          _mm256_and_si256(_mm256_srli_epi32(w, 7), _mm256_set1_epi32(0x1e))));
+    __m256i imm_u = _mm256_and_si256(w, _mm256_set1_epi32(0xfffff000));
+    __m256i imm_j = _mm256_or_si256(
+        _mm256_or_si256(_mm256_slli_epi32(sign, 20),
+          _mm256_and_si256(w, _mm256_set1_epi32(0xff000))),
+        _mm256_or_si256(
+          _mm256_and_si256(_mm256_srli_epi32(w, 9), _mm256_set1_epi32(0x800)),
+          _mm256_and_si256(_mm256_srli_epi32(w, 20), _mm256_set1_epi32(0x7fe))));
+
+    // Bitfield unions of each format
+    __m256i rd_op = _mm256_or_si256(_mm256_slli_epi32(rd, 20), _mm256_slli_epi32(opcode, 25));
+    __m256i rs1_f3 = _mm256_or_si256(_mm256_slli_epi32(rs1, 12), _mm256_slli_epi32(funct3, 17));
+    __m256i sb_regs = _mm256_or_si256(
+        _mm256_or_si256(_mm256_slli_epi32(rs2, 12), _mm256_slli_epi32(rs1, 17)),
+        _mm256_or_si256(_mm256_slli_epi32(funct3, 22), _mm256_slli_epi32(opcode, 25)));
+    __m256i r = _mm256_or_si256(_mm256_or_si256(funct7, _mm256_slli_epi32(rs2, 7)),
+        _mm256_or_si256(rs1_f3, rd_op));
+    __m256i fi = _mm256_or_si256(_mm256_and_si256(imm_i, mask12),
+        _mm256_or_si256(rs1_f3, rd_op));
+    __m256i fs = _mm256_or_si256(_mm256_and_si256(imm_s, mask12), sb_regs);
+    __m256i fb = _mm256_or_si256(
+        _mm256_and_si256(_mm256_srai_epi32(imm_b, 1), mask12), sb_regs);
+    __m256i fu = _mm256_or_si256(
+        _mm256_and_si256(_mm256_srli_epi32(imm_u, 12), mask20), rd_op);
+    __m256i fj = _mm256_or_si256(
+        _mm256_and_si256(_mm256_srai_epi32(imm_j, 1), mask20), rd_op);
+
+    __m256i type = _mm256_i32gather_epi32(OPCODE_TYPES_TABLE,
+        _mm256_srli_epi32(opcode, 2), 4);
+    __m256i fields = r;
+    fields = _mm256_blendv_epi8(fields, fi,
+        _mm256_cmpeq_epi32(type, _mm256_set1_epi32(INSN_I)));
+    fields = _mm256_blendv_epi8(fields, fs,
+        _mm256_cmpeq_epi32(type, _mm256_set1_epi32(INSN_S)));
+    fields = _mm256_blendv_epi8(fields, fb,
+        _mm256_cmpeq_epi32(type, _mm256_set1_epi32(INSN_B)));
+    fields = _mm256_blendv_epi8(fields, fu,
+        _mm256_cmpeq_epi32(type, _mm256_set1_epi32(INSN_U)));
+    fields = _mm256_blendv_epi8(fields, fj,
+        _mm256_cmpeq_epi32(type, _mm256_set1_epi32(INSN_J)));
+    _mm256_storeu_si256((__m256i *)packed, fields);
+
+    for (int lane = 0; lane < 8; ++lane) {
+      riscv_store_packed(&out[i + lane], words[i + lane], packed[lane]);
+    }
+  }
+
+  for (; i < n; ++i) {
+    riscv_decode_word(&out[i], words[i]);
+  }
+}
+
+__attribute__((target("avx512f")))
+void riscv_decode_words_avx512(const uint32_t *words, size_t n,
+    struct riscv_insn *out) {
+  const __m512i mask5 = _mm512_set1_epi32(0b11111);
+  const __m512i mask12 = _mm512_set1_epi32(0xfff);
+  const __m512i mask20 = _mm512_set1_epi32(0xfffff);
+  const __m512i types_lo = _mm512_loadu_si512(OPCODE_TYPES_TABLE);
+  const __m512i types_hi = _mm512_loadu_si512(OPCODE_TYPES_TABLE + 16);
+  uint32_t packed[16];
+
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i w = _mm512_loadu_si512(words + i);
+
+    __m512i opcode = _mm512_and_si512(w, _mm512_set1_epi32(0b1111111));
+    __m512i rd = _mm512_and_si512(_mm512_srli_epi32(w, 7), mask5);
+    __m512i funct3 = _mm512_and_si512(_mm512_srli_epi32(w, 12), _mm512_set1_epi32(0b111));
+    __m512i rs1 = _mm512_and_si512(_mm512_srli_epi32(w, 15), mask5);
+    __m512i rs2 = _mm512_and_si512(_mm512_srli_epi32(w, 20), mask5);
+    __m512i funct7 = _mm512_srli_epi32(w, 25);
+
+    // Sign-extended immediates, B and J scaled to bytes
+    __m512i sign = _mm512_srai_epi32(w, 31);
+    __m512i imm_i = _mm512_srai_epi32(w, 20);
+    __m512i imm_s = _mm512_or_si512(_mm512_andnot_si512(mask5, imm_i), rd);
+    __m512i imm_b = _mm512_or_si512(
+        _mm512_or_si512(_mm512_slli_epi32(sign, 12),
+          _mm512_and_si512(_mm512_slli_epi32(w, 4), _mm512_set1_epi32(0x800))),
+        _mm512_or_si512(
+          _mm512_and_si512(_mm512_srli_epi32(w, 20), _mm512_set1_epi32(0x7e0)),
+          _mm512_and_si512(_mm512_srli_epi32(w, 7), _mm512_set1_epi32(0x1e))));
+    __m512i imm_u = _mm512_and_si512(w, _mm512_set1_epi32(0xfffff000));
+    __m512i imm_j = _mm512_or_si512(
+        _mm512_or_si512(_mm512_slli_epi32(sign, 20),
+          _mm512_and_si512(w, _mm512_set1_epi32(0xff000))),
+        _mm512_or_si512(
+          _mm512_and_si512(_mm512_srli_epi32(w, 9), _mm512_set1_epi32(0x800)),
+          _mm512_and_si512(_mm512_srli_epi32(w, 20), _mm512_set1_epi32(0x7fe))));
+
+    // Bitfield unions of each format
+    __m512i rd_op = _mm512_or_si512(_mm512_slli_epi32(rd, 20), _mm512_slli_epi32(opcode, 25));
+    __m512i rs1_f3 = _mm512_or_si512(_mm512_slli_epi32(rs1, 12), _mm512_slli_epi32(funct3, 17));
+    __m512i sb_regs = _mm512_or_si512(
+        _mm512_or_si512(_mm512_slli_epi32(rs2, 12), _mm512_slli_epi32(rs1, 17)),
+        _mm512_or_si512(_mm512_slli_epi32(funct3, 22), _mm512_slli_epi32(opcode, 25)));
+    __m512i r = _mm512_or_si512(_mm512_or_si512(funct7, _mm512_slli_epi32(rs2, 7)),
+        _mm512_or_si512(rs1_f3, rd_op));
+    __m512i fi = _mm512_or_si512(_mm512_and_si512(imm_i, mask12),
+        _mm512_or_si512(rs1_f3, rd_op));
+    __m512i fs = _mm512_or_si512(_mm512_and_si512(imm_s, mask12), sb_regs);
+    __m512i fb = _mm512_or_si512(
+        _mm512_and_si512(_mm512_srai_epi32(imm_b, 1), mask12), sb_regs);
+    __m512i fu = _mm512_or_si512(
+        _mm512_and_si512(_mm512_srli_epi32(imm_u, 12), mask20), rd_op);
+    __m512i fj = _mm512_or_si512(
+        _mm512_and_si512(_mm512_srai_epi32(imm_j, 1), mask20), rd_op);
+
+    __m512i type = _mm512_permutex2var_epi32(types_lo,
+        _mm512_srli_epi32(opcode, 2), types_hi);
+    __m512i fields = r;
+    fields = _mm512_mask_mov_epi32(fields,
+        _mm512_cmpeq_epi32_mask(type, _mm512_set1_epi32(INSN_I)), fi);
+    fields = _mm512_mask_mov_epi32(fields,
+        _mm512_cmpeq_epi32_mask(type, _mm512_set1_epi32(INSN_S)), fs);
+    fields = _mm512_mask_mov_epi32(fields,
+        _mm512_cmpeq_epi32_mask(type, _mm512_set1_epi32(INSN_B)), fb);
+    fields = _mm512_mask_mov_epi32(fields,
+        _mm512_cmpeq_epi32_mask(type, _mm512_set1_epi32(INSN_U)), fu);
+    fields = _mm512_mask_mov_epi32(fields,
+        _mm512_cmpeq_epi32_mask(type, _mm512_set1_epi32(INSN_J)), fj);
+    _mm512_storeu_si512(packed, fields);
+
+    for (int lane = 0; lane < 16; ++lane) {
+      riscv_store_packed(&out[i + lane], words[i + lane], packed[lane]);
+    }
+  }
+
+  riscv_decode_words_avx2(words + i, n - i, out + i);
+}
+
+#endif // RVDEC_SIMD_X86
+
+void riscv_decode_words(const uint32_t *words, size_t n, struct riscv_insn *out) {
+#ifdef RVDEC_SIMD_X86
+  if (__builtin_cpu_supports("avx512f")) {
+    riscv_decode_words_avx512(words, n, out);
+    return;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    riscv_decode_words_avx2(words, n, out);
+    return;
+  }
+#endif // RVDEC_SIMD_X86
+
+  for (size_t i = 0; i < n; ++i) {
+    riscv_decode_word(&out[i], words[i]);
+  }
+}
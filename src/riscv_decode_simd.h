@@ -0,0 +1,31 @@
+#ifndef RISCV_DECODE_SIMD_H
+#define RISCV_DECODE_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rvdec/instruction.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RVDEC_SIMD_X86
+
+/* Kernels riscv_decode_words() picks between, with the same contract. They
+ * are visible so the tests can run each one whatever the host would pick;
+ * callers check __builtin_cpu_supports() first. The AVX-512 kernel hands its
+ * last n % 16 words to the AVX2 one. */
+void riscv_decode_words_avx2(const uint32_t *words, size_t n,
+    struct riscv_insn *out);
+void riscv_decode_words_avx512(const uint32_t *words, size_t n,
+    struct riscv_insn *out);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_DECODE_SIMD_H
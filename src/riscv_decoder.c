@@ -0,0 +1,99 @@
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#include "decoder_dispatch.h"
+#include "riscv_stats.h"
+#include "rvc_table.h"
+
+typedef const struct riscv_dispatch_entry (*dispatch_table)[8];
+
+int riscv_decoder_init(struct riscv_decoder *dec, unsigned xlen,
+    uint32_t extensions) {
+  int has_m = (extensions & RISCV_EXT_M) != 0;
+
+  if (extensions & ~(uint32_t)(RISCV_EXT_M | RISCV_EXT_C)) {
+    return 0;
+  }
+
+  switch (xlen) {
+#ifdef SUPPORT_RV32I
+    case 32:
+#ifndef SUPPORT_RV32M
+      if (has_m) {
+        return 0;
+      }
+#endif // SUPPORT_RV32M
+      dec->dispatch = has_m ? riscv_dispatch_rv32im : riscv_dispatch_rv32i;
+      break;
+#endif // SUPPORT_RV32I
+#ifdef SUPPORT_RV64I
+    case 64:
+#ifndef SUPPORT_RV64M
+      if (has_m) {
+        return 0;
+      }
+#endif // SUPPORT_RV64M
+      dec->dispatch = has_m ? riscv_dispatch_rv64im : riscv_dispatch_rv64i;
+      break;
+#endif // SUPPORT_RV64I
+    default:
+      return 0;
+  }
+
+  dec->rvc = NULL;
+  if (extensions & RISCV_EXT_C) {
+#ifdef SUPPORT_COMPRESSED
+    dec->rvc = xlen == 64 ? rvc_table_rv64 : rvc_table_rv32;
+#else
+    return 0;
+#endif // SUPPORT_COMPRESSED
+  }
+
+  dec->xlen = xlen;
+  dec->extensions = extensions;
+  return 1;
+}
+
+int riscv_decoder_decode(const struct riscv_decoder *dec,
+    struct riscv_insn *insn, uint32_t repr) {
+  if (riscv_decode32_with(insn, repr, (dispatch_table)dec->dispatch)
+      != RVINSN_ILLEGAL) {
+    RISCV_STATS_KIND(insn->kind);
+    return insn->kind;
+  }
+
+  // Same fallback to the upper halfword as riscv_decode()
+  if (dec->rvc) {
+    const struct riscv_insn *entry = &dec->rvc[(repr >> 16) & 0xffff];
+    RISCV_STATS_RVC_FALLBACK();
+    RISCV_STATS_RVC(repr >> 16, entry->kind);
+    if (entry->kind != RVINSN_ILLEGAL) {
+      uint64_t pc = insn->pc;
+      *insn = *entry;
+      insn->pc = pc;
+      RISCV_STATS_KIND(insn->kind);
+      return insn->kind;
+    }
+    insn->is_compressed = false;
+  }
+
+  insn->kind = RVINSN_ILLEGAL;
+  RISCV_STATS_KIND(RVINSN_ILLEGAL);
+  return insn->kind;
+}
+
+size_t riscv_decoder_decode_buffer(const struct riscv_decoder *dec,
+    const uint8_t *buf, size_t len, uint64_t base_pc,
+    struct riscv_insn *out, size_t cap) {
+  return riscv_decode_buffer_with(buf, len, base_pc, out, cap,
+      (dispatch_table)dec->dispatch, dec->rvc);
+}
+
+size_t riscv_decoder_decode_block(const struct riscv_decoder *dec,
+    const uint8_t *buf, size_t len, uint64_t pc,
+    struct riscv_insn *out, size_t cap, struct riscv_block *block) {
+  return riscv_decode_block_with(buf, len, pc, out, cap, block,
+      (dispatch_table)dec->dispatch, dec->rvc);
+}
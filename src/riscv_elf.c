@@ -0,0 +1,223 @@
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rvdec/decode.h>
+#include <rvdec/elf.h>
+
+#include "riscv_bytes.h"
+#include "riscv_map.h"
+
+/* Fields are read with riscv_read_le(), so the reader works whatever the
+ * alignment of the data and the byte order of the host. Only the fields the
+ * reader uses are described. */
+
+#define EI_CLASS 4
+#define EI_DATA 5
+#define ELFCLASS32 1
+#define ELFCLASS64 2
+#define ELFDATA2LSB 1
+#define EM_RISCV 243
+#define EF_RISCV_RVC 0x1
+
+#define SHT_NOBITS 8
+#define SHF_EXECINSTR 0x4
+#define PT_LOAD 1
+#define PF_X 0x1
+
+// Offsets and sizes of the header fields, which differ between the classes
+struct elf_layout {
+  int word;
+  size_t ehdr_size;
+  size_t e_entry, e_phoff, e_shoff, e_flags;
+  size_t e_phentsize, e_phnum, e_shentsize, e_shnum, e_shstrndx;
+  size_t phdr_size;
+  size_t p_type, p_flags, p_offset, p_vaddr, p_filesz;
+  size_t shdr_size;
+  size_t sh_name, sh_type, sh_flags, sh_addr, sh_offset, sh_size;
+};
+
+static const struct elf_layout layout32 = {
+  4, 52,
+  24, 28, 32, 36,
+  42, 44, 46, 48, 50,
+  32,
+  0, 24, 4, 8, 16,
+  40,
+  0, 4, 8, 12, 16, 20,
+};
+
+static const struct elf_layout layout64 = {
+  8, 64,
+  24, 32, 40, 48,
+  54, 56, 58, 60, 62,
+  56,
+  0, 4, 8, 16, 32,
+  64,
+  0, 4, 8, 16, 24, 32,
+};
+
+// Whether [offset, offset + size) lies within a file of `len` bytes
+static bool in_file(uint64_t offset, uint64_t size, size_t len) {
+  return offset <= len && size <= len - offset;
+}
+
+static int read_segments(struct riscv_elf *elf, const struct elf_layout *l) {
+  const uint8_t *d = elf->data;
+  uint64_t phoff = riscv_read_le(d + l->e_phoff, l->word);
+  uint64_t phentsize = riscv_read_le(d + l->e_phentsize, 2);
+  uint64_t phnum = riscv_read_le(d + l->e_phnum, 2);
+  if (phnum == 0) {
+    return 1;
+  }
+  if (phentsize < l->phdr_size || !in_file(phoff, phentsize * phnum, elf->size)) {
+    return 0;
+  }
+
+  elf->segments = calloc(phnum, sizeof(*elf->segments));
+  if (!elf->segments) {
+    return 0;
+  }
+  for (uint64_t i = 0; i < phnum; ++i) {
+    const uint8_t *ph = d + phoff + i * phentsize;
+    if (riscv_read_le(ph + l->p_type, 4) != PT_LOAD
+        || !(riscv_read_le(ph + l->p_flags, 4) & PF_X)) {
+      continue;
+    }
+    uint64_t offset = riscv_read_le(ph + l->p_offset, l->word);
+    uint64_t size = riscv_read_le(ph + l->p_filesz, l->word);
+    if (!in_file(offset, size, elf->size)) {
+      return 0;
+    }
+    struct riscv_elf_span *span = &elf->segments[elf->nsegments++];
+    span->data = d + offset;
+    span->size = size;
+    span->addr = riscv_read_le(ph + l->p_vaddr, l->word);
+    span->name = NULL;
+  }
+  return 1;
+}
+
+static int read_sections(struct riscv_elf *elf, const struct elf_layout *l) {
+  const uint8_t *d = elf->data;
+  uint64_t shoff = riscv_read_le(d + l->e_shoff, l->word);
+  uint64_t shentsize = riscv_read_le(d + l->e_shentsize, 2);
+  uint64_t shnum = riscv_read_le(d + l->e_shnum, 2);
+  uint64_t shstrndx = riscv_read_le(d + l->e_shstrndx, 2);
+  if (shnum == 0) {
+    return 1;
+  }
+  if (shentsize < l->shdr_size || !in_file(shoff, shentsize * shnum, elf->size)) {
+    return 0;
+  }
+
+  // Names are only used if the string table is sound
+  const char *names = NULL;
+  uint64_t names_size = 0;
+  if (shstrndx < shnum) {
+    const uint8_t *sh = d + shoff + shstrndx * shentsize;
+    uint64_t offset = riscv_read_le(sh + l->sh_offset, l->word);
+    uint64_t size = riscv_read_le(sh + l->sh_size, l->word);
+    if (size > 0 && in_file(offset, size, elf->size)
+        && d[offset + size - 1] == '\0') {
+      names = (const char *)d + offset;
+      names_size = size;
+    }
+  }
+
+  elf->sections = calloc(shnum, sizeof(*elf->sections));
+  if (!elf->sections) {
+    return 0;
+  }
+  for (uint64_t i = 0; i < shnum; ++i) {
+    const uint8_t *sh = d + shoff + i * shentsize;
+    if (riscv_read_le(sh + l->sh_type, 4) == SHT_NOBITS
+        || !(riscv_read_le(sh + l->sh_flags, l->word) & SHF_EXECINSTR)) {
+      continue;
+    }
+    uint64_t offset = riscv_read_le(sh + l->sh_offset, l->word);
+    uint64_t size = riscv_read_le(sh + l->sh_size, l->word);
+    if (!in_file(offset, size, elf->size)) {
+      return 0;
+    }
+    uint64_t name = riscv_read_le(sh + l->sh_name, 4);
+    struct riscv_elf_span *span = &elf->sections[elf->nsections++];
+    span->data = d + offset;
+    span->size = size;
+    span->addr = riscv_read_le(sh + l->sh_addr, l->word);
+    span->name = names && name < names_size ? names + name : NULL;
+  }
+  return 1;
+}
+
+int riscv_elf_parse(struct riscv_elf *elf, const void *data, size_t size) {
+  memset(elf, 0, sizeof(*elf));
+  elf->data = data;
+  elf->size = size;
+
+  const uint8_t *d = data;
+  if (size < 16 || memcmp(d, "\177ELF", 4) != 0 || d[EI_DATA] != ELFDATA2LSB) {
+    return 0;
+  }
+
+  const struct elf_layout *l;
+  switch (d[EI_CLASS]) {
+    case ELFCLASS32:
+      l = &layout32;
+      elf->xlen = 32;
+      break;
+    case ELFCLASS64:
+      l = &layout64;
+      elf->xlen = 64;
+      break;
+    default:
+      return 0;
+  }
+  if (size < l->ehdr_size || riscv_read_le(d + 18, 2) != EM_RISCV) {
+    return 0;
+  }
+
+  elf->flags = riscv_read_le(d + l->e_flags, 4);
+  elf->rvc = (elf->flags & EF_RISCV_RVC) != 0;
+  elf->entry = riscv_read_le(d + l->e_entry, l->word);
+
+  if (!read_segments(elf, l) || !read_sections(elf, l)) {
+    riscv_elf_close(elf);
+    return 0;
+  }
+  return 1;
+}
+
+int riscv_elf_open(struct riscv_elf *elf, const char *path) {
+  memset(elf, 0, sizeof(*elf));
+
+  size_t size;
+  const void *data = riscv_map_file(path, &size);
+  if (!data) {
+    return 0;
+  }
+  if (!riscv_elf_parse(elf, data, size)) {
+    riscv_unmap_file(data, size);
+    return 0;
+  }
+  elf->mapped = true;
+  return 1;
+}
+
+void riscv_elf_close(struct riscv_elf *elf) {
+  free(elf->sections);
+  free(elf->segments);
+  if (elf->mapped) {
+    riscv_unmap_file(elf->data, elf->size);
+  }
+  memset(elf, 0, sizeof(*elf));
+}
+
+int riscv_elf_decoder_init(const struct riscv_elf *elf,
+    struct riscv_decoder *dec, uint32_t extensions) {
+  if (elf->rvc) {
+    extensions |= RISCV_EXT_C;
+  }
+  return riscv_decoder_init(dec, elf->xlen, extensions);
+}
@@ -0,0 +1,226 @@
+#include "config.h"
+
+#include <string.h>
+
+#include <rvdec/format.h>
+#include <rvdec/instruction.h>
+
+#include "insn_table.h"
+#include "riscv_operands.h"
+
+/* The writers below store whole fixed-size strings and step past only the
+ * meaningful part, so they may write up to 7 bytes past the end of the text.
+ * RISCV_FORMAT_MAX and RISCV_FORMAT_LINE_MAX leave room for that. */
+
+struct reg_name {
+  char name[4];
+  uint8_t length;
+};
+
+static const struct reg_name reg_names[32] = {
+  { "zero", 4 }, { "ra", 2 }, { "sp", 2 }, { "gp", 2 },
+  { "tp", 2 }, { "t0", 2 }, { "t1", 2 }, { "t2", 2 },
+  { "s0", 2 }, { "s1", 2 }, { "a0", 2 }, { "a1", 2 },
+  { "a2", 2 }, { "a3", 2 }, { "a4", 2 }, { "a5", 2 },
+  { "a6", 2 }, { "a7", 2 }, { "s2", 2 }, { "s3", 2 },
+  { "s4", 2 }, { "s5", 2 }, { "s6", 2 }, { "s7", 2 },
+  { "s8", 2 }, { "s9", 2 }, { "s10", 3 }, { "s11", 3 },
+  { "t3", 2 }, { "t4", 2 }, { "t5", 2 }, { "t6", 2 },
+};
+
+static const char hex_digits[16] = "0123456789abcdef";
+
+static inline char *put_reg(char *p, unsigned reg) {
+  memcpy(p, reg_names[reg].name, 4);
+  return p + reg_names[reg].length;
+}
+
+static inline char *put_dec(char *p, int64_t value) {
+  uint64_t u = value;
+  if (value < 0) {
+    *p++ = '-';
+    u = -u;
+  }
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u != 0);
+  while (n > 0) {
+    *p++ = digits[--n];
+  }
+  return p;
+}
+
+static inline int hex_length(uint64_t value) {
+  int n = 1;
+  while (n < 16 && value >> (4 * n) != 0) {
+    ++n;
+  }
+  return n;
+}
+
+static inline char *put_hex(char *p, uint64_t value) {
+  int n = hex_length(value);
+  for (int i = n - 1; i >= 0; --i) {
+    p[i] = hex_digits[value & 0xf];
+    value >>= 4;
+  }
+  return p + n;
+}
+
+static inline char *put_hex_0x(char *p, uint64_t value) {
+  *p++ = '0';
+  *p++ = 'x';
+  return put_hex(p, value);
+}
+
+// `imm(rs1)`
+static inline char *put_address(char *p, int32_t imm, unsigned rs1) {
+  p = put_dec(p, imm);
+  *p++ = '(';
+  p = put_reg(p, rs1);
+  *p++ = ')';
+  return p;
+}
+
+// FENCE predecessor or successor set, `0` if empty
+static inline char *put_fence_set(char *p, unsigned set) {
+  if (set == 0) {
+    *p++ = '0';
+    return p;
+  }
+  static const char letters[4] = { 'w', 'r', 'o', 'i' };
+  for (int bit = 3; bit >= 0; --bit) {
+    if (set & (1 << bit)) {
+      *p++ = letters[bit];
+    }
+  }
+  return p;
+}
+
+/* Writes the text of `insn` at `p`, without a NUL, and returns its end. */
+static char *format_insn(char *p, const struct riscv_insn *insn, uint64_t pc) {
+  int kind = insn->kind;
+  if (kind < 0 || kind > RVINSN_ILLEGAL) {
+    kind = RVINSN_ILLEGAL;
+  }
+  const struct riscv_mnemonic *m = &riscv_mnemonics[kind];
+  if (kind == RVINSN_ILLEGAL) {
+    memcpy(p, m->name, sizeof(m->name));
+    return p + m->length;
+  }
+
+  struct riscv_operands ops;
+  riscv_operands_of(insn, &ops);
+
+  if (m->syntax == SYNTAX_FENCE && ops.imm == 0x833) {
+    memcpy(p, "fence.tso", 9);
+    return p + 9;
+  }
+
+  memcpy(p, m->name, sizeof(m->name));
+  p += m->length;
+  if (m->syntax == SYNTAX_NONE) {
+    return p;
+  }
+  *p++ = '\t';
+
+  switch (m->syntax) {
+    case SYNTAX_R:
+      p = put_reg(p, ops.rd);
+      *p++ = ',';
+      p = put_reg(p, ops.rs1);
+      *p++ = ',';
+      p = put_reg(p, ops.rs2);
+      break;
+    case SYNTAX_I:
+      p = put_reg(p, ops.rd);
+      *p++ = ',';
+      p = put_reg(p, ops.rs1);
+      *p++ = ',';
+      p = put_dec(p, ops.imm);
+      break;
+    case SYNTAX_SHIFT:
+      p = put_reg(p, ops.rd);
+      *p++ = ',';
+      p = put_reg(p, ops.rs1);
+      *p++ = ',';
+      p = put_hex_0x(p, ops.imm & 0x3f);
+      break;
+    case SYNTAX_LOAD:
+      p = put_reg(p, ops.rd);
+      *p++ = ',';
+      p = put_address(p, ops.imm, ops.rs1);
+      break;
+    case SYNTAX_STORE:
+      p = put_reg(p, ops.rs2);
+      *p++ = ',';
+      p = put_address(p, ops.imm, ops.rs1);
+      break;
+    case SYNTAX_BRANCH:
+      p = put_reg(p, ops.rs1);
+      *p++ = ',';
+      p = put_reg(p, ops.rs2);
+      *p++ = ',';
+      p = put_hex(p, pc + (int64_t)ops.imm);
+      break;
+    case SYNTAX_U:
+      p = put_reg(p, ops.rd);
+      *p++ = ',';
+      p = put_hex_0x(p, (uint32_t)ops.imm >> 12);
+      break;
+    case SYNTAX_JUMP:
+      p = put_reg(p, ops.rd);
+      *p++ = ',';
+      p = put_hex(p, pc + (int64_t)ops.imm);
+      break;
+    case SYNTAX_FENCE:
+      p = put_fence_set(p, (ops.imm >> 4) & 0xf);
+      *p++ = ',';
+      p = put_fence_set(p, ops.imm & 0xf);
+      break;
+  }
+  return p;
+}
+
+size_t riscv_format(const struct riscv_insn *insn, uint64_t pc, char *buf,
+    size_t cap) {
+  if (cap >= RISCV_FORMAT_MAX) {
+    char *end = format_insn(buf, insn, pc);
+    *end = '\0';
+    return end - buf;
+  }
+
+  char text[RISCV_FORMAT_MAX];
+  size_t length = format_insn(text, insn, pc) - text;
+  if (cap > 0) {
+    size_t n = length < cap - 1 ? length : cap - 1;
+    memcpy(buf, text, n);
+    buf[n] = '\0';
+  }
+  return length;
+}
+
+size_t riscv_format_batch(const struct riscv_insn *insns, size_t count,
+    char *buf, size_t cap, size_t *length) {
+  char *p = buf;
+  size_t i = 0;
+  for (; i < count && cap - (size_t)(p - buf) >= RISCV_FORMAT_LINE_MAX; ++i) {
+    const struct riscv_insn *insn = &insns[i];
+    // Addresses are right-aligned in 8 columns like objdump's
+    int n = hex_length(insn->pc);
+    if (n < 8) {
+      memset(p, ' ', 8);
+      p += 8 - n;
+    }
+    p = put_hex(p, insn->pc);
+    *p++ = ':';
+    *p++ = '\t';
+    p = format_insn(p, insn, insn->pc);
+    *p++ = '\n';
+  }
+  *length = p - buf;
+  return i;
+}
@@ -1,14 +1,10 @@
 #include <limits.h>
+#include <string.h>
 
 #include <rvdec/instruction.h>
 
-static const char *reg_names[] = {
-  "zero", "ra", "sp", "gp", "tp", "t0",
-  "t1", "t2", "s0/fp", "s1", "a0", "a1",
-  "a2", "a3", "a4", "a5", "a6", "a7", "s2",
-  "s3", "s4", "s5", "s6", "s7", "s8", "s9",
-  "s10", "s11", "t3", "t4", "t5", "t6"
-};
+#include "riscv_operands.h"
+#include "riscv_regs.h"
 
 static const char *freg_names[] = {
   "ft0", "ft1", "ft2", "ft3", "ft4", "ft5",
@@ -117,3 +113,97 @@ int riscv_try_decode_fence(struct riscv_insn *insn, uint32_t repr,
   insn->fence.opcode = 0b0001111;
   return 1;
 }
+
+void riscv_insn_operands(const struct riscv_insn *insn, struct riscv_operands *ops) {
+  riscv_operands_of(insn, ops);
+}
+
+void riscv_insn_regs(const struct riscv_insn *insn, struct riscv_reg_masks *masks) {
+  struct riscv_slot_regs regs;
+  riscv_slot_regs_of(insn, &regs);
+  masks->read = ((uint64_t)1 << regs.rs1 | (uint64_t)1 << regs.rs2) & ~(uint64_t)1;
+  masks->write = ((uint64_t)1 << regs.rd) & ~(uint64_t)1;
+}
+
+void riscv_insn_pack(const struct riscv_insn *insn, struct riscv_insn_packed *packed) {
+  struct riscv_operands ops;
+  riscv_operands_of(insn, &ops);
+  packed->kind = insn->kind;
+  packed->regs = RISCV_PACKED_REGS(ops.rd, ops.rs1, ops.rs2, insn->length == 2);
+  packed->imm = ops.imm;
+}
+
+void riscv_insn_unpack(const struct riscv_insn_packed *packed, struct riscv_insn *insn) {
+  int kind = packed->kind;
+  bool compressed = riscv_packed_is_compressed(packed);
+  uint32_t rd = riscv_packed_rd(packed);
+  uint32_t rs1 = riscv_packed_rs1(packed);
+  uint32_t rs2 = riscv_packed_rs2(packed);
+  int32_t imm = packed->imm;
+  // Compressed instructions are expanded without the fixed fields
+  uint32_t match = 0;
+  int type = INSN_UNDEFINED;
+  if (kind != RVINSN_ILLEGAL) {
+    match = compressed ? 0 : riscv_encodings[kind].match;
+    type = riscv_encodings[kind].type;
+  }
+  uint32_t opcode = match & 0b1111111;
+  uint32_t funct3 = (match >> 12) & 0b111;
+  uint32_t funct7 = (match >> 25) & 0b1111111;
+
+  memset(insn, 0, sizeof(*insn));
+  insn->type = type;
+  insn->kind = kind;
+  insn->is_compressed = compressed && kind != RVINSN_ILLEGAL;
+  insn->length = riscv_packed_length(packed);
+  switch (insn->type) {
+    case INSN_R:
+      insn->r.funct7 = funct7;
+      insn->r.rs2 = rs2;
+      insn->r.rs1 = rs1;
+      insn->r.funct3 = funct3;
+      insn->r.rd = rd;
+      insn->r.opcode = opcode;
+      break;
+    case INSN_I:
+      insn->i.imm = imm;
+      insn->i.rs1 = rs1;
+      insn->i.funct3 = funct3;
+      insn->i.rd = rd;
+      insn->i.opcode = opcode;
+      break;
+    case INSN_S:
+      insn->s.imm = imm;
+      insn->s.rs2 = rs2;
+      insn->s.rs1 = rs1;
+      insn->s.funct3 = funct3;
+      insn->s.opcode = opcode;
+      break;
+    case INSN_B:
+      insn->b.imm = compressed ? imm : imm >> 1;
+      insn->b.rs2 = rs2;
+      insn->b.rs1 = rs1;
+      insn->b.funct3 = funct3;
+      insn->b.opcode = opcode;
+      break;
+    case INSN_U:
+      insn->u.imm = imm >> 12;
+      insn->u.rd = rd;
+      insn->u.opcode = opcode;
+      break;
+    case INSN_J:
+      insn->j.imm = compressed ? imm : imm >> 1;
+      insn->j.rd = rd;
+      insn->j.opcode = opcode;
+      break;
+    case INSN_FENCE:
+      insn->fence.fm = (imm >> 8) & 0b1111;
+      insn->fence.pred = (imm >> 4) & 0b1111;
+      insn->fence.succ = imm & 0b1111;
+      insn->fence.rs1 = rs1;
+      insn->fence.funct3 = funct3;
+      insn->fence.rd = rd;
+      insn->fence.opcode = opcode;
+      break;
+  }
+}
@@ -0,0 +1,32 @@
+#include "config.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "riscv_map.h"
+
+const void *riscv_map_file(const char *path, size_t *size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return NULL;
+  }
+  void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file open
+  close(fd);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+  *size = st.st_size;
+  return data;
+}
+
+void riscv_unmap_file(const void *data, size_t size) {
+  munmap((void *)data, size);
+}
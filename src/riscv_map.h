@@ -0,0 +1,11 @@
+#ifndef RISCV_MAP_H
+#define RISCV_MAP_H
+
+#include <stddef.h>
+
+/* Maps the file at `path` read-only and stores its size to `*size`. Returns
+ * NULL if it can't be opened or mapped, or is empty. */
+const void *riscv_map_file(const char *path, size_t *size);
+void riscv_unmap_file(const void *data, size_t size);
+
+#endif // RISCV_MAP_H
@@ -0,0 +1,54 @@
+#ifndef RISCV_OPERANDS_H
+#define RISCV_OPERANDS_H
+
+#include <rvdec/instruction.h>
+
+/* Body of riscv_insn_operands(), inlined into the batch decoders so that
+ * picking the operands out of the union doesn't cost a call per
+ * instruction. */
+static inline void riscv_operands_of(const struct riscv_insn *insn,
+    struct riscv_operands *ops) {
+  ops->rd = 0;
+  ops->rs1 = 0;
+  ops->rs2 = 0;
+  ops->imm = 0;
+  switch (insn->type) {
+    case INSN_R:
+      ops->rd = insn->r.rd;
+      ops->rs1 = insn->r.rs1;
+      ops->rs2 = insn->r.rs2;
+      break;
+    case INSN_I:
+      ops->rd = insn->i.rd;
+      ops->rs1 = insn->i.rs1;
+      ops->imm = insn->i.imm;
+      break;
+    case INSN_S:
+      ops->rs1 = insn->s.rs1;
+      ops->rs2 = insn->s.rs2;
+      ops->imm = insn->s.imm;
+      break;
+    case INSN_B:
+      ops->rs1 = insn->b.rs1;
+      ops->rs2 = insn->b.rs2;
+      // Compressed branches are expanded with the offset already in bytes
+      ops->imm = insn->is_compressed ? insn->b.imm : insn->b.imm * 2;
+      break;
+    case INSN_U:
+      ops->rd = insn->u.rd;
+      ops->imm = (int32_t)((uint32_t)insn->u.imm << 12);
+      break;
+    case INSN_J:
+      ops->rd = insn->j.rd;
+      // Compressed jumps are expanded with the offset already in bytes
+      ops->imm = insn->is_compressed ? insn->j.imm : insn->j.imm * 2;
+      break;
+    case INSN_FENCE:
+      ops->rd = insn->fence.rd;
+      ops->rs1 = insn->fence.rs1;
+      ops->imm = (insn->fence.fm << 8) | (insn->fence.pred << 4) | insn->fence.succ;
+      break;
+  }
+}
+
+#endif // RISCV_OPERANDS_H
@@ -0,0 +1,307 @@
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/page_cache.h>
+
+#include "decoder_dispatch.h"
+#include "rvc_table.h"
+
+typedef const struct riscv_dispatch_entry (*dispatch_table)[8];
+
+#define NO_PAGE UINT32_MAX
+
+struct page_meta {
+  // Page address, valid while the page is in the index
+  uint64_t base;
+  // Next page in the same hash bucket
+  uint32_t hash_next;
+  // Neighbours in the LRU list, most recently used first
+  uint32_t lru_prev;
+  uint32_t lru_next;
+  bool valid;
+};
+
+struct riscv_page_cache {
+  dispatch_table table;
+  const struct riscv_insn *rvc;
+  riscv_fetch_fn fetch;
+  void *ctx;
+
+  uint32_t npages;
+  struct page_meta *meta;
+  struct riscv_insn (*pages)[RISCV_PAGE_SLOTS];
+
+  uint32_t *buckets;
+  uint32_t bucket_mask;
+
+  uint32_t lru_head;
+  uint32_t lru_tail;
+
+  // Page of the last lookup, the head of the LRU list
+  uint32_t last;
+  uint64_t last_base;
+
+  struct riscv_page_cache_stats stats;
+
+  uint8_t bytes[RISCV_PAGE_SIZE + 2];
+};
+
+static uint32_t page_bucket(const struct riscv_page_cache *cache,
+    uint64_t base) {
+  return ((base >> RISCV_PAGE_SHIFT) * 0x9e3779b97f4a7c15ull >> 32)
+    & cache->bucket_mask;
+}
+
+static void lru_unlink(struct riscv_page_cache *cache, uint32_t page) {
+  struct page_meta *meta = &cache->meta[page];
+  if (meta->lru_prev != NO_PAGE) {
+    cache->meta[meta->lru_prev].lru_next = meta->lru_next;
+  } else {
+    cache->lru_head = meta->lru_next;
+  }
+  if (meta->lru_next != NO_PAGE) {
+    cache->meta[meta->lru_next].lru_prev = meta->lru_prev;
+  } else {
+    cache->lru_tail = meta->lru_prev;
+  }
+}
+
+static void lru_push_front(struct riscv_page_cache *cache, uint32_t page) {
+  struct page_meta *meta = &cache->meta[page];
+  meta->lru_prev = NO_PAGE;
+  meta->lru_next = cache->lru_head;
+  if (cache->lru_head != NO_PAGE) {
+    cache->meta[cache->lru_head].lru_prev = page;
+  } else {
+    cache->lru_tail = page;
+  }
+  cache->lru_head = page;
+}
+
+static void lru_push_back(struct riscv_page_cache *cache, uint32_t page) {
+  struct page_meta *meta = &cache->meta[page];
+  meta->lru_next = NO_PAGE;
+  meta->lru_prev = cache->lru_tail;
+  if (cache->lru_tail != NO_PAGE) {
+    cache->meta[cache->lru_tail].lru_next = page;
+  } else {
+    cache->lru_head = page;
+  }
+  cache->lru_tail = page;
+}
+
+static uint32_t index_find(const struct riscv_page_cache *cache,
+    uint64_t base) {
+  uint32_t page = cache->buckets[page_bucket(cache, base)];
+  while (page != NO_PAGE && cache->meta[page].base != base) {
+    page = cache->meta[page].hash_next;
+  }
+  return page;
+}
+
+static void index_remove(struct riscv_page_cache *cache, uint32_t page) {
+  uint32_t *link = &cache->buckets[page_bucket(cache, cache->meta[page].base)];
+  while (*link != page) {
+    link = &cache->meta[*link].hash_next;
+  }
+  *link = cache->meta[page].hash_next;
+  cache->meta[page].valid = false;
+  if (cache->last == page) {
+    cache->last = NO_PAGE;
+  }
+}
+
+struct riscv_page_cache *riscv_page_cache_create(size_t max_pages,
+    const struct riscv_decoder *dec, riscv_fetch_fn fetch, void *ctx) {
+  if (max_pages == 0 || max_pages >= NO_PAGE / 2) {
+    return NULL;
+  }
+
+  struct riscv_page_cache *cache = calloc(1, sizeof(*cache));
+  if (!cache) {
+    return NULL;
+  }
+
+  uint32_t nbuckets = 1;
+  while (nbuckets < 2 * max_pages) {
+    nbuckets *= 2;
+  }
+
+  cache->npages = max_pages;
+  cache->meta = calloc(max_pages, sizeof(*cache->meta));
+  cache->pages = malloc(max_pages * sizeof(*cache->pages));
+  cache->buckets = malloc(nbuckets * sizeof(*cache->buckets));
+  if (!cache->meta || !cache->pages || !cache->buckets) {
+    riscv_page_cache_destroy(cache);
+    return NULL;
+  }
+  cache->bucket_mask = nbuckets - 1;
+  memset(cache->buckets, 0xff, nbuckets * sizeof(*cache->buckets));
+
+  if (dec) {
+    cache->table = (dispatch_table)dec->dispatch;
+    cache->rvc = dec->rvc;
+  } else {
+    cache->table = riscv_dispatch_table;
+#if defined(SUPPORT_COMPRESSED) && defined(SUPPORT_RV64I)
+    cache->rvc = rvc_table_rv64;
+#elif defined(SUPPORT_COMPRESSED)
+    cache->rvc = rvc_table_rv32;
+#else
+    cache->rvc = NULL;
+#endif
+  }
+  cache->fetch = fetch;
+  cache->ctx = ctx;
+
+  // Every page starts out free, in LRU order
+  cache->lru_head = NO_PAGE;
+  cache->lru_tail = NO_PAGE;
+  for (uint32_t page = 0; page < cache->npages; ++page) {
+    lru_push_back(cache, page);
+  }
+  cache->last = NO_PAGE;
+  return cache;
+}
+
+void riscv_page_cache_destroy(struct riscv_page_cache *cache) {
+  if (!cache) {
+    return;
+  }
+  free(cache->buckets);
+  free(cache->pages);
+  free(cache->meta);
+  free(cache);
+}
+
+/* Decodes the instruction at every halfword of the page at `base` into
+ * `insns`. Returns 0 if nothing could be fetched. */
+static int fill_page(struct riscv_page_cache *cache, uint64_t base,
+    struct riscv_insn *insns) {
+  size_t len = cache->fetch(cache->ctx, base, cache->bytes,
+      sizeof(cache->bytes));
+  if (len == 0) {
+    return 0;
+  }
+  if (len > sizeof(cache->bytes)) {
+    len = sizeof(cache->bytes);
+  }
+  // The decoders leave padding and the bits of illegal encodings alone, which
+  // would otherwise keep the previous page's contents
+  memset(insns, 0, RISCV_PAGE_SLOTS * sizeof(*insns));
+
+  for (size_t slot = 0; slot < RISCV_PAGE_SLOTS; ++slot) {
+    size_t offset = 2 * slot;
+    struct riscv_insn *insn = &insns[slot];
+    if (offset >= len || riscv_decode_next_with(cache->bytes + offset,
+          len - offset, insn, cache->table, cache->rvc) == 0) {
+      insn->type = INSN_UNDEFINED;
+      insn->kind = RVINSN_ILLEGAL;
+      insn->is_compressed = false;
+      insn->length = 0;
+    }
+    insn->pc = base + offset;
+  }
+  return 1;
+}
+
+const struct riscv_insn *riscv_page_cache_page(struct riscv_page_cache *cache,
+    uint64_t addr) {
+  uint64_t base = addr & ~(uint64_t)(RISCV_PAGE_SIZE - 1);
+
+  // Straight-line code stays on one page for hundreds of lookups
+  if (cache->last != NO_PAGE && cache->last_base == base) {
+    ++cache->stats.hits;
+    return cache->pages[cache->last];
+  }
+
+  uint32_t page = index_find(cache, base);
+  if (page != NO_PAGE) {
+    ++cache->stats.hits;
+    lru_unlink(cache, page);
+    lru_push_front(cache, page);
+  } else {
+    // The tail is either free or the least recently used page
+    page = cache->lru_tail;
+    if (!fill_page(cache, base, cache->pages[page])) {
+      return NULL;
+    }
+    ++cache->stats.misses;
+    struct page_meta *meta = &cache->meta[page];
+    if (meta->valid) {
+      ++cache->stats.evictions;
+      index_remove(cache, page);
+    }
+    uint32_t bucket = page_bucket(cache, base);
+    meta->base = base;
+    meta->hash_next = cache->buckets[bucket];
+    meta->valid = true;
+    cache->buckets[bucket] = page;
+    lru_unlink(cache, page);
+    lru_push_front(cache, page);
+  }
+
+  cache->last = page;
+  cache->last_base = base;
+  return cache->pages[page];
+}
+
+const struct riscv_insn *riscv_page_cache_lookup(
+    struct riscv_page_cache *cache, uint64_t pc) {
+  if (pc & 1) {
+    return NULL;
+  }
+  const struct riscv_insn *insns = riscv_page_cache_page(cache, pc);
+  if (!insns) {
+    return NULL;
+  }
+  return &insns[(pc & (RISCV_PAGE_SIZE - 1)) / 2];
+}
+
+static void invalidate_page(struct riscv_page_cache *cache, uint32_t page) {
+  index_remove(cache, page);
+  lru_unlink(cache, page);
+  lru_push_back(cache, page);
+  ++cache->stats.invalidations;
+}
+
+void riscv_page_cache_invalidate(struct riscv_page_cache *cache,
+    uint64_t addr, uint64_t len) {
+  if (len == 0) {
+    return;
+  }
+
+  // The last slot of the page before `addr` reads 2 bytes past its end
+  uint64_t first = addr < 2 ? 0 : (addr - 2) >> RISCV_PAGE_SHIFT;
+  uint64_t last = (addr + len - 1) >> RISCV_PAGE_SHIFT;
+  if (addr + len - 1 < addr) {
+    last = UINT64_MAX >> RISCV_PAGE_SHIFT;
+  }
+
+  if (last - first >= cache->npages) {
+    // Cheaper to look at every cached page than at every page of the range
+    for (uint32_t page = 0; page < cache->npages; ++page) {
+      uint64_t number = cache->meta[page].base >> RISCV_PAGE_SHIFT;
+      if (cache->meta[page].valid && number >= first && number <= last) {
+        invalidate_page(cache, page);
+      }
+    }
+    return;
+  }
+
+  for (uint64_t number = first; number <= last; ++number) {
+    uint32_t page = index_find(cache, number << RISCV_PAGE_SHIFT);
+    if (page != NO_PAGE) {
+      invalidate_page(cache, page);
+    }
+  }
+}
+
+void riscv_page_cache_stats(const struct riscv_page_cache *cache,
+    struct riscv_page_cache_stats *stats) {
+  *stats = cache->stats;
+}
@@ -0,0 +1,37 @@
+#ifndef RISCV_REGS_H
+#define RISCV_REGS_H
+
+#include <string.h>
+
+#include <rvdec/instruction.h>
+
+#include "insn_table.h"
+
+/* Registers in the rd, rs1 and rs2 slots of an instruction. */
+struct riscv_slot_regs {
+  unsigned rd;
+  unsigned rs1;
+  unsigned rs2;
+};
+
+/* Body of riscv_insn_regs(), shared with the dataflow passes. Slots that
+ * riscv_operand_slots marks as unused come out as x0, so the caller can treat
+ * every slot alike and drop x0 at the end. */
+static inline void riscv_slot_regs_of(const struct riscv_insn *insn,
+    struct riscv_slot_regs *regs) {
+  unsigned kind = (unsigned)insn->kind;
+  kind = kind < RVINSN_ILLEGAL ? kind : RVINSN_ILLEGAL;
+  const struct riscv_operand_slots slots = riscv_operand_slots[kind];
+  const uint8_t *shifts = riscv_slot_shifts[(unsigned)insn->type & 7];
+  uint32_t word;
+  memcpy(&word, &insn->r, sizeof(word));
+
+  regs->rd = (word >> shifts[SLOT_FIELD_RD]) & 0x1f
+    & -(unsigned)!!(slots.writes & RISCV_SLOT_RD);
+  regs->rs1 = (word >> shifts[SLOT_FIELD_RS1]) & 0x1f
+    & -(unsigned)!!(slots.reads & RISCV_SLOT_RS1);
+  regs->rs2 = (word >> shifts[SLOT_FIELD_RS2]) & 0x1f
+    & -(unsigned)!!(slots.reads & RISCV_SLOT_RS2);
+}
+
+#endif // RISCV_REGS_H
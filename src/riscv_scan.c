@@ -0,0 +1,133 @@
+#include "config.h"
+
+#include <rvdec/decode.h>
+
+#include "riscv_scan.h"
+
+#ifdef RVDEC_SCAN_X86
+#include <immintrin.h>
+#endif
+
+/* Instruction-boundary scan.
+ *
+ * Bit i of a 64-bit "long" mask is set when halfword i has its low two bits
+ * set, i.e. it would begin a 32-bit instruction if an instruction started
+ * there. Whether it actually starts one depends on the halfwords before it:
+ * inside a run of set bits every second halfword is the upper half of the
+ * previous instruction, and the first halfword after a clear bit always
+ * begins a new instruction. So which halfwords are continuations follows from
+ * the parity of the position each run begins at, which is computed for all
+ * 64 halfwords at once with a carrying add instead of a serial walk. */
+
+#define EVEN_BITS 0x5555555555555555ull
+
+/* Returns the mask of halfwords that are the upper half of a 32-bit
+ * instruction. `carry` is 1 if halfword 0 continues an instruction of the
+ * previous window and is updated for the next window. */
+static inline uint64_t scan_continuations(uint64_t longs, uint64_t *carry) {
+  // A continuation never begins an instruction, whatever its low bits are
+  longs &= ~*carry;
+  uint64_t follows_long = (longs << 1) | *carry;
+  uint64_t odd_run_starts = longs & ~EVEN_BITS & ~follows_long;
+  uint64_t runs_from_even;
+  *carry = __builtin_add_overflow(odd_run_starts, longs, &runs_from_even);
+  uint64_t invert = runs_from_even << 1;
+  return (EVEN_BITS ^ invert) & follows_long;
+}
+
+static inline uint64_t scan_longs_scalar(const uint8_t *buf, size_t halfwords) {
+  uint64_t longs = 0;
+  for (size_t i = 0; i < halfwords; ++i) {
+    longs |= (uint64_t)((buf[2 * i] & 0b11) == 0b11) << i;
+  }
+  return longs;
+}
+
+// Long mask of 128 bytes of code, one bit per halfword
+typedef uint64_t scan_longs_fn(const uint8_t *buf);
+
+#ifdef RVDEC_SCAN_X86
+
+__attribute__((target("avx2")))
+static uint64_t scan_longs_avx2(const uint8_t *buf) {
+  const __m256i low_bits = _mm256_set1_epi16(0b11);
+  uint64_t longs = 0;
+  for (int i = 0; i < 2; ++i) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(buf + 64 * i));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(buf + 64 * i + 32));
+    a = _mm256_cmpeq_epi16(_mm256_and_si256(a, low_bits), low_bits);
+    b = _mm256_cmpeq_epi16(_mm256_and_si256(b, low_bits), low_bits);
+    // packs works within 128-bit lanes, put the quadwords back in order
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xd8);
+    longs |= (uint64_t)(uint32_t)_mm256_movemask_epi8(packed) << (32 * i);
+  }
+  return longs;
+}
+
+static uint64_t scan_longs_sse2(const uint8_t *buf) {
+  const __m128i low_bits = _mm_set1_epi16(0b11);
+  uint64_t longs = 0;
+  for (int i = 0; i < 4; ++i) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(buf + 32 * i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(buf + 32 * i + 16));
+    a = _mm_cmpeq_epi16(_mm_and_si128(a, low_bits), low_bits);
+    b = _mm_cmpeq_epi16(_mm_and_si128(b, low_bits), low_bits);
+    longs |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_packs_epi16(a, b)) << (16 * i);
+  }
+  return longs;
+}
+
+#endif // RVDEC_SCAN_X86
+
+/* riscv_scan_boundaries() with `scan_longs` for the whole 128-byte blocks.
+ * Inlined into each caller, so the kernel is inlined as well. */
+static inline size_t scan_boundaries(const uint8_t *buf, size_t len,
+    uint64_t *starts, scan_longs_fn *scan_longs) {
+  size_t halfwords = len / 2;
+  size_t blocks = halfwords / 64;
+  uint64_t carry = 0;
+
+  for (size_t i = 0; i < blocks; ++i) {
+    starts[i] = ~scan_continuations(scan_longs(buf + 128 * i), &carry);
+  }
+
+  size_t tail = halfwords % 64;
+  if (tail != 0) {
+    uint64_t longs = scan_longs_scalar(buf + 128 * blocks, tail);
+    starts[blocks] = ~scan_continuations(longs, &carry) & ((1ull << tail) - 1);
+  }
+
+  return halfwords;
+}
+
+#ifdef RVDEC_SCAN_X86
+
+__attribute__((target("avx2")))
+size_t riscv_scan_boundaries_avx2(const uint8_t *buf, size_t len,
+    uint64_t *starts) {
+  return scan_boundaries(buf, len, starts, scan_longs_avx2);
+}
+
+size_t riscv_scan_boundaries_sse2(const uint8_t *buf, size_t len,
+    uint64_t *starts) {
+  return scan_boundaries(buf, len, starts, scan_longs_sse2);
+}
+
+#else
+
+static uint64_t scan_longs_block(const uint8_t *buf) {
+  return scan_longs_scalar(buf, 64);
+}
+
+#endif // RVDEC_SCAN_X86
+
+size_t riscv_scan_boundaries(const uint8_t *buf, size_t len, uint64_t *starts) {
+#ifdef RVDEC_SCAN_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return riscv_scan_boundaries_avx2(buf, len, starts);
+  }
+  return riscv_scan_boundaries_sse2(buf, len, starts);
+#else
+  return scan_boundaries(buf, len, starts, scan_longs_block);
+#endif // RVDEC_SCAN_X86
+}
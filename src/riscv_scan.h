@@ -0,0 +1,28 @@
+#ifndef RISCV_SCAN_H
+#define RISCV_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RVDEC_SCAN_X86
+
+/* Kernels riscv_scan_boundaries() picks between, with the same contract.
+ * They are visible so the tests can run each one whatever the host would
+ * pick; callers check __builtin_cpu_supports("avx2") before the AVX2 one. */
+size_t riscv_scan_boundaries_avx2(const uint8_t *buf, size_t len,
+    uint64_t *starts);
+size_t riscv_scan_boundaries_sse2(const uint8_t *buf, size_t len,
+    uint64_t *starts);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RISCV_SCAN_H
@@ -0,0 +1,55 @@
+#include "config.h"
+
+#include <string.h>
+
+#include <rvdec/instruction.h>
+#include <rvdec/stats.h>
+
+#include "riscv_stats.h"
+
+#ifdef RVDEC_STATS
+_Thread_local struct riscv_decode_stats riscv_stats;
+#endif
+
+int riscv_decode_stats_enabled(void) {
+#ifdef RVDEC_STATS
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+void riscv_decode_stats_snapshot(struct riscv_decode_stats *stats) {
+#ifdef RVDEC_STATS
+  *stats = riscv_stats;
+#else
+  memset(stats, 0, sizeof(*stats));
+#endif
+
+  // The kind of a decode tells its format, so only the kinds are counted
+  memset(stats->formats, 0, sizeof(stats->formats));
+  stats->decodes = 0;
+  for (int kind = 0; kind < RVINSN_ILLEGAL; ++kind) {
+    stats->formats[riscv_encodings[kind].type] += stats->kinds[kind];
+    stats->decodes += stats->kinds[kind];
+  }
+  stats->illegal = stats->kinds[RVINSN_ILLEGAL];
+  stats->formats[INSN_UNDEFINED] += stats->illegal;
+  stats->decodes += stats->illegal;
+}
+
+void riscv_decode_stats_reset(void) {
+#ifdef RVDEC_STATS
+  memset(&riscv_stats, 0, sizeof(riscv_stats));
+#endif
+}
+
+void riscv_decode_stats_merge(struct riscv_decode_stats *dst,
+    const struct riscv_decode_stats *src) {
+  // Every member is a uint64_t counter
+  uint64_t *d = (uint64_t *)dst;
+  const uint64_t *s = (const uint64_t *)src;
+  for (size_t i = 0; i < sizeof(*dst) / sizeof(uint64_t); ++i) {
+    d[i] += s[i];
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef RISCV_STATS_INTERNAL_H
+#define RISCV_STATS_INTERNAL_H
+
+#include <rvdec/stats.h>
+
+/* Counting points of the decoders, see <rvdec/stats.h>. Each expands to an
+ * increment of the calling thread's counters with RVDEC_STATS and to
+ * nothing otherwise. Only the counters below are kept while decoding, the
+ * others are worked out from them by riscv_decode_stats_snapshot(). */
+
+#ifdef RVDEC_STATS
+
+extern _Thread_local struct riscv_decode_stats riscv_stats;
+
+// A decode gave `kind`, counted once per instruction by the entry point
+#define RISCV_STATS_KIND(kind) ((void)++riscv_stats.kinds[(kind)])
+
+// Dispatch lookup of the 32-bit word `repr`, and that it gave no instruction
+#define RISCV_STATS_DISPATCH(repr) \
+  ((void)++riscv_stats.dispatch_attempts \
+   [((repr) >> 2) & 0b11111][((repr) >> 12) & 0b111])
+#define RISCV_STATS_DISPATCH_FAILED(repr) \
+  ((void)++riscv_stats.dispatch_failures \
+   [((repr) >> 2) & 0b11111][((repr) >> 12) & 0b111])
+
+// Lookup of the compressed instruction `repr` whose entry has kind `kind`
+#define RISCV_STATS_RVC(repr, kind) do { \
+    unsigned rvc_quadrant_ = (repr) & 0b11; \
+    unsigned rvc_funct3_ = ((repr) >> 13) & 0b111; \
+    ++riscv_stats.rvc_attempts[rvc_quadrant_][rvc_funct3_]; \
+    riscv_stats.rvc_failures[rvc_quadrant_][rvc_funct3_] \
+      += (kind) == RVINSN_ILLEGAL; \
+  } while (0)
+
+#define RISCV_STATS_RVC_FALLBACK() ((void)++riscv_stats.rvc_fallbacks)
+
+#else
+
+#define RISCV_STATS_KIND(kind) ((void)0)
+#define RISCV_STATS_DISPATCH(repr) ((void)0)
+#define RISCV_STATS_DISPATCH_FAILED(repr) ((void)0)
+#define RISCV_STATS_RVC(repr, kind) ((void)0)
+#define RISCV_STATS_RVC_FALLBACK() ((void)0)
+
+#endif // RVDEC_STATS
+
+#endif // RISCV_STATS_INTERNAL_H
@@ -0,0 +1,152 @@
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/stream.h>
+
+#include "decoder_dispatch.h"
+#include "rvc_table.h"
+
+typedef const struct riscv_dispatch_entry (*dispatch_table)[8];
+
+struct riscv_stream {
+  dispatch_table table;
+  const struct riscv_insn *rvc;
+  riscv_emit_fn emit;
+  void *ctx;
+
+  // PC of the next instruction, the one starting with `carry` if it's held
+  uint64_t pc;
+  // Start of an instruction cut off by the end of the last chunk
+  uint8_t carry[4];
+  size_t ncarry;
+
+  size_t batch;
+  size_t count;
+  struct riscv_insn insns[];
+};
+
+struct riscv_stream *riscv_stream_create(size_t batch,
+    const struct riscv_decoder *dec, uint64_t base_pc, riscv_emit_fn emit,
+    void *ctx) {
+  if (batch == 0
+      || batch > (SIZE_MAX - sizeof(struct riscv_stream))
+          / sizeof(struct riscv_insn)) {
+    return NULL;
+  }
+
+  struct riscv_stream *stream = malloc(sizeof(*stream)
+      + batch * sizeof(struct riscv_insn));
+  if (!stream) {
+    return NULL;
+  }
+
+  if (dec) {
+    stream->table = (dispatch_table)dec->dispatch;
+    stream->rvc = dec->rvc;
+  } else {
+    stream->table = riscv_dispatch_table;
+#if defined(SUPPORT_COMPRESSED) && defined(SUPPORT_RV64I)
+    stream->rvc = rvc_table_rv64;
+#elif defined(SUPPORT_COMPRESSED)
+    stream->rvc = rvc_table_rv32;
+#else
+    stream->rvc = NULL;
+#endif
+  }
+  stream->emit = emit;
+  stream->ctx = ctx;
+  stream->pc = base_pc;
+  stream->ncarry = 0;
+  stream->batch = batch;
+  stream->count = 0;
+  return stream;
+}
+
+void riscv_stream_destroy(struct riscv_stream *stream) {
+  free(stream);
+}
+
+static void emit_batch(struct riscv_stream *stream) {
+  if (stream->count > 0) {
+    stream->emit(stream->ctx, stream->insns, stream->count);
+    stream->count = 0;
+  }
+}
+
+/* Decodes the instruction at `buf` into the batch. Returns its size, or 0 if
+ * it doesn't fit in `len` bytes. */
+static size_t decode_one(struct riscv_stream *stream, const uint8_t *buf,
+    size_t len) {
+  struct riscv_insn *insn = &stream->insns[stream->count];
+  size_t size = riscv_decode_next_with(buf, len, insn, stream->table,
+      stream->rvc);
+  if (size == 0) {
+    return 0;
+  }
+  insn->pc = stream->pc;
+  stream->pc += size;
+  if (++stream->count == stream->batch) {
+    emit_batch(stream);
+  }
+  return size;
+}
+
+void riscv_stream_feed(struct riscv_stream *stream, const uint8_t *data,
+    size_t len) {
+  // Complete the instruction held from the last chunk. Its first byte gives
+  // its size.
+  if (stream->ncarry > 0) {
+    size_t size = (stream->carry[0] & 0b11) == 0b11 ? 4 : 2;
+    size_t need = size - stream->ncarry;
+    if (need > len) {
+      memcpy(stream->carry + stream->ncarry, data, len);
+      stream->ncarry += len;
+      return;
+    }
+    memcpy(stream->carry + stream->ncarry, data, need);
+    data += need;
+    len -= need;
+    stream->ncarry = 0;
+    decode_one(stream, stream->carry, size);
+  }
+
+  // Same as decode_one(), with the state kept in locals for the bulk of the
+  // chunk
+  dispatch_table table = stream->table;
+  const struct riscv_insn *rvc = stream->rvc;
+  uint64_t pc = stream->pc;
+  size_t count = stream->count;
+  size_t offset = 0;
+  for (;;) {
+    struct riscv_insn *insn = &stream->insns[count];
+    size_t size = riscv_decode_next_with(data + offset, len - offset, insn,
+        table, rvc);
+    if (size == 0) {
+      break;
+    }
+    insn->pc = pc + offset;
+    offset += size;
+    if (++count == stream->batch) {
+      stream->emit(stream->ctx, stream->insns, count);
+      count = 0;
+    }
+  }
+  stream->pc = pc + offset;
+  stream->count = count;
+
+  stream->ncarry = len - offset;
+  memcpy(stream->carry, data + offset, stream->ncarry);
+}
+
+size_t riscv_stream_flush(struct riscv_stream *stream) {
+  emit_batch(stream);
+  return stream->ncarry;
+}
+
+uint64_t riscv_stream_pc(const struct riscv_stream *stream) {
+  return stream->pc;
+}
@@ -0,0 +1,63 @@
+#include "config.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "riscv_stats.h"
+#include "riscv_threads.h"
+
+#ifdef RVDEC_STATS
+
+/* Started threads run their element through this, which adds their decode
+ * counters to `total` before the thread and its counters go away. */
+struct counted_thread {
+  void *(*fn)(void *);
+  void *item;
+  pthread_mutex_t *lock;
+  struct riscv_decode_stats *total;
+};
+
+static void *run_counted(void *arg) {
+  struct counted_thread *t = arg;
+  t->fn(t->item);
+  pthread_mutex_lock(t->lock);
+  riscv_decode_stats_merge(t->total, &riscv_stats);
+  pthread_mutex_unlock(t->lock);
+  return NULL;
+}
+
+#endif // RVDEC_STATS
+
+void riscv_run_threads(void *(*fn)(void *), void *items, size_t n,
+    size_t size) {
+  uint8_t *base = items;
+  pthread_t threads[RISCV_MAX_THREADS];
+  int started[RISCV_MAX_THREADS];
+#ifdef RVDEC_STATS
+  struct counted_thread counted[RISCV_MAX_THREADS];
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  struct riscv_decode_stats total = { 0 };
+#endif
+
+  for (size_t i = 1; i < n; ++i) {
+#ifdef RVDEC_STATS
+    counted[i] = (struct counted_thread){ fn, base + i * size, &lock, &total };
+    started[i] = pthread_create(&threads[i], NULL, run_counted,
+        &counted[i]) == 0;
+#else
+    started[i] = pthread_create(&threads[i], NULL, fn, base + i * size) == 0;
+#endif
+  }
+  fn(base);
+  for (size_t i = 1; i < n; ++i) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    } else {
+      fn(base + i * size);
+    }
+  }
+
+#ifdef RVDEC_STATS
+  riscv_decode_stats_merge(&riscv_stats, &total);
+#endif
+}
@@ -0,0 +1,16 @@
+#ifndef RISCV_THREADS_H
+#define RISCV_THREADS_H
+
+#include <stddef.h>
+
+// Most threads the parallel decoders start for one call
+#define RISCV_MAX_THREADS 256
+
+/* Runs `fn` on each of the `n` elements of `size` bytes at `items`, at most
+ * RISCV_MAX_THREADS, each on its own thread. The first one runs on the
+ * calling thread, as does any whose thread couldn't be started. Returns once
+ * all are done. */
+void riscv_run_threads(void *(*fn)(void *), void *items, size_t n,
+    size_t size);
+
+#endif // RISCV_THREADS_H
@@ -0,0 +1,230 @@
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/trace.h>
+
+#include "decoder_dispatch.h"
+#include "riscv_bytes.h"
+#include "riscv_map.h"
+#include "riscv_operands.h"
+#include "riscv_threads.h"
+#include "rvc_table.h"
+
+typedef const struct riscv_dispatch_entry (*dispatch_table)[8];
+
+/* Each thread memoizes the operands of the words it decodes in a 2-way set
+ * associative cache with the sets and replacement of riscv_decode_cache. It
+ * keeps them in the form they are stored in, rather than as a struct
+ * riscv_insn, since picking the operands out of one costs a poorly predicted
+ * switch per record, more than the lookup itself. */
+struct memo_entry {
+  uint32_t repr;
+  uint16_t kind;
+  uint8_t rd;
+  uint8_t rs1;
+  uint8_t rs2;
+  uint8_t valid;
+  int32_t imm;
+};
+
+// Entries of each thread's memo, 256 KiB
+#define MEMO_SIZE 16384
+// Used if the memo can't be allocated
+#define FALLBACK_MEMO_SIZE 64
+
+// Below this many records per thread, threads cost more than they save
+#define MIN_CHUNK_RECORDS 16384
+
+struct chunk {
+  const uint8_t *records;
+  size_t record_size;
+  size_t count;
+  // Tables of the profile to decode for
+  dispatch_table table;
+  const struct riscv_insn *rvc;
+  // Already advanced to the chunk's first record
+  uint64_t *pc;
+  struct riscv_insn_soa out;
+};
+
+/* Decodes the instruction `repr`, compressed ones in its low halfword, with
+ * the tables of `chunk` and stores its operands to the first way of `set`,
+ * evicting the second one. */
+static void memo_fill(const struct chunk *chunk, struct memo_entry *set,
+    uint32_t repr) {
+  const uint8_t bytes[4] = { repr, repr >> 8, repr >> 16, repr >> 24 };
+  struct riscv_insn insn;
+  memset(&insn, 0, sizeof(insn));
+  riscv_decode_next_with(bytes, sizeof(bytes), &insn, chunk->table,
+      chunk->rvc);
+  struct riscv_operands ops;
+  riscv_operands_of(&insn, &ops);
+
+  set[1] = set[0];
+  set[0].repr = repr;
+  set[0].kind = insn.kind;
+  set[0].rd = ops.rd;
+  set[0].rs1 = ops.rs1;
+  set[0].rs2 = ops.rs2;
+  set[0].valid = 1;
+  set[0].imm = ops.imm;
+}
+
+/* Decodes the records of `chunk` through `memo`, whose sets are those of
+ * `cache`. */
+static void decode_records(const struct chunk *chunk, struct memo_entry *memo,
+    const struct riscv_decode_cache *cache) {
+  const uint8_t *record = chunk->records;
+  uint64_t *pc = chunk->pc;
+  const struct riscv_insn_soa out = chunk->out;
+  for (size_t i = 0; i < chunk->count; ++i, record += chunk->record_size) {
+    uint32_t word = riscv_read_le(record + RISCV_TRACE_INSN_OFFSET, 4);
+    // The upper halfword of a compressed instruction isn't part of it
+    bool is_long = (word & 0b11) == 0b11;
+    uint32_t repr = is_long ? word : word & 0xffff;
+
+    struct memo_entry *set = &memo[2 * riscv_decode_cache_set(cache, repr)];
+    if (!set[0].valid || set[0].repr != repr) {
+      if (set[1].valid && set[1].repr == repr) {
+        // Moved to the first way, as riscv_decode_cache_lookup() does
+        struct memo_entry hit = set[1];
+        set[1] = set[0];
+        set[0] = hit;
+      } else {
+        memo_fill(chunk, set, repr);
+      }
+    }
+    const struct memo_entry *entry = &set[0];
+
+    pc[i] = riscv_read_le(record + RISCV_TRACE_PC_OFFSET, 8);
+    out.kind[i] = entry->kind;
+    out.rd[i] = entry->rd;
+    out.rs1[i] = entry->rs1;
+    out.rs2[i] = entry->rs2;
+    out.imm[i] = entry->imm;
+    out.len[i] = is_long ? 4 : 2;
+  }
+}
+
+static void *decode_chunk(void *arg) {
+  struct chunk *chunk = arg;
+  // Only the sets of `cache` are used, its entries are `memo`
+  struct riscv_decode_cache cache = { 0 };
+  struct memo_entry *memo = calloc(MEMO_SIZE, sizeof(*memo));
+  if (memo) {
+    cache.mask = MEMO_SIZE / 2 - 1;
+    decode_records(chunk, memo, &cache);
+    free(memo);
+  } else {
+    struct memo_entry fallback[FALLBACK_MEMO_SIZE] = { 0 };
+    cache.mask = FALLBACK_MEMO_SIZE / 2 - 1;
+    decode_records(chunk, fallback, &cache);
+  }
+  return NULL;
+}
+
+int riscv_trace_init(struct riscv_trace *trace, const void *data,
+    size_t size, size_t record_size) {
+  memset(trace, 0, sizeof(*trace));
+  if (record_size < RISCV_TRACE_MIN_RECORD) {
+    return 0;
+  }
+  trace->data = data;
+  trace->size = size;
+  trace->record_size = record_size;
+  trace->nrecords = size / record_size;
+  return 1;
+}
+
+int riscv_trace_open(struct riscv_trace *trace, const char *path,
+    size_t record_size) {
+  memset(trace, 0, sizeof(*trace));
+  if (record_size < RISCV_TRACE_MIN_RECORD) {
+    return 0;
+  }
+
+  size_t size;
+  const void *data = riscv_map_file(path, &size);
+  if (!data) {
+    return 0;
+  }
+  riscv_trace_init(trace, data, size, record_size);
+  trace->mapped = true;
+  return 1;
+}
+
+void riscv_trace_close(struct riscv_trace *trace) {
+  if (trace->mapped) {
+    riscv_unmap_file(trace->data, trace->size);
+  }
+  memset(trace, 0, sizeof(*trace));
+}
+
+size_t riscv_trace_decode(const struct riscv_trace *trace, size_t first,
+    size_t count, const struct riscv_decoder *dec, uint64_t *pc,
+    const struct riscv_insn_soa *out, unsigned threads) {
+  if (first >= trace->nrecords) {
+    return 0;
+  }
+  if (count > trace->nrecords - first) {
+    count = trace->nrecords - first;
+  }
+
+  if (threads > RISCV_MAX_THREADS) {
+    threads = RISCV_MAX_THREADS;
+  }
+  if (threads > count / MIN_CHUNK_RECORDS) {
+    threads = count / MIN_CHUNK_RECORDS;
+  }
+  if (threads == 0) {
+    threads = 1;
+  }
+
+  struct chunk one;
+  struct chunk *chunks = threads > 1 ? calloc(threads, sizeof(*chunks)) : &one;
+  if (!chunks) {
+    chunks = &one;
+    threads = 1;
+  }
+
+  dispatch_table table = riscv_dispatch_table;
+#if defined(SUPPORT_COMPRESSED) && defined(SUPPORT_RV64I)
+  const struct riscv_insn *rvc = rvc_table_rv64;
+#elif defined(SUPPORT_COMPRESSED)
+  const struct riscv_insn *rvc = rvc_table_rv32;
+#else
+  const struct riscv_insn *rvc = NULL;
+#endif
+  if (dec) {
+    table = (dispatch_table)dec->dispatch;
+    rvc = dec->rvc;
+  }
+
+  size_t chunk_size = count / threads;
+  for (unsigned i = 0; i < threads; ++i) {
+    struct chunk *chunk = &chunks[i];
+    size_t start = i * chunk_size;
+    chunk->records = trace->data + (first + start) * trace->record_size;
+    chunk->record_size = trace->record_size;
+    chunk->count = i + 1 == threads ? count - start : chunk_size;
+    chunk->table = table;
+    chunk->rvc = rvc;
+    chunk->pc = pc + start;
+    chunk->out.kind = out->kind + start;
+    chunk->out.rd = out->rd + start;
+    chunk->out.rs1 = out->rs1 + start;
+    chunk->out.rs2 = out->rs2 + start;
+    chunk->out.imm = out->imm + start;
+    chunk->out.len = out->len + start;
+  }
+  riscv_run_threads(decode_chunk, chunks, threads, sizeof(*chunks));
+
+  if (chunks != &one) {
+    free(chunks);
+  }
+  return count;
+}
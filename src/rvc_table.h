@@ -0,0 +1,16 @@
+#ifndef RVC_TABLE_H
+#define RVC_TABLE_H
+
+#include <rvdec/instruction.h>
+
+#ifdef SUPPORT_COMPRESSED
+
+/* Expanded form of every 16-bit compressed instruction, indexed by the raw
+ * halfword. Entries that don't decode have kind RVINSN_ILLEGAL.
+ * Both tables are generated at build time by rvc_table_gen. */
+extern const struct riscv_insn rvc_table_rv32[1 << 16];
+extern const struct riscv_insn rvc_table_rv64[1 << 16];
+
+#endif // SUPPORT_COMPRESSED
+
+#endif // RVC_TABLE_H
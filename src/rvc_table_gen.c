@@ -0,0 +1,112 @@
+/* Build-time generator of the compressed instruction tables declared in
+ * rvc_table.h. Runs every 16-bit word through the RVC hooks of each XLEN
+ * profile and emits the results as constant C arrays. */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#include "decoder_hooks.h"
+
+#ifdef SUPPORT_COMPRESSED
+
+static int rvc_decode_hooks(struct riscv_insn *insn, uint32_t repr,
+    const struct decoder_hooks16 *hooks, size_t nhooks) {
+  if (repr == 0) {
+    return 0;
+  }
+
+  uint32_t opcode = repr & 0b11;
+  for (size_t i = 0; i < nhooks; ++i) {
+    if (hooks[i].rvc_decode_cr(insn, repr, opcode))  { return 1; }
+    if (hooks[i].rvc_decode_ci(insn, repr, opcode))  { return 1; }
+    if (hooks[i].rvc_decode_css(insn, repr, opcode)) { return 1; }
+    if (hooks[i].rvc_decode_ciw(insn, repr, opcode)) { return 1; }
+    if (hooks[i].rvc_decode_cl(insn, repr, opcode))  { return 1; }
+    if (hooks[i].rvc_decode_cs(insn, repr, opcode))  { return 1; }
+    if (hooks[i].rvc_decode_ca(insn, repr, opcode))  { return 1; }
+    if (hooks[i].rvc_decode_cb(insn, repr, opcode))  { return 1; }
+    if (hooks[i].rvc_decode_cj(insn, repr, opcode))  { return 1; }
+  }
+  return 0;
+}
+
+static void emit_entry(FILE *out, const struct riscv_insn *insn) {
+  fprintf(out, "{%d,%d,1,2,", insn->type, insn->kind);
+  switch (insn->type) {
+    case INSN_R:
+      fprintf(out, ".r={%u,%u,%u,%u,%u,%u}", insn->r.funct7, insn->r.rs2,
+          insn->r.rs1, insn->r.funct3, insn->r.rd, insn->r.opcode);
+      break;
+    case INSN_I:
+      fprintf(out, ".i={%d,%u,%u,%u,%u}", insn->i.imm, insn->i.rs1,
+          insn->i.funct3, insn->i.rd, insn->i.opcode);
+      break;
+    case INSN_S:
+      fprintf(out, ".s={%d,%u,%u,%u,%u}", insn->s.imm, insn->s.rs2,
+          insn->s.rs1, insn->s.funct3, insn->s.opcode);
+      break;
+    case INSN_B:
+      fprintf(out, ".b={%d,%u,%u,%u,%u}", insn->b.imm, insn->b.rs2,
+          insn->b.rs1, insn->b.funct3, insn->b.opcode);
+      break;
+    case INSN_U:
+      fprintf(out, ".u={%d,%u,%u}", insn->u.imm, insn->u.rd, insn->u.opcode);
+      break;
+    case INSN_J:
+      fprintf(out, ".j={%d,%u,%u}", insn->j.imm, insn->j.rd, insn->j.opcode);
+      break;
+  }
+  fprintf(out, "},\n");
+}
+
+static void emit_table(FILE *out, const char *name,
+    const struct decoder_hooks16 *hooks, size_t nhooks) {
+  fprintf(out, "const struct riscv_insn %s[1 << 16] = {\n", name);
+  for (uint32_t repr = 0; repr < (1 << 16); ++repr) {
+    struct riscv_insn insn;
+    memset(&insn, 0, sizeof(insn));
+    if (rvc_decode_hooks(&insn, repr, hooks, nhooks)) {
+      emit_entry(out, &insn);
+    } else {
+      fprintf(out, "{%d,%d,0,2},\n", INSN_UNDEFINED, RVINSN_ILLEGAL);
+    }
+  }
+  fprintf(out, "};\n\n");
+}
+
+#endif // SUPPORT_COMPRESSED
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s OUTPUT\n", argv[0]);
+    return 1;
+  }
+
+  FILE *out = fopen(argv[1], "w");
+  if (!out) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  fprintf(out, "/* Generated by rvc_table_gen, do not edit. */\n\n");
+  fprintf(out, "#include \"config.h\"\n\n");
+  fprintf(out, "#include \"rvc_table.h\"\n\n");
+
+#ifdef SUPPORT_COMPRESSED
+  emit_table(out, "rvc_table_rv32", decoder_hooks16_rv32,
+      sizeof(decoder_hooks16_rv32) / sizeof(*decoder_hooks16_rv32));
+  emit_table(out, "rvc_table_rv64", decoder_hooks16_rv64,
+      sizeof(decoder_hooks16_rv64) / sizeof(*decoder_hooks16_rv64));
+#endif // SUPPORT_COMPRESSED
+
+  if (fclose(out) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  return 0;
+}
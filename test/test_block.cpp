@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+#include "test_util.h"
+
+namespace block {
+
+static std::vector<uint8_t> code_of(std::initializer_list<uint32_t> words) {
+  std::vector<uint8_t> buf;
+  for (uint32_t word : words) {
+    for (int i = 0; i < 4; ++i) {
+      buf.push_back(word >> (8 * i));
+    }
+  }
+  return buf;
+}
+
+TEST(block, stops_after_branch) {
+  std::vector<uint8_t> code = code_of({
+    /* 142b0: addi a5,s0,-200 */ 0xf3840793,
+    /* 142b4: add a5,a3,s8    */ 0x018687b3,
+    /* 142b8: beq a5,a3,142a6 */ 0xfed787e3,
+    /* 142bc: add a5,a3,s8    */ 0x018687b3,
+  });
+  struct riscv_insn insns[8];
+  struct riscv_block block;
+  ASSERT_EQ(riscv_decode_block(code.data(), code.size(), 0x142b0, insns, 8,
+        &block), 3);
+  EXPECT_EQ(block.count, 3);
+  EXPECT_EQ(block.length, 12);
+  EXPECT_EQ(block.end, RISCV_BLOCK_BRANCH);
+  EXPECT_EQ(block.terminator, RVINSN_BEQ);
+  EXPECT_FALSE(block.indirect);
+  EXPECT_EQ(block.fallthrough_pc, 0x142bc);
+  EXPECT_EQ(block.target_pc, 0x142a6);
+  EXPECT_EQ(insns[2].kind, RVINSN_BEQ);
+  EXPECT_EQ(insns[2].pc, 0x142b8);
+}
+
+TEST(block, jumps) {
+  struct riscv_insn insns[8];
+  struct riscv_block block;
+
+  std::vector<uint8_t> jal = code_of({ /* 19e24: jal ra,196f2 */ 0x8cfff0ef });
+  ASSERT_EQ(riscv_decode_block(jal.data(), jal.size(), 0x19e24, insns, 8,
+        &block), 1);
+  EXPECT_EQ(block.end, RISCV_BLOCK_JUMP);
+  EXPECT_EQ(block.terminator, RVINSN_JAL);
+  EXPECT_FALSE(block.indirect);
+  EXPECT_EQ(block.target_pc, 0x196f2);
+  EXPECT_EQ(block.fallthrough_pc, 0x19e28);
+
+  std::vector<uint8_t> jalr = code_of({
+    /* addi a5,s0,-200 */ 0xf3840793,
+    /* jalr a5         */ 0x000780e7,
+  });
+  ASSERT_EQ(riscv_decode_block(jalr.data(), jalr.size(), 0x1000, insns, 8,
+        &block), 2);
+  EXPECT_EQ(block.end, RISCV_BLOCK_JUMP);
+  EXPECT_EQ(block.terminator, RVINSN_JALR);
+  EXPECT_TRUE(block.indirect);
+  EXPECT_EQ(block.target_pc, 0);
+  EXPECT_EQ(block.fallthrough_pc, 0x1008);
+}
+
+TEST(block, traps_and_illegal_encodings_end_blocks) {
+  struct riscv_insn insns[8];
+  struct riscv_block block;
+
+  std::vector<uint8_t> ecall = code_of({ 0xf3840793, /* ecall */ 0x00000073,
+      0xf3840793 });
+  ASSERT_EQ(riscv_decode_block(ecall.data(), ecall.size(), 0, insns, 8,
+        &block), 2);
+  EXPECT_EQ(block.end, RISCV_BLOCK_TRAP);
+  EXPECT_EQ(block.terminator, RVINSN_ECALL);
+
+  std::vector<uint8_t> illegal = code_of({ 0xf3840793, 0xffffffff,
+      0xf3840793 });
+  ASSERT_EQ(riscv_decode_block(illegal.data(), illegal.size(), 0, insns, 8,
+        &block), 2);
+  EXPECT_EQ(block.end, RISCV_BLOCK_ILLEGAL);
+  EXPECT_EQ(block.terminator, RVINSN_ILLEGAL);
+  EXPECT_EQ(block.length, 8);
+}
+
+TEST(block, truncated_by_length_or_capacity) {
+  std::vector<uint8_t> code = code_of({ 0xf3840793, 0x018687b3, 0x018687b3 });
+  struct riscv_insn insns[8];
+  struct riscv_block block;
+
+  ASSERT_EQ(riscv_decode_block(code.data(), code.size() - 1, 0x100, insns, 8,
+        &block), 2);
+  EXPECT_EQ(block.end, RISCV_BLOCK_TRUNCATED);
+  EXPECT_EQ(block.terminator, RVINSN_ILLEGAL);
+  EXPECT_EQ(block.length, 8);
+  EXPECT_EQ(block.fallthrough_pc, 0x108);
+
+  ASSERT_EQ(riscv_decode_block(code.data(), code.size(), 0x100, insns, 1,
+        &block), 1);
+  EXPECT_EQ(block.end, RISCV_BLOCK_TRUNCATED);
+  EXPECT_EQ(block.fallthrough_pc, 0x104);
+}
+
+#ifdef SUPPORT_COMPRESSED
+TEST(block, compressed_branch_targets_are_sign_extended) {
+  // c.li a0,1; c.beqz a5,-4
+  static const uint8_t code[] = { 0x05, 0x45, 0xf5, 0xdf };
+  struct riscv_insn insns[8];
+  struct riscv_block block;
+  ASSERT_EQ(riscv_decode_block(code, sizeof(code), 0x2000, insns, 8, &block), 2);
+  EXPECT_EQ(insns[1].kind, RVINSN_BEQ);
+  EXPECT_EQ(insns[1].b.imm, -4);
+  EXPECT_EQ(block.end, RISCV_BLOCK_BRANCH);
+  EXPECT_EQ(block.target_pc, 0x1ffe);
+  EXPECT_EQ(block.fallthrough_pc, 0x2004);
+}
+#endif
+
+TEST(block, blocks_partition_decode_buffer) {
+  std::vector<uint8_t> buf = random_code(0xb10c, 1 << 16);
+  std::vector<struct riscv_insn> expected(buf.size() / 2);
+  size_t n = riscv_decode_buffer(buf.data(), buf.size(), 0x80000000,
+      expected.data(), expected.size());
+
+  std::vector<struct riscv_insn> actual(expected.size());
+  size_t count = 0;
+  size_t offset = 0;
+  for (;;) {
+    struct riscv_block block;
+    size_t got = riscv_decode_block(buf.data() + offset, buf.size() - offset,
+        0x80000000 + offset, actual.data() + count, actual.size() - count,
+        &block);
+    ASSERT_EQ(got, block.count);
+    if (got == 0) {
+      break;
+    }
+    for (size_t i = 0; i + 1 < got; ++i) {
+      ASSERT_EQ(memcmp(&actual[count + i], &expected[count + i],
+            sizeof(actual[0])), 0) << count + i;
+    }
+    const struct riscv_insn &last = actual[count + got - 1];
+    ASSERT_EQ(memcmp(&last, &expected[count + got - 1], sizeof(last)), 0);
+    ASSERT_EQ(block.fallthrough_pc, last.pc + last.length);
+    if (block.end != RISCV_BLOCK_TRUNCATED) {
+      ASSERT_EQ(block.terminator, last.kind);
+    }
+    count += got;
+    offset += block.length;
+  }
+  EXPECT_EQ(count, n);
+}
+
+#if defined(SUPPORT_RV32I) && defined(SUPPORT_RV64I)
+TEST(block, decoder_uses_its_profile) {
+  std::vector<uint8_t> code = code_of({
+    /* ld a5,0(a5)     */ 0x0007b783,
+    /* beq a5,a3,-18   */ 0xfed787e3,
+  });
+  struct riscv_decoder rv32, rv64;
+  ASSERT_EQ(riscv_decoder_init(&rv32, 32, 0), 1);
+  ASSERT_EQ(riscv_decoder_init(&rv64, 64, 0), 1);
+  struct riscv_insn insns[8];
+  struct riscv_block block;
+
+  ASSERT_EQ(riscv_decoder_decode_block(&rv32, code.data(), code.size(), 0,
+        insns, 8, &block), 1);
+  EXPECT_EQ(block.end, RISCV_BLOCK_ILLEGAL);
+
+  ASSERT_EQ(riscv_decoder_decode_block(&rv64, code.data(), code.size(), 0,
+        insns, 8, &block), 2);
+  EXPECT_EQ(block.end, RISCV_BLOCK_BRANCH);
+  EXPECT_EQ(block.target_pc, 4 - 18);
+}
+#endif
+
+} // namespace block
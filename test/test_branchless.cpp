@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+namespace branchless {
+
+static void expect_same_as_decode(uint32_t repr) {
+  struct riscv_insn expected, actual;
+  memset(&expected, 0, sizeof(expected));
+  memset(&actual, 0, sizeof(actual));
+  int kind = riscv_decode(&expected, repr);
+  ASSERT_EQ(riscv_decode_branchless(&actual, repr), kind) << std::hex << repr;
+  ASSERT_EQ(actual.kind, kind) << std::hex << repr;
+  ASSERT_EQ(actual.is_compressed, expected.is_compressed) << std::hex << repr;
+  if (kind == RVINSN_ILLEGAL) {
+    EXPECT_EQ(actual.type, INSN_UNDEFINED) << std::hex << repr;
+    EXPECT_EQ(actual.length, 4) << std::hex << repr;
+    return;
+  }
+  ASSERT_EQ(actual.type, expected.type) << std::hex << repr;
+  ASSERT_EQ(actual.length, expected.length) << std::hex << repr;
+  ASSERT_EQ(memcmp(&actual.r, &expected.r, sizeof(actual.r)), 0)
+    << std::hex << repr;
+}
+
+TEST(branchless, matches_decode_on_every_opcode_funct3_and_funct7) {
+  std::mt19937 rng(0xb1);
+  for (uint32_t op = 0; op < 32; ++op) {
+    for (uint32_t funct3 = 0; funct3 < 8; ++funct3) {
+      for (uint32_t funct7 = 0; funct7 < 128; ++funct7) {
+        // Random registers, and with rd and rs1 zero for FENCE
+        uint32_t fields = rng() & 0x01ff8f80;
+        for (uint32_t regs : { fields, fields & ~0x000f8f80u }) {
+          uint32_t repr = funct7 << 25 | regs | funct3 << 12 | op << 2 | 0b11;
+          expect_same_as_decode(repr);
+          if (HasFatalFailure()) {
+            return;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(branchless, matches_decode_on_system_immediates) {
+  for (uint32_t imm = 0; imm < 4096; ++imm) {
+    expect_same_as_decode(imm << 20 | 0b1110011);
+    expect_same_as_decode(imm << 20 | 0b0001111);
+    expect_same_as_decode(imm << 20 | 1 << 7 | 0b0001111);
+    if (HasFatalFailure()) {
+      return;
+    }
+  }
+}
+
+TEST(branchless, matches_decode_on_random_words) {
+  std::mt19937 rng(0xb2);
+  for (int i = 0; i < 2000000; ++i) {
+    expect_same_as_decode(rng());
+    if (HasFatalFailure()) {
+      return;
+    }
+  }
+}
+
+#ifdef SUPPORT_COMPRESSED
+TEST(branchless, falls_back_to_the_upper_halfword) {
+  for (uint32_t half = 0; half < 1 << 16; ++half) {
+    expect_same_as_decode(half << 16);
+    expect_same_as_decode(half << 16 | 0xffff);
+    if (HasFatalFailure()) {
+      return;
+    }
+  }
+}
+#endif
+
+TEST(branchless, leaves_pc_alone) {
+  struct riscv_insn insn;
+  insn.pc = 0x1234;
+  EXPECT_EQ(riscv_decode_branchless(&insn, 0x00c58533), RVINSN_ADD);
+  EXPECT_EQ(insn.pc, 0x1234);
+  EXPECT_EQ(riscv_decode_branchless(&insn, 0xffffffff), RVINSN_ILLEGAL);
+  EXPECT_EQ(insn.pc, 0x1234);
+}
+
+} // namespace branchless
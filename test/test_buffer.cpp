@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+namespace buffer {
+
+static const uint8_t code[] = {
+  /* 10000: addi a5,s0,-200 */ 0x93, 0x07, 0x84, 0xf3,
+  /* 10004: mv a5,a2        */ 0xb2, 0x87,
+  /* 10006: add a0,a1,a2    */ 0x33, 0x85, 0xc5, 0x00,
+  /* 1000a: illegal         */ 0xff, 0xff, 0xff, 0xff,
+  /* 1000e: jal ra,0x10000  */ 0xef, 0xf0, 0x3f, 0xff,
+  /* 10012: lw a5,0(a5)     */ 0x83, 0xa7,
+};
+
+TEST(buffer, decodes_mixed_stream) {
+  struct riscv_insn insns[8];
+  size_t n = riscv_decode_buffer(code, sizeof(code), 0x10000, insns, 8);
+  ASSERT_EQ(n, 5);
+
+  EXPECT_EQ(insns[0].kind, RVINSN_ADDI);
+  EXPECT_EQ(insns[0].pc, 0x10000);
+  EXPECT_EQ(insns[0].length, 4);
+  EXPECT_FALSE(insns[0].is_compressed);
+  EXPECT_EQ(insns[0].i.imm, -200);
+
+#ifdef SUPPORT_COMPRESSED
+  EXPECT_EQ(insns[1].kind, RVINSN_ADD);
+  EXPECT_TRUE(insns[1].is_compressed);
+  EXPECT_EQ(insns[1].r.rd, RVREG_a5);
+  EXPECT_EQ(insns[1].r.rs2, RVREG_a2);
+#else
+  EXPECT_EQ(insns[1].kind, RVINSN_ILLEGAL);
+#endif
+  EXPECT_EQ(insns[1].pc, 0x10004);
+  EXPECT_EQ(insns[1].length, 2);
+
+  EXPECT_EQ(insns[2].kind, RVINSN_ADD);
+  EXPECT_EQ(insns[2].pc, 0x10006);
+  EXPECT_EQ(insns[2].r.rd, RVREG_a0);
+
+  EXPECT_EQ(insns[3].kind, RVINSN_ILLEGAL);
+  EXPECT_EQ(insns[3].pc, 0x1000a);
+  EXPECT_EQ(insns[3].length, 4);
+
+  EXPECT_EQ(insns[4].kind, RVINSN_JAL);
+  EXPECT_EQ(insns[4].pc, 0x1000e);
+  EXPECT_EQ(insns[4].j.rd, RVREG_ra);
+}
+
+TEST(buffer, stops_at_truncated_instruction) {
+  struct riscv_insn insns[8];
+  // The last 32-bit instruction has only its first halfword in the buffer
+  size_t n = riscv_decode_buffer(code, sizeof(code), 0x10000, insns, 8);
+  EXPECT_EQ(insns[n - 1].pc + insns[n - 1].length - 0x10000, sizeof(code) - 2);
+
+  EXPECT_EQ(riscv_decode_buffer(code, 3, 0, insns, 8), 0);
+  EXPECT_EQ(riscv_decode_buffer(code, 1, 0, insns, 8), 0);
+}
+
+TEST(buffer, respects_capacity) {
+  struct riscv_insn insns[2];
+  size_t n = riscv_decode_buffer(code, sizeof(code), 0x10000, insns, 2);
+  ASSERT_EQ(n, 2);
+  EXPECT_EQ(insns[1].pc, 0x10004);
+}
+
+TEST(buffer, matches_riscv_decode) {
+  struct riscv_insn insns[8];
+  size_t n = riscv_decode_buffer(code, sizeof(code), 0, insns, 8);
+  for (size_t i = 0; i < n; ++i) {
+    if (insns[i].length != 4 || insns[i].kind == RVINSN_ILLEGAL) {
+      continue;
+    }
+    const uint8_t *p = code + insns[i].pc;
+    struct riscv_insn ins;
+    riscv_decode(&ins, p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+    EXPECT_EQ(ins.kind, insns[i].kind);
+    EXPECT_EQ(ins.type, insns[i].type);
+  }
+}
+
+} // namespace buffer
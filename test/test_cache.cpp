@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+namespace cache {
+
+TEST(cache, rejects_sizes_other_than_powers_of_two) {
+  std::vector<struct riscv_decode_cache_entry> entries(12);
+  struct riscv_decode_cache cache;
+  EXPECT_EQ(riscv_decode_cache_init(&cache, entries.data(), 0, NULL), 0);
+  EXPECT_EQ(riscv_decode_cache_init(&cache, entries.data(), 12, NULL), 0);
+  EXPECT_EQ(riscv_decode_cache_init(&cache, entries.data(), 1, NULL), 0);
+  EXPECT_EQ(riscv_decode_cache_init(&cache, entries.data(), 8, NULL), 1);
+  EXPECT_EQ(riscv_decode_cache_init(&cache, entries.data(), 2, NULL), 1);
+}
+
+TEST(cache, returns_pointer_to_cached_result) {
+  std::vector<struct riscv_decode_cache_entry> entries(64);
+  struct riscv_decode_cache cache;
+  ASSERT_EQ(riscv_decode_cache_init(&cache, entries.data(), entries.size(),
+        NULL), 1);
+
+  uint32_t addi = /* addi a5,s0,-200 */ 0xf3840793;
+  const struct riscv_insn *first = riscv_decode_cache_lookup(&cache, addi);
+  EXPECT_EQ(first->kind, RVINSN_ADDI);
+  EXPECT_EQ(first->i.rd, RVREG_a5);
+  EXPECT_EQ(first->i.rs1, RVREG_s0);
+  EXPECT_EQ(first->i.imm, -200);
+  EXPECT_EQ(cache.misses, 1);
+  EXPECT_EQ(cache.hits, 0);
+
+  const struct riscv_insn *second = riscv_decode_cache_lookup(&cache, addi);
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(cache.misses, 1);
+  EXPECT_EQ(cache.hits, 1);
+
+  riscv_decode_cache_clear(&cache);
+  riscv_decode_cache_lookup(&cache, addi);
+  EXPECT_EQ(cache.misses, 2);
+  EXPECT_EQ(cache.hits, 1);
+}
+
+TEST(cache, keeps_two_words_per_set) {
+  struct riscv_decode_cache_entry entries[2];
+  struct riscv_decode_cache cache;
+  ASSERT_EQ(riscv_decode_cache_init(&cache, entries, 2, NULL), 1);
+
+  uint32_t add = /* add a5,a3,s8 */ 0x018687b3;
+  uint32_t beq = /* beq a5,a3,-18 */ 0xfed787e3;
+  uint32_t addi = /* addi a5,s0,-200 */ 0xf3840793;
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, add)->kind, RVINSN_ADD);
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, beq)->kind, RVINSN_BEQ);
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, add)->kind, RVINSN_ADD);
+  EXPECT_EQ(cache.misses, 2);
+  EXPECT_EQ(cache.hits, 1);
+
+  // Evicts beq, which was used less recently than add
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, addi)->kind, RVINSN_ADDI);
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, add)->kind, RVINSN_ADD);
+  EXPECT_EQ(cache.misses, 3);
+  EXPECT_EQ(cache.hits, 2);
+
+  // Then addi, which add's hit made the least recently used
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, beq)->kind, RVINSN_BEQ);
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, add)->kind, RVINSN_ADD);
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, addi)->kind, RVINSN_ADDI);
+  EXPECT_EQ(cache.misses, 5);
+  EXPECT_EQ(cache.hits, 3);
+}
+
+TEST(cache, matches_riscv_decode_for_random_words) {
+  std::vector<struct riscv_decode_cache_entry> entries(1024);
+  struct riscv_decode_cache cache;
+  ASSERT_EQ(riscv_decode_cache_init(&cache, entries.data(), entries.size(),
+        NULL), 1);
+
+  // A few thousand hot words looked up many times, as in a simulator loop
+  std::mt19937 rng(0xcac4e);
+  std::vector<uint32_t> words(4096);
+  for (uint32_t &word : words) {
+    word = rng();
+  }
+  for (int i = 0; i < 200000; ++i) {
+    uint32_t repr = words[rng() % words.size()];
+    struct riscv_insn expected;
+    memset(&expected, 0, sizeof(expected));
+    int kind = riscv_decode(&expected, repr);
+    const struct riscv_insn *actual = riscv_decode_cache_lookup(&cache, repr);
+    ASSERT_EQ(actual->kind, kind) << std::hex << repr;
+    ASSERT_EQ(memcmp(actual, &expected, sizeof(expected)), 0) << std::hex << repr;
+  }
+  EXPECT_EQ(cache.hits + cache.misses, 200000);
+  EXPECT_GT(cache.hits, 0);
+}
+
+#if defined(SUPPORT_RV32I) && defined(SUPPORT_RV32M)
+TEST(cache, decodes_misses_with_its_profile) {
+  struct riscv_decoder rv32;
+  ASSERT_EQ(riscv_decoder_init(&rv32, 32, RISCV_EXT_M), 1);
+  std::vector<struct riscv_decode_cache_entry> entries(16);
+  struct riscv_decode_cache cache;
+  ASSERT_EQ(riscv_decode_cache_init(&cache, entries.data(), entries.size(),
+        &rv32), 1);
+
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, /* ld a5,0(a5) */ 0x0007b783)->kind,
+      RVINSN_ILLEGAL);
+  EXPECT_EQ(riscv_decode_cache_lookup(&cache, /* mul a0,a0,a1 */ 0x02b50533)->kind,
+      RVINSN_MUL);
+}
+#endif
+
+} // namespace cache
@@ -373,4 +373,26 @@ TEST(rvc_cj, C_JAL) {
 #endif
 }; // namespace test_rvc_cj
 
+namespace test_rvc_pc {
+
+TEST(rvc_pc, decoders_leave_pc_alone) {
+  struct riscv_insn ins;
+  ins.pc = 0x1234;
+  EXPECT_EQ(riscv_decode(&ins, /* li a0,1 */ 0x45050000), RVINSN_ADDI);
+  EXPECT_EQ(ins.pc, 0x1234);
+  EXPECT_EQ(riscv_decode_exact(&ins, /* li a0,1 */ 0x45050000), RVINSN_ADDI);
+  EXPECT_EQ(ins.pc, 0x1234);
+
+  struct riscv_decoder dec;
+#ifdef SUPPORT_RV64I
+  ASSERT_EQ(riscv_decoder_init(&dec, 64, RISCV_EXT_C), 1);
+#else
+  ASSERT_EQ(riscv_decoder_init(&dec, 32, RISCV_EXT_C), 1);
+#endif
+  EXPECT_EQ(riscv_decoder_decode(&dec, &ins, /* li a0,1 */ 0x45050000),
+      RVINSN_ADDI);
+  EXPECT_EQ(ins.pc, 0x1234);
+}
+} // namespace test_rvc_pc
+
 } // namespace btype_insns
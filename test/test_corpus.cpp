@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/corpus.h>
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+namespace corpus {
+
+static std::vector<uint8_t> generate(const struct riscv_corpus_config *config,
+    size_t len) {
+  std::vector<uint8_t> buf(len);
+  struct riscv_corpus *corpus = riscv_corpus_create(config);
+  EXPECT_NE(corpus, nullptr);
+  if (!corpus) {
+    return {};
+  }
+  buf.resize(riscv_corpus_fill(corpus, buf.data(), buf.size()));
+  riscv_corpus_destroy(corpus);
+  return buf;
+}
+
+TEST(corpus, is_reproducible) {
+  struct riscv_corpus_config config;
+  riscv_corpus_config_init(&config);
+  config.seed = 42;
+  auto a = generate(&config, 1 << 16);
+  auto b = generate(&config, 1 << 16);
+  EXPECT_EQ(a, b);
+
+  config.seed = 43;
+  auto c = generate(&config, 1 << 16);
+  EXPECT_NE(a, c);
+}
+
+TEST(corpus, fills_the_same_bytes_in_any_pieces) {
+  struct riscv_corpus_config config;
+  riscv_corpus_config_init(&config);
+  config.seed = 7;
+  auto whole = generate(&config, 4096);
+
+  struct riscv_corpus *corpus = riscv_corpus_create(&config);
+  ASSERT_NE(corpus, nullptr);
+  std::vector<uint8_t> pieces;
+  // Chunks of 1 to 7 bytes, some too small for the next instruction
+  uint8_t chunk[7];
+  for (size_t i = 0; pieces.size() < whole.size(); ++i) {
+    size_t n = riscv_corpus_fill(corpus, chunk, 1 + i % 7);
+    pieces.insert(pieces.end(), chunk, chunk + n);
+  }
+  riscv_corpus_destroy(corpus);
+  pieces.resize(whole.size());
+  EXPECT_EQ(pieces, whole);
+}
+
+#if defined(SUPPORT_RV64I) && defined(SUPPORT_RV64M) && defined(SUPPORT_COMPRESSED)
+TEST(corpus, generates_valid_words_of_their_kind) {
+  for (auto model : { RISCV_IMM_SMALL, RISCV_IMM_UNIFORM }) {
+    struct riscv_corpus_config config;
+    riscv_corpus_config_init(&config);
+    config.xlen = 64;
+    config.extensions = RISCV_EXT_M | RISCV_EXT_C;
+    config.imm_model = model;
+    struct riscv_decoder dec;
+    ASSERT_TRUE(riscv_decoder_init(&dec, 64, config.extensions));
+
+    struct riscv_corpus *corpus = riscv_corpus_create(&config);
+    ASSERT_NE(corpus, nullptr);
+    size_t compressed = 0;
+    for (int i = 0; i < 100000; ++i) {
+      uint32_t word;
+      int kind;
+      unsigned length = riscv_corpus_next(corpus, &word, &kind);
+      struct riscv_insn insn;
+      if (length == 2) {
+        ASSERT_NE(word & 0b11, 0b11u);
+        ASSERT_EQ(word >> 16, 0u);
+        ASSERT_EQ(riscv_decoder_decode(&dec, &insn, word << 16), kind);
+        ++compressed;
+      } else {
+        ASSERT_EQ(length, 4u);
+        ASSERT_EQ(riscv_decoder_decode(&dec, &insn, word), kind)
+          << std::hex << word;
+        // Fields the specification fixes are left alone
+        ASSERT_EQ(riscv_decode_exact(&insn, word), kind) << std::hex << word;
+      }
+    }
+    riscv_corpus_destroy(corpus);
+    EXPECT_GT(compressed, 10000u);
+  }
+}
+#endif
+
+#ifdef SUPPORT_RV32I
+TEST(corpus, keeps_to_the_profile) {
+  struct riscv_corpus_config config;
+  riscv_corpus_config_init(&config);
+  config.xlen = 32;
+  config.extensions = 0;
+  struct riscv_corpus *corpus = riscv_corpus_create(&config);
+  ASSERT_NE(corpus, nullptr);
+  for (int i = 0; i < 20000; ++i) {
+    uint32_t word;
+    int kind;
+    ASSERT_EQ(riscv_corpus_next(corpus, &word, &kind), 4u);
+    ASSERT_EQ(riscv_encodings[kind].set, RISCV_SET_RV32I) << kind;
+  }
+  riscv_corpus_destroy(corpus);
+}
+#endif
+
+TEST(corpus, follows_the_weights) {
+  uint32_t kinds[RVINSN_ILLEGAL] = {};
+  kinds[RVINSN_ADDI] = 3;
+  kinds[RVINSN_BEQ] = 1;
+  uint32_t regs[32] = {};
+  regs[RVREG_a0] = 1;
+  regs[RVREG_sp] = 1;
+
+  struct riscv_corpus_config config;
+  riscv_corpus_config_init(&config);
+  config.kind_weights = kinds;
+  config.reg_weights = regs;
+  config.rvc_percent = 0;
+  struct riscv_corpus *corpus = riscv_corpus_create(&config);
+  ASSERT_NE(corpus, nullptr);
+
+  size_t counts[RVINSN_ILLEGAL] = {};
+  for (int i = 0; i < 40000; ++i) {
+    uint32_t word;
+    int kind;
+    ASSERT_EQ(riscv_corpus_next(corpus, &word, &kind), 4u);
+    ++counts[kind];
+    struct riscv_insn insn;
+    riscv_decode(&insn, word);
+    struct riscv_operands ops;
+    riscv_insn_operands(&insn, &ops);
+    ASSERT_TRUE(ops.rs1 == RVREG_a0 || ops.rs1 == RVREG_sp);
+  }
+  riscv_corpus_destroy(corpus);
+  EXPECT_EQ(counts[RVINSN_ADDI] + counts[RVINSN_BEQ], 40000u);
+  EXPECT_NEAR(counts[RVINSN_ADDI] / 40000.0, 0.75, 0.02);
+}
+
+TEST(corpus, keeps_small_immediates_small) {
+  uint32_t kinds[RVINSN_ILLEGAL] = {};
+  kinds[RVINSN_LD] = 1;
+  kinds[RVINSN_SW] = 1;
+  kinds[RVINSN_FENCE] = 1;
+  struct riscv_corpus_config config;
+  riscv_corpus_config_init(&config);
+  config.kind_weights = kinds;
+  config.rvc_percent = 0;
+  struct riscv_corpus *corpus = riscv_corpus_create(&config);
+  ASSERT_NE(corpus, nullptr);
+
+  size_t small = 0;
+  for (int i = 0; i < 10000; ++i) {
+    uint32_t word;
+    int kind;
+    riscv_corpus_next(corpus, &word, &kind);
+    struct riscv_insn insn;
+    riscv_decode(&insn, word);
+    struct riscv_operands ops;
+    riscv_insn_operands(&insn, &ops);
+    if (kind == RVINSN_FENCE) {
+      ASSERT_EQ(ops.imm, 0xff);
+      continue;
+    }
+    // Offsets are aligned to the access size
+    ASSERT_EQ(ops.imm % (int)riscv_access_size(riscv_kind_flags[kind]), 0);
+    small += ops.imm >= -64 && ops.imm < 64;
+  }
+  riscv_corpus_destroy(corpus);
+  EXPECT_GT(small, 3000u);
+}
+
+#ifdef SUPPORT_COMPRESSED
+TEST(corpus, compresses_every_kind_that_can_be) {
+  uint32_t kinds[RVINSN_ILLEGAL] = {};
+  kinds[RVINSN_ADDI] = 1;
+  struct riscv_corpus_config config;
+  riscv_corpus_config_init(&config);
+  config.kind_weights = kinds;
+  config.rvc_percent = 100;
+  struct riscv_corpus *corpus = riscv_corpus_create(&config);
+  ASSERT_NE(corpus, nullptr);
+  for (int i = 0; i < 1000; ++i) {
+    uint32_t word;
+    ASSERT_EQ(riscv_corpus_next(corpus, &word, nullptr), 2u);
+  }
+  riscv_corpus_destroy(corpus);
+}
+#endif
+
+TEST(corpus, rejects_empty_weights) {
+  uint32_t kinds[RVINSN_ILLEGAL] = {};
+  struct riscv_corpus_config config;
+  riscv_corpus_config_init(&config);
+  config.kind_weights = kinds;
+  EXPECT_EQ(riscv_corpus_create(&config), nullptr);
+
+  config.kind_weights = nullptr;
+  config.xlen = 128;
+  EXPECT_EQ(riscv_corpus_create(&config), nullptr);
+}
+
+TEST(corpus, counts_kinds_of_decoded_code) {
+  const uint32_t words[] = { 0xf3840793, 0xf3840793, 0x00812503, 0 };
+  struct riscv_insn insns[4];
+  for (int i = 0; i < 4; ++i) {
+    riscv_decode(&insns[i], words[i]);
+  }
+  uint32_t weights[RVINSN_ILLEGAL] = {};
+  weights[RVINSN_ADDI] = 1;
+  riscv_corpus_histogram(insns, 4, weights);
+  EXPECT_EQ(weights[RVINSN_ADDI], 3u);
+  EXPECT_EQ(weights[RVINSN_LW], 1u);
+  uint32_t total = 0;
+  for (uint32_t w : weights) {
+    total += w;
+  }
+  EXPECT_EQ(total, 4u);
+}
+
+} // namespace corpus
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/dataflow.h>
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+namespace dataflow {
+
+static constexpr uint64_t x(int reg) {
+  return (uint64_t)1 << reg;
+}
+
+static std::vector<struct riscv_insn> decode(const std::vector<uint32_t> &words) {
+  std::vector<struct riscv_insn> insns(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    memset(&insns[i], 0, sizeof(insns[i]));
+    riscv_decode(&insns[i], words[i]);
+  }
+  return insns;
+}
+
+TEST(dataflow, summarizes_a_block) {
+  auto insns = decode({
+    /* addi a0,zero,1 */ 0x00100513,
+    /* add a1,a0,a2   */ 0x00c505b3,
+    /* sw a1,8(sp)    */ 0x00b12423,
+    /* add a0,a1,a1   */ 0x00b58533,
+  });
+  struct riscv_insn_defs defs[4];
+  struct riscv_block_summary summary;
+  riscv_block_dataflow(insns.data(), insns.size(), defs, &summary);
+
+  EXPECT_EQ(summary.use, x(RVREG_a2) | x(RVREG_sp));
+  EXPECT_EQ(summary.def, x(RVREG_a0) | x(RVREG_a1));
+  EXPECT_EQ(summary.depth, 3u);
+
+  EXPECT_EQ(defs[0].rs1, RISCV_DEF_NONE);
+  EXPECT_EQ(defs[0].rs2, RISCV_DEF_NONE);
+  EXPECT_EQ(defs[1].rs1, 0u);
+  EXPECT_EQ(defs[1].rs2, RISCV_DEF_LIVE_IN);
+  EXPECT_EQ(defs[2].rs1, RISCV_DEF_LIVE_IN);
+  EXPECT_EQ(defs[2].rs2, 1u);
+  EXPECT_EQ(defs[3].rs1, 1u);
+  EXPECT_EQ(defs[3].rs2, 1u);
+}
+
+TEST(dataflow, summarizes_an_empty_block) {
+  struct riscv_block_summary summary;
+  riscv_block_dataflow(nullptr, 0, nullptr, &summary);
+  EXPECT_EQ(summary.use, 0u);
+  EXPECT_EQ(summary.def, 0u);
+  EXPECT_EQ(summary.depth, 0u);
+}
+
+TEST(dataflow, independent_instructions_are_one_step) {
+  auto insns = decode({
+    /* addi a0,zero,1 */ 0x00100513,
+    /* lui a5,0x12    */ 0x000127b7,
+    /* fence          */ 0x0ff0000f,
+    /* ecall          */ 0x00000073,
+  });
+  struct riscv_block_summary summary;
+  riscv_block_dataflow(insns.data(), insns.size(), nullptr, &summary);
+  EXPECT_EQ(summary.use, 0u);
+  EXPECT_EQ(summary.def, x(RVREG_a0) | x(RVREG_a5));
+  EXPECT_EQ(summary.depth, 1u);
+}
+
+TEST(dataflow, matches_the_register_masks) {
+  std::mt19937 rng(0xdf);
+  for (int block = 0; block < 2000; ++block) {
+    std::vector<uint32_t> words(1 + rng() % 32);
+    for (auto &word : words) {
+      word = rng();
+    }
+    auto insns = decode(words);
+    std::vector<struct riscv_insn_defs> defs(insns.size());
+    struct riscv_block_summary summary;
+    riscv_block_dataflow(insns.data(), insns.size(), defs.data(), &summary);
+
+    uint64_t use = 0, def = 0;
+    for (size_t i = 0; i < insns.size(); ++i) {
+      struct riscv_reg_masks m;
+      riscv_insn_regs(&insns[i], &m);
+      use |= m.read & ~def;
+      def |= m.write;
+
+      // Each source names the closest earlier writer of its register
+      struct riscv_operands ops;
+      riscv_insn_operands(&insns[i], &ops);
+      const struct riscv_operand_slots *slots =
+        &riscv_operand_slots[insns[i].kind];
+      uint32_t reg[2] = { ops.rs1, ops.rs2 };
+      uint32_t got[2] = { defs[i].rs1, defs[i].rs2 };
+      bool read[2] = {
+        (slots->reads & RISCV_SLOT_RS1) != 0,
+        (slots->reads & RISCV_SLOT_RS2) != 0,
+      };
+      for (int k = 0; k < 2; ++k) {
+        uint32_t want = RISCV_DEF_NONE;
+        if (read[k] && reg[k] != 0) {
+          want = RISCV_DEF_LIVE_IN;
+          for (size_t j = i; j-- > 0;) {
+            struct riscv_reg_masks w;
+            riscv_insn_regs(&insns[j], &w);
+            if (w.write & x(reg[k])) {
+              want = j;
+              break;
+            }
+          }
+        }
+        ASSERT_EQ(got[k], want) << "block " << block << " insn " << i;
+      }
+    }
+    ASSERT_EQ(summary.use, use);
+    ASSERT_EQ(summary.def, def);
+    ASSERT_GE(summary.depth, 1u);
+    ASSERT_LE(summary.depth, insns.size());
+  }
+}
+
+static struct riscv_block_summary block(uint64_t use, uint64_t def) {
+  struct riscv_block_summary summary;
+  summary.use = use;
+  summary.def = def;
+  summary.depth = 1;
+  return summary;
+}
+
+TEST(dataflow, solves_liveness_of_a_diamond) {
+  const struct riscv_block_summary summaries[4] = {
+    block(x(RVREG_a1), x(RVREG_a2)),
+    block(x(RVREG_a2), x(RVREG_a0)),
+    block(x(RVREG_a3), x(RVREG_a0)),
+    block(x(RVREG_a0), 0),
+  };
+  const uint32_t succs[4][2] = {
+    { 1, 2 },
+    { 3, RISCV_BLOCK_NONE },
+    { RISCV_BLOCK_NONE, 3 },
+    { RISCV_BLOCK_NONE, RISCV_BLOCK_NONE },
+  };
+  uint64_t live_in[4];
+  uint64_t live_out[4] = { 0, 0, 0, x(RVREG_s0) };
+  EXPECT_EQ(riscv_liveness(summaries, succs, 4, live_in, live_out), 2u);
+
+  EXPECT_EQ(live_out[3], x(RVREG_s0));
+  EXPECT_EQ(live_in[3], x(RVREG_a0) | x(RVREG_s0));
+  EXPECT_EQ(live_out[1], x(RVREG_a0) | x(RVREG_s0));
+  EXPECT_EQ(live_in[1], x(RVREG_a2) | x(RVREG_s0));
+  EXPECT_EQ(live_in[2], x(RVREG_a3) | x(RVREG_s0));
+  EXPECT_EQ(live_out[0], x(RVREG_a2) | x(RVREG_a3) | x(RVREG_s0));
+  EXPECT_EQ(live_in[0], x(RVREG_a1) | x(RVREG_a3) | x(RVREG_s0));
+}
+
+TEST(dataflow, solves_liveness_around_a_loop) {
+  const struct riscv_block_summary summaries[3] = {
+    block(0, x(RVREG_t0)),
+    block(x(RVREG_a0) | x(RVREG_t0), x(RVREG_t0)),
+    block(x(RVREG_t0), 0),
+  };
+  const uint32_t succs[3][2] = {
+    { 1, RISCV_BLOCK_NONE },
+    { 1, 2 },
+    { RISCV_BLOCK_NONE, RISCV_BLOCK_NONE },
+  };
+  uint64_t live_in[3];
+  uint64_t live_out[3] = { 0, 0, 0 };
+  riscv_liveness(summaries, succs, 3, live_in, live_out);
+
+  EXPECT_EQ(live_in[2], x(RVREG_t0));
+  EXPECT_EQ(live_out[1], x(RVREG_a0) | x(RVREG_t0));
+  EXPECT_EQ(live_in[1], x(RVREG_a0) | x(RVREG_t0));
+  EXPECT_EQ(live_out[0], x(RVREG_a0) | x(RVREG_t0));
+  EXPECT_EQ(live_in[0], x(RVREG_a0));
+}
+
+TEST(dataflow, liveness_reaches_the_fixed_point) {
+  std::mt19937_64 rng(0x11fe);
+  const size_t n = 500;
+  std::vector<struct riscv_block_summary> summaries(n);
+  std::vector<std::array<uint32_t, 2>> succs(n);
+  std::vector<uint64_t> seed(n);
+  for (size_t b = 0; b < n; ++b) {
+    summaries[b] = block(rng() & rng() & ~1ull, rng() & rng() & ~1ull);
+    for (auto &s : succs[b]) {
+      s = rng() % 4 == 0 ? RISCV_BLOCK_NONE : (uint32_t)(rng() % n);
+    }
+    seed[b] = rng() % 8 == 0 ? rng() & ~1ull : 0;
+  }
+  std::vector<uint64_t> live_in(n), live_out = seed;
+  riscv_liveness(summaries.data(),
+      reinterpret_cast<const uint32_t (*)[2]>(succs.data()), n,
+      live_in.data(), live_out.data());
+
+  for (size_t b = 0; b < n; ++b) {
+    uint64_t out = seed[b];
+    for (uint32_t s : succs[b]) {
+      if (s != RISCV_BLOCK_NONE) {
+        out |= live_in[s];
+      }
+    }
+    ASSERT_EQ(live_out[b], out) << b;
+    ASSERT_EQ(live_in[b], summaries[b].use | (out & ~summaries[b].def)) << b;
+  }
+}
+
+} // namespace dataflow
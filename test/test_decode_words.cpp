@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#include "riscv_decode_simd.h"
+
+namespace decode_words {
+
+typedef void decode_words_fn(const uint32_t *words, size_t n,
+    struct riscv_insn *out);
+
+static void expect_same_as_scalar(const std::vector<uint32_t> &words,
+    decode_words_fn *decode = riscv_decode_words) {
+  std::vector<struct riscv_insn> actual(words.size());
+  decode(words.data(), words.size(), actual.data());
+
+  for (size_t i = 0; i < words.size(); ++i) {
+    uint32_t repr = words[i];
+    if ((repr & 0b11) != 0b11) {
+      ASSERT_EQ(actual[i].kind, RVINSN_ILLEGAL) << std::hex << repr;
+      continue;
+    }
+    struct riscv_insn expected;
+    memset(&expected, 0, sizeof(expected));
+    ASSERT_EQ(riscv_decode_buffer((const uint8_t *)&repr, 4, 0, &expected, 1), 1);
+    ASSERT_EQ(actual[i].kind, expected.kind) << std::hex << repr;
+    ASSERT_EQ(actual[i].type, expected.type) << std::hex << repr;
+    ASSERT_EQ(actual[i].is_compressed, false);
+    ASSERT_EQ(actual[i].length, 4);
+    if (expected.kind != RVINSN_ILLEGAL) {
+      ASSERT_EQ(memcmp(&actual[i].r, &expected.r, sizeof(uint32_t)), 0)
+        << std::hex << repr;
+    }
+  }
+}
+
+TEST(decode_words, matches_scalar_for_every_opcode_funct3_funct7) {
+  std::mt19937 rng(0x51d);
+  std::vector<uint32_t> words;
+  for (uint32_t opcode = 0; opcode < 128; ++opcode) {
+    for (uint32_t funct3 = 0; funct3 < 8; ++funct3) {
+      for (uint32_t funct7 = 0; funct7 < 128; ++funct7) {
+        uint32_t fixed = (funct7 << 25) | (funct3 << 12) | opcode;
+        words.push_back(fixed | (rng() & 0x01ff8f80));
+      }
+    }
+  }
+  expect_same_as_scalar(words);
+}
+
+static std::vector<uint32_t> random_words(size_t n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint32_t> words(n);
+  for (uint32_t &word : words) {
+    word = rng() | 0b11;
+  }
+  return words;
+}
+
+TEST(decode_words, matches_scalar_for_random_words) {
+  // Odd length to exercise the tail of each vector width
+  expect_same_as_scalar(random_words(100003, 0xa5a5));
+}
+
+#ifdef RVDEC_SIMD_X86
+
+// riscv_decode_words() only runs the AVX2 kernel on the tail of the AVX-512
+// one where that is available, so each kernel is run directly as well. The
+// lengths leave a tail past the last full vector of either width.
+
+TEST(decode_words, avx2_kernel_matches_scalar) {
+  if (!__builtin_cpu_supports("avx2")) {
+    GTEST_SKIP() << "no AVX2";
+  }
+  for (size_t n : { 8 * 1024 + 5, 16 * 1024 + 11, 7 }) {
+    expect_same_as_scalar(random_words(n, 0xa2 + n), riscv_decode_words_avx2);
+    if (HasFatalFailure()) {
+      return;
+    }
+  }
+}
+
+TEST(decode_words, avx512_kernel_matches_scalar) {
+  if (!__builtin_cpu_supports("avx512f")) {
+    GTEST_SKIP() << "no AVX-512";
+  }
+  for (size_t n : { 8 * 1024 + 5, 16 * 1024 + 11, 15 }) {
+    expect_same_as_scalar(random_words(n, 0x512 + n),
+        riscv_decode_words_avx512);
+    if (HasFatalFailure()) {
+      return;
+    }
+  }
+}
+
+#endif // RVDEC_SIMD_X86
+
+} // namespace decode_words
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+namespace decoder {
+
+#if defined(SUPPORT_RV32I) && defined(SUPPORT_RV64I) \
+  && defined(SUPPORT_RV32M) && defined(SUPPORT_RV64M)
+
+TEST(decoder, rejects_unknown_profiles) {
+  struct riscv_decoder dec;
+  EXPECT_EQ(riscv_decoder_init(&dec, 128, 0), 0);
+  EXPECT_EQ(riscv_decoder_init(&dec, 16, 0), 0);
+  EXPECT_EQ(riscv_decoder_init(&dec, 64, 1u << 31), 0);
+  EXPECT_EQ(riscv_decoder_init(&dec, 64, RISCV_EXT_M), 1);
+  EXPECT_EQ(dec.xlen, 64);
+  EXPECT_EQ(dec.extensions, RISCV_EXT_M);
+}
+
+TEST(decoder, rv32_rejects_rv64_encodings) {
+  struct riscv_decoder rv32, rv64;
+  ASSERT_EQ(riscv_decoder_init(&rv32, 32, RISCV_EXT_M), 1);
+  ASSERT_EQ(riscv_decoder_init(&rv64, 64, RISCV_EXT_M), 1);
+
+  static const uint32_t rv64_only[] = {
+    /* ld a5,0(a5)      */ 0x0007b783,
+    /* lwu a5,0(a0)     */ 0x00056783,
+    /* sd a5,8(sp)      */ 0x00f13423,
+    /* addiw a5,a5,1    */ 0x0017879b,
+    /* addw a0,a0,a1    */ 0x00b5053b,
+    /* mulw a0,a0,a1    */ 0x02b5053b,
+    /* slli a0,a0,32    */ 0x02051513,
+    /* srli a0,a0,32    */ 0x02055513,
+  };
+  for (uint32_t repr : rv64_only) {
+    struct riscv_insn ins;
+    EXPECT_EQ(riscv_decoder_decode(&rv32, &ins, repr), RVINSN_ILLEGAL)
+      << std::hex << repr;
+    EXPECT_NE(riscv_decoder_decode(&rv64, &ins, repr), RVINSN_ILLEGAL)
+      << std::hex << repr;
+  }
+
+  // Not assigned on either, though riscv_decode() takes them
+  static const uint32_t unassigned[] = {
+    /* srai, funct7 0100101 */ 0x4a055513,
+    /* jalr, funct3 1       */ 0x00f51067,
+  };
+  for (uint32_t repr : unassigned) {
+    struct riscv_insn ins;
+    EXPECT_EQ(riscv_decoder_decode(&rv32, &ins, repr), RVINSN_ILLEGAL)
+      << std::hex << repr;
+    EXPECT_EQ(riscv_decoder_decode(&rv64, &ins, repr), RVINSN_ILLEGAL)
+      << std::hex << repr;
+  }
+
+  struct riscv_insn ins;
+  EXPECT_EQ(riscv_decoder_decode(&rv32, &ins, /* add a5,a3,s8 */ 0x018687b3),
+      RVINSN_ADD);
+  EXPECT_EQ(ins.r.rd, RVREG_a5);
+  EXPECT_EQ(riscv_decoder_decode(&rv64, &ins, /* srli a0,a0,32 */ 0x02055513),
+      RVINSN_SRLI);
+  EXPECT_EQ(riscv_decoder_decode(&rv64, &ins, /* srai a0,a0,33 */ 0x42155513),
+      RVINSN_SRAI);
+  EXPECT_EQ(ins.i.imm, 33);
+}
+
+TEST(decoder, m_extension_is_optional) {
+  struct riscv_decoder rv32i, rv32im;
+  ASSERT_EQ(riscv_decoder_init(&rv32i, 32, 0), 1);
+  ASSERT_EQ(riscv_decoder_init(&rv32im, 32, RISCV_EXT_M), 1);
+
+  struct riscv_insn ins;
+  uint32_t mul = /* mul a0,a0,a1 */ 0x02b50533;
+  EXPECT_EQ(riscv_decoder_decode(&rv32i, &ins, mul), RVINSN_ILLEGAL);
+  EXPECT_EQ(riscv_decoder_decode(&rv32im, &ins, mul), RVINSN_MUL);
+}
+
+TEST(decoder, rv64imc_matches_riscv_decode_exact) {
+  struct riscv_decoder dec;
+  uint32_t extensions = RISCV_EXT_M;
+#ifdef SUPPORT_COMPRESSED
+  extensions |= RISCV_EXT_C;
+#endif
+  ASSERT_EQ(riscv_decoder_init(&dec, 64, extensions), 1);
+
+  std::mt19937 rng(0xdec0);
+  for (int i = 0; i < 1000000; ++i) {
+    uint32_t repr = rng();
+    struct riscv_insn expected, actual;
+    memset(&expected, 0, sizeof(expected));
+    memset(&actual, 0, sizeof(actual));
+    ASSERT_EQ(riscv_decoder_decode(&dec, &actual, repr),
+        riscv_decode_exact(&expected, repr)) << std::hex << repr;
+    ASSERT_EQ(memcmp(&actual, &expected, sizeof(actual)), 0) << std::hex << repr;
+  }
+}
+
+#ifdef SUPPORT_COMPRESSED
+TEST(decoder, compressed_follows_profile) {
+  // c.ld a4,0(a5) on RV64, c.flw on RV32
+  static const uint8_t code[] = { 0x98, 0x63 };
+  struct riscv_decoder rv32c, rv64c, rv64;
+  ASSERT_EQ(riscv_decoder_init(&rv32c, 32, RISCV_EXT_C), 1);
+  ASSERT_EQ(riscv_decoder_init(&rv64c, 64, RISCV_EXT_C), 1);
+  ASSERT_EQ(riscv_decoder_init(&rv64, 64, 0), 1);
+
+  struct riscv_insn ins;
+  ASSERT_EQ(riscv_decoder_decode_buffer(&rv64c, code, sizeof(code), 0, &ins, 1), 1);
+  EXPECT_EQ(ins.kind, RVINSN_LD);
+  EXPECT_EQ(ins.i.rd, RVREG_a4);
+  EXPECT_EQ(ins.i.rs1, RVREG_a5);
+
+  ASSERT_EQ(riscv_decoder_decode_buffer(&rv32c, code, sizeof(code), 0, &ins, 1), 1);
+  EXPECT_NE(ins.kind, RVINSN_LD);
+
+  ASSERT_EQ(riscv_decoder_decode_buffer(&rv64, code, sizeof(code), 0, &ins, 1), 1);
+  EXPECT_EQ(ins.kind, RVINSN_ILLEGAL);
+  EXPECT_EQ(ins.length, 2);
+}
+#endif
+
+#endif
+
+} // namespace decoder
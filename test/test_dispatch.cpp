@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+namespace dispatch {
+
+// Reference implementation: the per-set hook chain `riscv_decode` used to walk
+// before the dispatch table was introduced.
+
+typedef int (*hook_fn)(struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
+
+static const hook_fn reference_hooks[][6] = {
+#ifdef SUPPORT_RV64I
+  { riscv_decode_rv64i_r, riscv_decode_rv64i_i, riscv_decode_rv64i_s,
+    nullptr, nullptr, nullptr },
+#endif
+#if defined(SUPPORT_RV32I) || defined(SUPPORT_RV64I)
+  { riscv_decode_rv32i_r, riscv_decode_rv32i_i, riscv_decode_rv32i_s,
+    riscv_decode_rv32i_b, riscv_decode_rv32i_u, riscv_decode_rv32i_j },
+#endif
+#ifdef SUPPORT_RV64M
+  { riscv_decode_rv64m_r, nullptr, nullptr, nullptr, nullptr, nullptr },
+#endif
+#if defined(SUPPORT_RV32M) || defined(SUPPORT_RV64M)
+  { riscv_decode_rv32m_r, nullptr, nullptr, nullptr, nullptr, nullptr },
+#endif
+};
+
+static int reference_hook_slot(uint32_t opcode) {
+  switch (opcode) {
+    case 0b0110011: case 0b0111011:
+      return 0;
+    case 0b0000011: case 0b0001111: case 0b0010011: case 0b0011011:
+    case 0b1100111: case 0b1110011:
+      return 1;
+    case 0b0100011:
+      return 2;
+    case 0b1100011:
+      return 3;
+    case 0b0010111: case 0b0110111:
+      return 4;
+    case 0b1101111:
+      return 5;
+  }
+  return -1;
+}
+
+static int reference_decode(struct riscv_insn *insn, uint32_t repr) {
+  uint32_t opcode = repr & 0b1111111;
+  int slot = reference_hook_slot(opcode);
+  if (slot >= 0) {
+    for (const auto &hooks : reference_hooks) {
+      if (hooks[slot] && hooks[slot](insn, repr, opcode)) {
+        insn->is_compressed = false;
+        insn->length = 4;
+        return insn->kind;
+      }
+    }
+  }
+#ifdef SUPPORT_COMPRESSED
+  if (rvc_decode(insn, (repr >> 16) & 0xffff) != RVINSN_ILLEGAL) {
+    return insn->kind;
+  }
+#endif
+  insn->kind = RVINSN_ILLEGAL;
+  return insn->kind;
+}
+
+static void expect_same_as_reference(uint32_t repr) {
+  struct riscv_insn expected, actual;
+  memset(&expected, 0, sizeof(expected));
+  memset(&actual, 0, sizeof(actual));
+  int expected_kind = reference_decode(&expected, repr);
+  int actual_kind = riscv_decode(&actual, repr);
+  ASSERT_EQ(actual_kind, expected_kind) << std::hex << repr;
+  ASSERT_EQ(memcmp(&actual, &expected, sizeof(actual)), 0) << std::hex << repr;
+}
+
+TEST(dispatch, matches_hooks_for_every_opcode_funct3_funct7) {
+  std::mt19937 rng(0x5eed);
+  for (uint32_t opcode = 0; opcode < 128; ++opcode) {
+    for (uint32_t funct3 = 0; funct3 < 8; ++funct3) {
+      for (uint32_t funct7 = 0; funct7 < 128; ++funct7) {
+        uint32_t fixed = (funct7 << 25) | (funct3 << 12) | opcode;
+        // Operand fields: all zeros, all ones and a random pattern
+        expect_same_as_reference(fixed);
+        expect_same_as_reference(fixed | 0x01ff8f80);
+        expect_same_as_reference(fixed | (rng() & 0x01ff8f80));
+      }
+    }
+  }
+}
+
+TEST(dispatch, matches_hooks_for_random_words) {
+  std::mt19937 rng(0xdec0de);
+  for (int i = 0; i < 1000000; ++i) {
+    expect_same_as_reference(rng());
+  }
+}
+
+} // namespace dispatch
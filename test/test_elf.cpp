@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/elf.h>
+#include <rvdec/instruction.h>
+
+namespace elf {
+
+static const uint8_t text[] = {
+  /* addi a5,s0,-200 */ 0x93, 0x07, 0x84, 0xf3,
+  /* c.li a0,1       */ 0x05, 0x45,
+  /* jal ra,-0x72e   */ 0xef, 0xf0, 0xff, 0x8c,
+};
+
+struct image {
+  std::vector<uint8_t> bytes;
+
+  void put(size_t offset, uint64_t value, int size) {
+    if (bytes.size() < offset + size) {
+      bytes.resize(offset + size);
+    }
+    for (int i = 0; i < size; ++i) {
+      bytes[offset + i] = value >> (8 * i);
+    }
+  }
+};
+
+/* File with an ELF header, one PT_LOAD segment of `text` at 0x10000 and the
+ * section headers of a null section, .text, a non-executable .data and
+ * .shstrtab. */
+static std::vector<uint8_t> build_elf(bool is64, uint32_t flags,
+    uint16_t machine = 243) {
+  image img;
+  int w = is64 ? 8 : 4;
+  size_t ehdr = is64 ? 64 : 52, phdr = is64 ? 56 : 32, shdr = is64 ? 64 : 40;
+  static const char names[] = "\0.text\0.data\0.shstrtab";
+  size_t text_off = 0x100, data_off = 0x120, names_off = 0x140;
+  size_t shoff = 0x180;
+
+  img.put(0, 0x464c457f, 4);
+  img.put(4, is64 ? 2 : 1, 1);
+  img.put(5, 1, 1);
+  img.put(6, 1, 1);
+  img.put(16, 2, 2);
+  img.put(18, machine, 2);
+  img.put(20, 1, 4);
+  img.put(24, 0x10000, w);
+  img.put(24 + w, ehdr, w);
+  img.put(24 + 2 * w, shoff, w);
+  img.put(24 + 3 * w, flags, 4);
+  img.put(28 + 3 * w, ehdr, 2);
+  img.put(30 + 3 * w, phdr, 2);
+  img.put(32 + 3 * w, 1, 2);
+  img.put(34 + 3 * w, shdr, 2);
+  img.put(36 + 3 * w, 4, 2);
+  img.put(38 + 3 * w, 3, 2);
+
+  size_t ph = ehdr;
+  img.put(ph, 1, 4);
+  if (is64) {
+    img.put(ph + 4, 0x5, 4);
+    img.put(ph + 8, text_off, 8);
+    img.put(ph + 16, 0x10000, 8);
+    img.put(ph + 32, sizeof(text), 8);
+    img.put(ph + 40, sizeof(text), 8);
+  } else {
+    img.put(ph + 4, text_off, 4);
+    img.put(ph + 8, 0x10000, 4);
+    img.put(ph + 16, sizeof(text), 4);
+    img.put(ph + 20, sizeof(text), 4);
+    img.put(ph + 24, 0x5, 4);
+  }
+
+  for (size_t i = 0; i < sizeof(text); ++i) {
+    img.put(text_off + i, text[i], 1);
+  }
+  img.put(data_off, 0xffffffff, 4);
+  for (size_t i = 0; i < sizeof(names); ++i) {
+    img.put(names_off + i, names[i], 1);
+  }
+
+  struct { uint32_t name, type; uint64_t flags, addr, offset, size; } sections[] = {
+    { 0, 0, 0, 0, 0, 0 },
+    { 1, 1, 0x6, 0x10000, text_off, sizeof(text) },
+    { 7, 1, 0x3, 0x20000, data_off, 4 },
+    { 13, 3, 0, 0, names_off, sizeof(names) },
+  };
+  for (size_t i = 0; i < 4; ++i) {
+    size_t sh = shoff + i * shdr;
+    img.put(sh, sections[i].name, 4);
+    img.put(sh + 4, sections[i].type, 4);
+    img.put(sh + 8, sections[i].flags, w);
+    img.put(sh + 8 + w, sections[i].addr, w);
+    img.put(sh + 8 + 2 * w, sections[i].offset, w);
+    img.put(sh + 8 + 3 * w, sections[i].size, w);
+  }
+  img.bytes.resize(shoff + 4 * shdr);
+  return img.bytes;
+}
+
+static void expect_text_spans(const struct riscv_elf &elf) {
+  ASSERT_EQ(elf.nsections, 1);
+  EXPECT_STREQ(elf.sections[0].name, ".text");
+  EXPECT_EQ(elf.sections[0].addr, 0x10000);
+  EXPECT_EQ(elf.sections[0].size, sizeof(text));
+  EXPECT_EQ(memcmp(elf.sections[0].data, text, sizeof(text)), 0);
+
+  ASSERT_EQ(elf.nsegments, 1);
+  EXPECT_EQ(elf.segments[0].name, nullptr);
+  EXPECT_EQ(elf.segments[0].addr, 0x10000);
+  EXPECT_EQ(elf.segments[0].data, elf.sections[0].data);
+  EXPECT_EQ(elf.entry, 0x10000);
+}
+
+TEST(elf, reads_elf64) {
+  std::vector<uint8_t> file = build_elf(true, 0x5);
+  struct riscv_elf elf;
+  ASSERT_EQ(riscv_elf_parse(&elf, file.data(), file.size()), 1);
+  EXPECT_EQ(elf.xlen, 64);
+  EXPECT_TRUE(elf.rvc);
+  EXPECT_EQ(elf.flags, 0x5);
+  expect_text_spans(elf);
+  // Spans point into the file
+  EXPECT_EQ(elf.sections[0].data, file.data() + 0x100);
+  riscv_elf_close(&elf);
+}
+
+TEST(elf, reads_elf32) {
+  std::vector<uint8_t> file = build_elf(false, 0);
+  struct riscv_elf elf;
+  ASSERT_EQ(riscv_elf_parse(&elf, file.data(), file.size()), 1);
+  EXPECT_EQ(elf.xlen, 32);
+  EXPECT_FALSE(elf.rvc);
+  expect_text_spans(elf);
+  riscv_elf_close(&elf);
+}
+
+TEST(elf, rejects_malformed_files) {
+  struct riscv_elf elf;
+  std::vector<uint8_t> file = build_elf(true, 0x5);
+
+  std::vector<uint8_t> x86 = build_elf(true, 0, /* EM_X86_64 */ 62);
+  EXPECT_EQ(riscv_elf_parse(&elf, x86.data(), x86.size()), 0);
+
+  EXPECT_EQ(riscv_elf_parse(&elf, file.data(), 40), 0);
+  // Section headers past the end of the file
+  EXPECT_EQ(riscv_elf_parse(&elf, file.data(), 0x190), 0);
+
+  std::vector<uint8_t> big_endian = file;
+  big_endian[5] = 2;
+  EXPECT_EQ(riscv_elf_parse(&elf, big_endian.data(), big_endian.size()), 0);
+
+  std::vector<uint8_t> bad_segment = file;
+  bad_segment[64 + 32] = 0xff;
+  bad_segment[64 + 33] = 0xff;
+  EXPECT_EQ(riscv_elf_parse(&elf, bad_segment.data(), bad_segment.size()), 0);
+}
+
+#if defined(SUPPORT_RV64I) && defined(SUPPORT_COMPRESSED)
+TEST(elf, maps_file_and_decodes_text) {
+  std::vector<uint8_t> file = build_elf(true, 0x5);
+  char path[] = "/tmp/rvdec_elf_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(write(fd, file.data(), file.size()), (ssize_t)file.size());
+  close(fd);
+
+  struct riscv_elf elf;
+  ASSERT_EQ(riscv_elf_open(&elf, path), 1);
+  unlink(path);
+  expect_text_spans(elf);
+
+  struct riscv_decoder dec;
+  ASSERT_EQ(riscv_elf_decoder_init(&elf, &dec, RISCV_EXT_M), 1);
+  EXPECT_EQ(dec.xlen, 64);
+  EXPECT_EQ(dec.extensions, RISCV_EXT_M | RISCV_EXT_C);
+
+  struct riscv_insn insns[4];
+  const struct riscv_elf_span &span = elf.sections[0];
+  ASSERT_EQ(riscv_decoder_decode_buffer(&dec, span.data, span.size, span.addr,
+        insns, 4), 3);
+  EXPECT_EQ(insns[0].kind, RVINSN_ADDI);
+  EXPECT_EQ(insns[1].kind, RVINSN_ADDI);
+  EXPECT_TRUE(insns[1].is_compressed);
+  EXPECT_EQ(insns[2].kind, RVINSN_JAL);
+  EXPECT_EQ(insns[2].pc, 0x10006);
+  riscv_elf_close(&elf);
+
+  EXPECT_EQ(riscv_elf_open(&elf, path), 0);
+}
+#endif
+
+} // namespace elf
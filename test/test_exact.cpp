@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+namespace exact {
+
+TEST(exact, encodings_come_from_defs) {
+  EXPECT_EQ(riscv_encodings[RVINSN_ADD].mask, 0xfe00707f);
+  EXPECT_EQ(riscv_encodings[RVINSN_ADD].match, 0x00000033);
+  EXPECT_EQ(riscv_encodings[RVINSN_ADD].type, INSN_R);
+  EXPECT_EQ(riscv_encodings[RVINSN_ADD].set, RISCV_SET_RV32I);
+
+  // Declared by RV32I first, RV64I redeclares it with a 6-bit shamt
+  EXPECT_EQ(riscv_encodings[RVINSN_SLLI].mask, 0xfe00707f);
+  EXPECT_EQ(riscv_encodings[RVINSN_SLLI].set, RISCV_SET_RV32I);
+
+  EXPECT_EQ(riscv_encodings[RVINSN_FENCE].type, INSN_FENCE);
+  EXPECT_EQ(riscv_encodings[RVINSN_MULW].set, RISCV_SET_RV64M);
+
+  for (int kind = 0; kind < RVINSN_ILLEGAL; ++kind) {
+    EXPECT_NE(riscv_encodings[kind].mask, 0) << riscv_kind_names[kind];
+    EXPECT_EQ(riscv_encodings[kind].match & ~riscv_encodings[kind].mask, 0)
+      << riscv_kind_names[kind];
+  }
+}
+
+#if defined(SUPPORT_RV64I) && defined(SUPPORT_RV64M)
+TEST(exact, decodes_every_declared_encoding) {
+  for (int kind = 0; kind < RVINSN_ILLEGAL; ++kind) {
+    struct riscv_insn ins;
+    uint32_t repr = riscv_encodings[kind].match;
+    EXPECT_EQ(riscv_decode_exact(&ins, repr), kind) << riscv_kind_names[kind];
+    EXPECT_EQ(riscv_decode(&ins, repr), kind) << riscv_kind_names[kind];
+  }
+}
+#endif
+
+static void expect_subset_of_riscv_decode(uint32_t repr) {
+  struct riscv_insn expected, actual;
+  memset(&expected, 0, sizeof(expected));
+  memset(&actual, 0, sizeof(actual));
+  int kind = riscv_decode_exact(&actual, repr);
+  // Words that riscv_decode() accepts but this doesn't may then decode as a
+  // compressed instruction in their upper halfword
+  if (kind == RVINSN_ILLEGAL || actual.is_compressed) {
+    return;
+  }
+  ASSERT_EQ(riscv_decode(&expected, repr), kind) << std::hex << repr;
+  ASSERT_EQ(memcmp(&actual, &expected, sizeof(actual)), 0) << std::hex << repr;
+}
+
+TEST(exact, agrees_with_riscv_decode_for_every_opcode_funct3_funct7) {
+  std::mt19937 rng(0xe8ac);
+  for (uint32_t opcode = 0; opcode < 128; ++opcode) {
+    for (uint32_t funct3 = 0; funct3 < 8; ++funct3) {
+      for (uint32_t funct7 = 0; funct7 < 128; ++funct7) {
+        uint32_t fixed = (funct7 << 25) | (funct3 << 12) | opcode;
+        expect_subset_of_riscv_decode(fixed);
+        expect_subset_of_riscv_decode(fixed | 0x01ff8f80);
+        expect_subset_of_riscv_decode(fixed | (rng() & 0x01ff8f80));
+      }
+    }
+  }
+}
+
+TEST(exact, agrees_with_riscv_decode_for_random_words) {
+  std::mt19937 rng(0xe8ad);
+  for (int i = 0; i < 1000000; ++i) {
+    expect_subset_of_riscv_decode(rng());
+  }
+}
+
+TEST(exact, rejects_fields_riscv_decode_ignores) {
+  struct riscv_insn ins;
+  // jalr with funct3 = 001
+  uint32_t jalr = 0x000780e7 | (0b001 << 12);
+  EXPECT_EQ(riscv_decode(&ins, jalr), RVINSN_JALR);
+  EXPECT_EQ(riscv_decode_exact(&ins, jalr), RVINSN_ILLEGAL);
+
+  // ecall with rd = a0
+  uint32_t ecall = 0x00000073 | (RVREG_a0 << 7);
+  EXPECT_EQ(riscv_decode(&ins, ecall), RVINSN_ECALL);
+  EXPECT_EQ(riscv_decode_exact(&ins, ecall), RVINSN_ILLEGAL);
+
+  EXPECT_EQ(riscv_decode_exact(&ins, 0x00000073), RVINSN_ECALL);
+  EXPECT_EQ(riscv_decode_exact(&ins, 0x00100073), RVINSN_EBREAK);
+}
+
+} // namespace exact
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+namespace flags {
+
+TEST(flags, classify_control_flow) {
+  EXPECT_EQ(riscv_kind_flags[RVINSN_BEQ], RISCV_FLAG_BRANCH);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_BGEU], RISCV_FLAG_BRANCH);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_JAL], RISCV_FLAG_JUMP);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_JALR],
+      RISCV_FLAG_JUMP | RISCV_FLAG_INDIRECT);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_ECALL], RISCV_FLAG_SYSTEM);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_EBREAK], RISCV_FLAG_SYSTEM);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_FENCE], RISCV_FLAG_FENCE);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_ILLEGAL], RISCV_FLAG_ILLEGAL);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_ADD], 0u);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_LUI], 0u);
+}
+
+TEST(flags, carry_access_sizes) {
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_LB]), 1u);
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_LHU]), 2u);
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_LW]), 4u);
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_SB]), 1u);
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_SH]), 2u);
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_SW]), 4u);
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_ADD]), 0u);
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_ILLEGAL]), 0u);
+
+  EXPECT_FALSE(riscv_kind_flags[RVINSN_LB] & RISCV_FLAG_UNSIGNED);
+  EXPECT_FALSE(riscv_kind_flags[RVINSN_LW] & RISCV_FLAG_UNSIGNED);
+  EXPECT_TRUE(riscv_kind_flags[RVINSN_LBU] & RISCV_FLAG_UNSIGNED);
+  EXPECT_TRUE(riscv_kind_flags[RVINSN_LHU] & RISCV_FLAG_UNSIGNED);
+  EXPECT_TRUE(riscv_kind_flags[RVINSN_LBU] & RISCV_FLAG_LOAD);
+  EXPECT_TRUE(riscv_kind_flags[RVINSN_SW] & RISCV_FLAG_STORE);
+}
+
+TEST(flags, classify_rv64) {
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_LD]), 8u);
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_SD]), 8u);
+  EXPECT_EQ(riscv_access_size(riscv_kind_flags[RVINSN_LWU]), 4u);
+  EXPECT_TRUE(riscv_kind_flags[RVINSN_LWU] & RISCV_FLAG_UNSIGNED);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_ADDIW], RISCV_FLAG_WORD);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_SRAW], RISCV_FLAG_WORD);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_ADD] & RISCV_FLAG_WORD, 0u);
+}
+
+TEST(flags, classify_m) {
+  for (int kind : { RVINSN_MUL, RVINSN_MULH, RVINSN_MULHSU, RVINSN_MULHU }) {
+    EXPECT_EQ(riscv_kind_flags[kind], RISCV_FLAG_MUL) << kind;
+  }
+  for (int kind : { RVINSN_DIV, RVINSN_DIVU, RVINSN_REM, RVINSN_REMU }) {
+    EXPECT_EQ(riscv_kind_flags[kind], RISCV_FLAG_DIV) << kind;
+  }
+  EXPECT_EQ(riscv_kind_flags[RVINSN_MULW], RISCV_FLAG_MUL | RISCV_FLAG_WORD);
+  EXPECT_EQ(riscv_kind_flags[RVINSN_REMUW], RISCV_FLAG_DIV | RISCV_FLAG_WORD);
+}
+
+TEST(flags, match_the_encodings) {
+  for (int kind = 0; kind < RVINSN_ILLEGAL; ++kind) {
+    uint32_t flags = riscv_kind_flags[kind];
+    uint32_t opcode = riscv_encodings[kind].match & 0b1111111;
+    EXPECT_EQ(!!(flags & RISCV_FLAG_LOAD), opcode == 0b0000011) << kind;
+    EXPECT_EQ(!!(flags & RISCV_FLAG_STORE), opcode == 0b0100011) << kind;
+    EXPECT_EQ(!!(flags & RISCV_FLAG_BRANCH),
+        riscv_encodings[kind].type == INSN_B) << kind;
+    EXPECT_FALSE(flags & (RISCV_FLAG_COMPRESSED | RISCV_FLAG_ILLEGAL)) << kind;
+  }
+}
+
+#ifdef SUPPORT_COMPRESSED
+TEST(flags, mark_compressed_instructions) {
+  struct riscv_insn insn;
+  memset(&insn, 0, sizeof(insn));
+  // c.lw a0,0(a1)
+  riscv_decode(&insn, 0x4188u << 16);
+  ASSERT_EQ(insn.kind, RVINSN_LW);
+  EXPECT_EQ(riscv_insn_flags(&insn),
+      riscv_kind_flags[RVINSN_LW] | RISCV_FLAG_COMPRESSED);
+
+  // lw a0,8(sp)
+  riscv_decode(&insn, 0x00812503);
+  EXPECT_EQ(riscv_insn_flags(&insn), riscv_kind_flags[RVINSN_LW]);
+}
+#endif
+
+} // namespace flags
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/format.h>
+#include <rvdec/instruction.h>
+
+namespace format {
+
+static std::string format(uint32_t repr, uint64_t pc = 0) {
+  struct riscv_insn insn;
+  memset(&insn, 0, sizeof(insn));
+  riscv_decode(&insn, repr);
+  char buf[RISCV_FORMAT_MAX];
+  size_t length = riscv_format(&insn, pc, buf, sizeof(buf));
+  EXPECT_EQ(length, strlen(buf));
+  return buf;
+}
+
+TEST(format, writes_rv32i) {
+  EXPECT_EQ(format(0xf3840793), "addi\ta5,s0,-200");
+  EXPECT_EQ(format(0x00812503), "lw\ta0,8(sp)");
+  EXPECT_EQ(format(0x00a12423), "sw\ta0,8(sp)");
+  EXPECT_EQ(format(0x000780e7), "jalr\tra,0(a5)");
+  EXPECT_EQ(format(0x000127b7), "lui\ta5,0x12");
+  EXPECT_EQ(format(0xfffff517), "auipc\ta0,0xfffff");
+  EXPECT_EQ(format(0x00351513), "slli\ta0,a0,0x3");
+  EXPECT_EQ(format(0x40355513), "srai\ta0,a0,0x3");
+  EXPECT_EQ(format(0x00000073), "ecall");
+  EXPECT_EQ(format(0x00100073), "ebreak");
+}
+
+TEST(format, writes_targets_as_addresses) {
+  EXPECT_EQ(format(0x00b50463, 0x1000), "beq\ta0,a1,1008");
+  EXPECT_EQ(format(0xfe051ee3, 0x1000), "bne\ta0,zero,ffc");
+  EXPECT_EQ(format(0x010000ef, 0x10000), "jal\tra,10010");
+  EXPECT_EQ(format(0xfe051ee3, 0xffffffff80000000ull),
+      "bne\ta0,zero,ffffffff7ffffffc");
+  // All 16 digits, with the top nibble set
+  EXPECT_EQ(format(0x010000ef, 0xf000000000000000ull),
+      "jal\tra,f000000000000010");
+}
+
+TEST(format, writes_addresses_with_the_top_nibble_set) {
+  struct riscv_insn insn;
+  memset(&insn, 0, sizeof(insn));
+  riscv_decode(&insn, 0x00b50463);
+  insn.pc = 0xfffffffffffffff0ull;
+  char buf[RISCV_FORMAT_LINE_MAX];
+  size_t length;
+  ASSERT_EQ(riscv_format_batch(&insn, 1, buf, sizeof(buf), &length), 1);
+  EXPECT_EQ(std::string(buf, length),
+      "fffffffffffffff0:\tbeq\ta0,a1,fffffffffffffff8\n");
+}
+
+TEST(format, writes_fence_sets) {
+  EXPECT_EQ(format(0x0ff0000f), "fence\tiorw,iorw");
+  EXPECT_EQ(format(0x0210000f), "fence\tr,w");
+  EXPECT_EQ(format(0x8330000f), "fence.tso");
+}
+
+#if defined(SUPPORT_RV64I) && defined(SUPPORT_RV64M)
+TEST(format, writes_rv64_and_m) {
+  EXPECT_EQ(format(0xffadbc23), "sd\ts10,-8(s11)");
+  EXPECT_EQ(format(0x03fdad33), "mulhsu\ts10,s11,t6");
+}
+#endif
+
+#ifdef SUPPORT_COMPRESSED
+TEST(format, writes_compressed_as_expansion) {
+  // c.li a0,1
+  EXPECT_EQ(format(0x4505u << 16), "addi\ta0,zero,1");
+}
+#endif
+
+TEST(format, writes_illegal) {
+  EXPECT_EQ(format(0), "illegal");
+}
+
+TEST(format, fits_in_the_maximum_lengths) {
+  std::mt19937 rng(0xf0);
+  struct riscv_insn insn;
+  // Padding past the buffers catches writes beyond the documented room
+  char buf[RISCV_FORMAT_LINE_MAX + 16];
+  for (int i = 0; i < 200000; ++i) {
+    memset(&insn, 0, sizeof(insn));
+    riscv_decode(&insn, rng());
+    insn.pc = (uint64_t)rng() << 32 | rng();
+    memset(buf, 'x', sizeof(buf));
+    size_t length = riscv_format(&insn, insn.pc, buf, RISCV_FORMAT_MAX);
+    ASSERT_LT(length, RISCV_FORMAT_MAX);
+    ASSERT_EQ(buf[RISCV_FORMAT_MAX], 'x');
+
+    memset(buf, 'x', sizeof(buf));
+    ASSERT_EQ(riscv_format_batch(&insn, 1, buf, RISCV_FORMAT_LINE_MAX,
+          &length), 1);
+    ASSERT_LE(length, RISCV_FORMAT_LINE_MAX);
+    ASSERT_EQ(buf[RISCV_FORMAT_LINE_MAX], 'x');
+  }
+}
+
+TEST(format, truncates_like_snprintf) {
+  struct riscv_insn insn;
+  riscv_decode(&insn, 0xf3840793);
+  char buf[8];
+  memset(buf, 'x', sizeof(buf));
+  EXPECT_EQ(riscv_format(&insn, 0, buf, 5), 15);
+  EXPECT_STREQ(buf, "addi");
+  EXPECT_EQ(buf[5], 'x');
+  EXPECT_EQ(riscv_format(&insn, 0, buf, 0), 15);
+  EXPECT_EQ(buf[0], 'a');
+}
+
+#if defined(SUPPORT_RV32I) && defined(SUPPORT_COMPRESSED)
+TEST(format, formats_batches_of_lines) {
+  const uint8_t code[] = {
+    /* addi a5,s0,-200 */ 0x93, 0x07, 0x84, 0xf3,
+    /* c.li a0,1       */ 0x05, 0x45,
+    /* jal ra,0x10016  */ 0xef, 0x00, 0x00, 0x01,
+  };
+  struct riscv_insn insns[3];
+  ASSERT_EQ(riscv_decode_buffer(code, sizeof(code), 0x10000, insns, 3), 3);
+
+  std::vector<char> buf(3 * RISCV_FORMAT_LINE_MAX);
+  size_t length;
+  ASSERT_EQ(riscv_format_batch(insns, 3, buf.data(), buf.size(), &length), 3);
+  EXPECT_EQ(std::string(buf.data(), length),
+      "   10000:\taddi\ta5,s0,-200\n"
+      "   10004:\taddi\ta0,zero,1\n"
+      "   10006:\tjal\tra,10016\n");
+
+  // Each line needs RISCV_FORMAT_LINE_MAX bytes of room, which is left for
+  // the second line but not the third
+  ASSERT_EQ(riscv_format_batch(insns, 3, buf.data(),
+        26 + 25 + RISCV_FORMAT_LINE_MAX - 1, &length), 2);
+  EXPECT_EQ(std::string(buf.data(), length),
+      "   10000:\taddi\ta5,s0,-200\n"
+      "   10004:\taddi\ta0,zero,1\n");
+
+  insns[0].pc = 0x123456789abcdef0ull;
+  ASSERT_EQ(riscv_format_batch(insns, 1, buf.data(), buf.size(), &length), 1);
+  EXPECT_EQ(std::string(buf.data(), length),
+      "123456789abcdef0:\taddi\ta5,s0,-200\n");
+}
+#endif
+
+} // namespace format
@@ -180,6 +180,17 @@ TEST(rv64i, itype_instructions_srli) {
   EXPECT_EQ(ins.i.rs1, RVREG_s3);
 }
 
+TEST(rv64i, itype_instructions_srli_shamt5) {
+  struct riscv_insn ins;
+  // shamt[5] is the low bit of what RV32I takes for funct7
+  riscv_decode(&ins, /* srli a0,a0,0x20 */ 0x02055513);
+  EXPECT_EQ(ins.type, INSN_I);
+  EXPECT_EQ(ins.kind, RVINSN_SRLI);
+  EXPECT_EQ(ins.i.imm, 0x20);
+  EXPECT_EQ(ins.i.rd, RVREG_a0);
+  EXPECT_EQ(ins.i.rs1, RVREG_a0);
+}
+
 TEST(rv64i, itype_instructions_srai) {
   struct riscv_insn ins;
   riscv_decode(&ins, /* srai s3,s3,0x3f */ 0x43f9d993);
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+#include "test_util.h"
+
+namespace packed {
+
+TEST(packed, is_8_bytes) {
+  EXPECT_EQ(sizeof(struct riscv_insn_packed), 8);
+}
+
+TEST(packed, fields_are_at_fixed_positions) {
+  struct riscv_insn ins;
+  struct riscv_insn_packed p;
+
+  riscv_decode(&ins, /* 142c2: beq a5,a3,142b0 */ 0xfed787e3);
+  riscv_insn_pack(&ins, &p);
+  EXPECT_EQ(p.kind, RVINSN_BEQ);
+  EXPECT_EQ(riscv_packed_rd(&p), 0);
+  EXPECT_EQ(riscv_packed_rs1(&p), RVREG_a5);
+  EXPECT_EQ(riscv_packed_rs2(&p), RVREG_a3);
+  EXPECT_EQ(p.imm, 0x142b0 - 0x142c2);
+  EXPECT_EQ(riscv_packed_length(&p), 4);
+  EXPECT_FALSE(riscv_packed_is_compressed(&p));
+
+  riscv_decode(&ins, /* addi a5,s0,-200 */ 0xf3840793);
+  riscv_insn_pack(&ins, &p);
+  EXPECT_EQ(p.kind, RVINSN_ADDI);
+  EXPECT_EQ(riscv_packed_rd(&p), RVREG_a5);
+  EXPECT_EQ(riscv_packed_rs1(&p), RVREG_s0);
+  EXPECT_EQ(p.imm, -200);
+
+#ifdef SUPPORT_COMPRESSED
+  riscv_decode(&ins, /* mv a5,a2 */ 0x87b20000);
+  riscv_insn_pack(&ins, &p);
+  EXPECT_EQ(p.kind, RVINSN_ADD);
+  EXPECT_EQ(riscv_packed_rd(&p), RVREG_a5);
+  EXPECT_EQ(riscv_packed_rs2(&p), RVREG_a2);
+  EXPECT_EQ(riscv_packed_length(&p), 2);
+  EXPECT_TRUE(riscv_packed_is_compressed(&p));
+#endif
+}
+
+static void expect_round_trip(const std::vector<uint8_t> &buf) {
+  std::vector<struct riscv_insn> insns(buf.size() / 2);
+  size_t n = riscv_decode_buffer(buf.data(), buf.size(), 0, insns.data(),
+      insns.size());
+  std::vector<struct riscv_insn_packed> packed(insns.size());
+  ASSERT_EQ(riscv_decode_buffer_packed(buf.data(), buf.size(), packed.data(),
+        packed.size()), n);
+
+  for (size_t i = 0; i < n; ++i) {
+    const struct riscv_insn &expected = insns[i];
+    struct riscv_insn_packed p;
+    riscv_insn_pack(&expected, &p);
+    ASSERT_EQ(memcmp(&p, &packed[i], sizeof(p)), 0) << i;
+
+    struct riscv_insn actual;
+    riscv_insn_unpack(&p, &actual);
+    ASSERT_EQ(actual.kind, expected.kind) << i;
+    ASSERT_EQ(actual.type, expected.type) << i;
+    ASSERT_EQ(actual.is_compressed, expected.is_compressed) << i;
+    ASSERT_EQ(actual.length, expected.length) << i;
+
+    // These accept encodings with any funct3, which the kind doesn't keep
+    switch (expected.kind) {
+      case RVINSN_JALR:
+      case RVINSN_FENCE:
+      case RVINSN_ECALL:
+      case RVINSN_EBREAK:
+      case RVINSN_ILLEGAL:
+        continue;
+    }
+    ASSERT_EQ(memcmp(&actual.r, &expected.r, sizeof(uint32_t)), 0) << i;
+  }
+}
+
+TEST(packed, round_trips_random_code) {
+  expect_round_trip(random_code(0xbac4, 1 << 16));
+}
+
+TEST(packed, round_trips_every_opcode_funct3_funct7) {
+  std::mt19937 rng(0xbac5);
+  std::vector<uint8_t> buf;
+  for (uint32_t opcode = 0b11; opcode < 128; opcode += 4) {
+    for (uint32_t funct3 = 0; funct3 < 8; ++funct3) {
+      for (uint32_t funct7 = 0; funct7 < 128; ++funct7) {
+        uint32_t repr = (funct7 << 25) | (funct3 << 12) | opcode
+          | (rng() & 0x01ff8f80);
+        for (int i = 0; i < 4; ++i) {
+          buf.push_back(repr >> (8 * i));
+        }
+      }
+    }
+  }
+  expect_round_trip(buf);
+}
+
+#ifdef SUPPORT_COMPRESSED
+TEST(packed, round_trips_every_compressed_instruction) {
+  std::vector<uint8_t> buf;
+  for (uint32_t repr = 0; repr < (1 << 16); ++repr) {
+    if ((repr & 0b11) != 0b11) {
+      buf.push_back(repr);
+      buf.push_back(repr >> 8);
+    }
+  }
+  expect_round_trip(buf);
+}
+#endif
+
+} // namespace packed
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/page_cache.h>
+#include <rvdec/register.h>
+
+#include "test_util.h"
+
+namespace page_cache {
+
+// Guest memory of `bytes.size()` bytes at `base`
+struct guest {
+  uint64_t base;
+  std::vector<uint8_t> bytes;
+  int fetches = 0;
+
+  static size_t fetch(void *ctx, uint64_t addr, uint8_t *buf, size_t len) {
+    guest *mem = static_cast<guest *>(ctx);
+    ++mem->fetches;
+    if (addr < mem->base || addr - mem->base >= mem->bytes.size()) {
+      return 0;
+    }
+    size_t offset = addr - mem->base;
+    size_t n = std::min(len, mem->bytes.size() - offset);
+    memcpy(buf, mem->bytes.data() + offset, n);
+    return n;
+  }
+
+  void store32(uint64_t addr, uint32_t word) {
+    for (int i = 0; i < 4; ++i) {
+      bytes[addr - base + i] = word >> (8 * i);
+    }
+  }
+};
+
+static guest random_guest(uint32_t seed, size_t pages) {
+  guest mem;
+  mem.base = 0x80000000;
+  mem.bytes = random_code(seed, pages * RISCV_PAGE_SIZE);
+  return mem;
+}
+
+TEST(page_cache, slots_match_decode_buffer_at_every_halfword) {
+  guest mem = random_guest(0x9a9e, 3);
+  struct riscv_page_cache *cache = riscv_page_cache_create(4, NULL,
+      guest::fetch, &mem);
+  ASSERT_NE(cache, nullptr);
+
+  for (size_t offset = 0; offset < mem.bytes.size(); offset += 2) {
+    const struct riscv_insn *actual =
+      riscv_page_cache_lookup(cache, mem.base + offset);
+    ASSERT_NE(actual, nullptr);
+    struct riscv_insn expected;
+    memset(&expected, 0, sizeof(expected));
+    if (riscv_decode_buffer(mem.bytes.data() + offset,
+          mem.bytes.size() - offset, mem.base + offset, &expected, 1) == 0) {
+      // 32-bit instruction cut off by the end of guest memory
+      ASSERT_EQ(actual->length, 0) << offset;
+      continue;
+    }
+    ASSERT_EQ(actual->kind, expected.kind) << offset;
+    ASSERT_EQ(actual->type, expected.type) << offset;
+    ASSERT_EQ(actual->is_compressed, expected.is_compressed) << offset;
+    ASSERT_EQ(actual->length, expected.length) << offset;
+    ASSERT_EQ(actual->pc, expected.pc) << offset;
+    if (expected.kind != RVINSN_ILLEGAL) {
+      ASSERT_EQ(memcmp(&actual->r, &expected.r, sizeof(expected.r)), 0)
+        << offset;
+    }
+  }
+
+  struct riscv_page_cache_stats stats;
+  riscv_page_cache_stats(cache, &stats);
+  EXPECT_EQ(stats.misses, 3);
+  EXPECT_EQ(stats.hits, mem.bytes.size() / 2 - 3);
+  EXPECT_EQ(mem.fetches, 3);
+  riscv_page_cache_destroy(cache);
+}
+
+TEST(page_cache, instructions_may_cross_into_the_next_page) {
+  guest mem = random_guest(0x9a9f, 2);
+  uint64_t pc = mem.base + RISCV_PAGE_SIZE - 2;
+  mem.store32(pc, /* addi a5,s0,-200 */ 0xf3840793);
+  struct riscv_page_cache *cache = riscv_page_cache_create(1, NULL,
+      guest::fetch, &mem);
+  ASSERT_NE(cache, nullptr);
+
+  const struct riscv_insn *insn = riscv_page_cache_lookup(cache, pc);
+  ASSERT_NE(insn, nullptr);
+  EXPECT_EQ(insn->kind, RVINSN_ADDI);
+  EXPECT_EQ(insn->length, 4);
+  EXPECT_EQ(insn->pc, pc);
+  EXPECT_EQ(insn->i.imm, -200);
+
+  // A store to the next page changes the instruction
+  mem.store32(pc, /* add a5,a3,s8 */ 0x018687b3);
+  riscv_page_cache_invalidate(cache, pc + 2, 2);
+  insn = riscv_page_cache_lookup(cache, pc);
+  ASSERT_NE(insn, nullptr);
+  EXPECT_EQ(insn->kind, RVINSN_ADD);
+  riscv_page_cache_destroy(cache);
+}
+
+TEST(page_cache, invalidate_refetches_written_pages_only) {
+  guest mem = random_guest(0x9aa0, 4);
+  struct riscv_page_cache *cache = riscv_page_cache_create(4, NULL,
+      guest::fetch, &mem);
+  ASSERT_NE(cache, nullptr);
+  for (int page = 0; page < 4; ++page) {
+    riscv_page_cache_lookup(cache, mem.base + page * RISCV_PAGE_SIZE + 0x100);
+  }
+  EXPECT_EQ(mem.fetches, 4);
+
+  uint64_t pc = mem.base + 2 * RISCV_PAGE_SIZE + 0x40;
+  mem.store32(pc, /* jal ra,-0x72e */ 0x8cfff0ef);
+  riscv_page_cache_invalidate(cache, pc, 4);
+  for (int page = 0; page < 4; ++page) {
+    riscv_page_cache_lookup(cache, mem.base + page * RISCV_PAGE_SIZE + 0x100);
+  }
+  EXPECT_EQ(mem.fetches, 5);
+  EXPECT_EQ(riscv_page_cache_lookup(cache, pc)->kind, RVINSN_JAL);
+
+  // A range covering more pages than the cache holds
+  riscv_page_cache_invalidate(cache, 0, UINT64_MAX);
+  struct riscv_page_cache_stats stats;
+  riscv_page_cache_stats(cache, &stats);
+  EXPECT_EQ(stats.invalidations, 5);
+  riscv_page_cache_lookup(cache, pc);
+  EXPECT_EQ(mem.fetches, 6);
+  riscv_page_cache_destroy(cache);
+}
+
+TEST(page_cache, evicts_least_recently_used_page) {
+  guest mem = random_guest(0x9aa1, 3);
+  struct riscv_page_cache *cache = riscv_page_cache_create(2, NULL,
+      guest::fetch, &mem);
+  ASSERT_NE(cache, nullptr);
+  uint64_t a = mem.base, b = a + RISCV_PAGE_SIZE, c = b + RISCV_PAGE_SIZE;
+
+  riscv_page_cache_lookup(cache, a);
+  riscv_page_cache_lookup(cache, b);
+  riscv_page_cache_lookup(cache, a);
+  riscv_page_cache_lookup(cache, c); // evicts b
+  EXPECT_EQ(mem.fetches, 3);
+  riscv_page_cache_lookup(cache, a);
+  EXPECT_EQ(mem.fetches, 3);
+  riscv_page_cache_lookup(cache, b);
+  EXPECT_EQ(mem.fetches, 4);
+
+  struct riscv_page_cache_stats stats;
+  riscv_page_cache_stats(cache, &stats);
+  EXPECT_EQ(stats.misses, 4);
+  EXPECT_EQ(stats.hits, 2);
+  EXPECT_EQ(stats.evictions, 2);
+  riscv_page_cache_destroy(cache);
+}
+
+TEST(page_cache, rejects_unfetchable_and_odd_pcs) {
+  guest mem = random_guest(0x9aa2, 1);
+  EXPECT_EQ(riscv_page_cache_create(0, NULL, guest::fetch, &mem), nullptr);
+  struct riscv_page_cache *cache = riscv_page_cache_create(1, NULL,
+      guest::fetch, &mem);
+  ASSERT_NE(cache, nullptr);
+  EXPECT_EQ(riscv_page_cache_lookup(cache, mem.base + 1), nullptr);
+  EXPECT_EQ(riscv_page_cache_lookup(cache, 0x1000), nullptr);
+  EXPECT_NE(riscv_page_cache_lookup(cache, mem.base), nullptr);
+  // The failed fetch didn't take the page
+  EXPECT_EQ(riscv_page_cache_lookup(cache, 0x1000), nullptr);
+  EXPECT_NE(riscv_page_cache_lookup(cache, mem.base + 2), nullptr);
+  EXPECT_EQ(mem.fetches, 3);
+  riscv_page_cache_destroy(cache);
+}
+
+#if defined(SUPPORT_RV32I) && defined(SUPPORT_RV64I)
+TEST(page_cache, decodes_with_its_profile) {
+  guest mem = random_guest(0x9aa3, 1);
+  mem.store32(mem.base, /* ld a5,0(a5) */ 0x0007b783);
+  struct riscv_decoder rv32;
+  ASSERT_EQ(riscv_decoder_init(&rv32, 32, 0), 1);
+  struct riscv_page_cache *cache = riscv_page_cache_create(1, &rv32,
+      guest::fetch, &mem);
+  ASSERT_NE(cache, nullptr);
+  EXPECT_EQ(riscv_page_cache_lookup(cache, mem.base)->kind, RVINSN_ILLEGAL);
+  riscv_page_cache_destroy(cache);
+}
+#endif
+
+} // namespace page_cache
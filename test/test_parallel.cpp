@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#include "test_util.h"
+
+namespace parallel {
+
+static void expect_same_as_serial(const std::vector<uint8_t> &buf, size_t cap,
+    unsigned threads) {
+  std::vector<struct riscv_insn> expected(buf.size() / 2 + 1);
+  std::vector<struct riscv_insn> actual(buf.size() / 2 + 1);
+  size_t n = riscv_decode_buffer(buf.data(), buf.size(), 0x10000,
+      expected.data(), std::min(cap, expected.size()));
+  ASSERT_EQ(riscv_decode_buffer_parallel(buf.data(), buf.size(), 0x10000,
+        actual.data(), std::min(cap, actual.size()), threads), n)
+    << threads;
+  ASSERT_EQ(memcmp(actual.data(), expected.data(), n * sizeof(actual[0])), 0)
+    << threads;
+}
+
+TEST(parallel, matches_serial_decode) {
+  for (int long_percent : { 0, 30, 75, 99, 100 }) {
+    std::vector<uint8_t> buf = random_code(0x9a7 + long_percent, 1 << 20,
+        long_percent);
+    for (unsigned threads : { 0u, 1u, 2u, 3u, 7u, 16u }) {
+      expect_same_as_serial(buf, SIZE_MAX, threads);
+    }
+  }
+}
+
+TEST(parallel, matches_serial_decode_with_odd_length_and_capacity) {
+  std::vector<uint8_t> buf = random_code(0x9a8, (1 << 20) + 3, 50);
+  expect_same_as_serial(buf, SIZE_MAX, 4);
+  expect_same_as_serial(buf, 1000, 4);
+  expect_same_as_serial(buf, 300000, 4);
+  expect_same_as_serial(buf, 0, 4);
+}
+
+TEST(parallel, every_chunk_cut_straddles_an_instruction) {
+  // Only 32-bit instructions, starting at odd halfwords: every even offset
+  // a chunk could start at is in the middle of one
+  std::vector<uint8_t> buf(1 << 20);
+  buf[0] = 0x01;
+  for (size_t i = 2; i + 4 <= buf.size(); i += 4) {
+    uint32_t word = /* addi a5,s0,-200 */ 0xf3840793;
+    memcpy(&buf[i], &word, 4);
+  }
+  for (unsigned threads : { 2u, 4u, 5u, 8u }) {
+    expect_same_as_serial(buf, SIZE_MAX, threads);
+  }
+}
+
+#if defined(SUPPORT_RV32I) && defined(SUPPORT_RV32M)
+TEST(parallel, decoder_matches_its_serial_decode) {
+  struct riscv_decoder rv32;
+  ASSERT_EQ(riscv_decoder_init(&rv32, 32, RISCV_EXT_M), 1);
+  std::vector<uint8_t> buf = random_code(0x9a9, 1 << 20, 75);
+  std::vector<struct riscv_insn> expected(buf.size() / 2);
+  std::vector<struct riscv_insn> actual(buf.size() / 2);
+  size_t n = riscv_decoder_decode_buffer(&rv32, buf.data(), buf.size(), 0,
+      expected.data(), expected.size());
+  ASSERT_EQ(riscv_decoder_decode_buffer_parallel(&rv32, buf.data(),
+        buf.size(), 0, actual.data(), actual.size(), 4), n);
+  EXPECT_EQ(memcmp(actual.data(), expected.data(), n * sizeof(actual[0])), 0);
+}
+#endif
+
+} // namespace parallel
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+namespace regs {
+
+static struct riscv_reg_masks regs_of(uint32_t repr) {
+  struct riscv_insn insn;
+  memset(&insn, 0, sizeof(insn));
+  riscv_decode(&insn, repr);
+  struct riscv_reg_masks masks;
+  riscv_insn_regs(&insn, &masks);
+  return masks;
+}
+
+static constexpr uint64_t x(int reg) {
+  return (uint64_t)1 << reg;
+}
+
+TEST(regs, reads_sources_and_writes_destinations) {
+  // add a0,a1,a2
+  struct riscv_reg_masks m = regs_of(0x00c58533);
+  EXPECT_EQ(m.read, x(RVREG_a1) | x(RVREG_a2));
+  EXPECT_EQ(m.write, x(RVREG_a0));
+  // addi a5,s0,-200
+  m = regs_of(0xf3840793);
+  EXPECT_EQ(m.read, x(RVREG_s0));
+  EXPECT_EQ(m.write, x(RVREG_a5));
+  // lw a0,8(sp)
+  m = regs_of(0x00812503);
+  EXPECT_EQ(m.read, x(RVREG_sp));
+  EXPECT_EQ(m.write, x(RVREG_a0));
+  // jalr ra,0(a5)
+  m = regs_of(0x000780e7);
+  EXPECT_EQ(m.read, x(RVREG_a5));
+  EXPECT_EQ(m.write, x(RVREG_ra));
+}
+
+TEST(regs, stores_and_branches_write_nothing) {
+  // sw a0,8(sp)
+  struct riscv_reg_masks m = regs_of(0x00a12423);
+  EXPECT_EQ(m.read, x(RVREG_a0) | x(RVREG_sp));
+  EXPECT_EQ(m.write, 0u);
+  // beq a0,a1,8
+  m = regs_of(0x00b50463);
+  EXPECT_EQ(m.read, x(RVREG_a0) | x(RVREG_a1));
+  EXPECT_EQ(m.write, 0u);
+}
+
+TEST(regs, upper_and_jumps_read_nothing) {
+  // lui a5,0x12
+  struct riscv_reg_masks m = regs_of(0x000127b7);
+  EXPECT_EQ(m.read, 0u);
+  EXPECT_EQ(m.write, x(RVREG_a5));
+  // jal ra,16
+  m = regs_of(0x010000ef);
+  EXPECT_EQ(m.read, 0u);
+  EXPECT_EQ(m.write, x(RVREG_ra));
+}
+
+TEST(regs, system_and_fence_use_no_registers) {
+  for (uint32_t repr : { 0x00000073u, 0x00100073u, 0x0ff0000fu, 0x8330000fu }) {
+    struct riscv_reg_masks m = regs_of(repr);
+    EXPECT_EQ(m.read, 0u) << std::hex << repr;
+    EXPECT_EQ(m.write, 0u) << std::hex << repr;
+  }
+  struct riscv_reg_masks m = regs_of(0);
+  EXPECT_EQ(m.read, 0u);
+  EXPECT_EQ(m.write, 0u);
+}
+
+TEST(regs, drops_x0) {
+  // bne a0,zero,-4
+  struct riscv_reg_masks m = regs_of(0xfe051ee3);
+  EXPECT_EQ(m.read, x(RVREG_a0));
+  // jal zero,16
+  m = regs_of(0x0100006f);
+  EXPECT_EQ(m.write, 0u);
+}
+
+#ifdef SUPPORT_COMPRESSED
+TEST(regs, uses_the_expansion_of_compressed) {
+  // c.li a0,1 is addi a0,zero,1
+  struct riscv_reg_masks m = regs_of(0x4505u << 16);
+  EXPECT_EQ(m.read, 0u);
+  EXPECT_EQ(m.write, x(RVREG_a0));
+  // c.mv a0,a1 is add a0,zero,a1
+  m = regs_of(0x852eu << 16);
+  EXPECT_EQ(m.read, x(RVREG_a1));
+  EXPECT_EQ(m.write, x(RVREG_a0));
+}
+#endif
+
+TEST(regs, slots_follow_the_format) {
+  for (int kind = 0; kind < RVINSN_ILLEGAL; ++kind) {
+    const struct riscv_operand_slots *slots = &riscv_operand_slots[kind];
+    switch (riscv_encodings[kind].type) {
+      case INSN_R:
+        EXPECT_EQ(slots->reads, RISCV_SLOT_RS1 | RISCV_SLOT_RS2) << kind;
+        EXPECT_EQ(slots->writes, RISCV_SLOT_RD) << kind;
+        break;
+      case INSN_S:
+      case INSN_B:
+        EXPECT_EQ(slots->reads, RISCV_SLOT_RS1 | RISCV_SLOT_RS2) << kind;
+        EXPECT_EQ(slots->writes, 0) << kind;
+        break;
+      case INSN_U:
+      case INSN_J:
+        EXPECT_EQ(slots->reads, 0) << kind;
+        EXPECT_EQ(slots->writes, RISCV_SLOT_RD) << kind;
+        break;
+      case INSN_FENCE:
+        EXPECT_EQ(slots->reads, 0) << kind;
+        EXPECT_EQ(slots->writes, 0) << kind;
+        break;
+    }
+  }
+  EXPECT_EQ(riscv_operand_slots[RVINSN_ILLEGAL].reads, 0);
+  EXPECT_EQ(riscv_operand_slots[RVINSN_ILLEGAL].writes, 0);
+}
+
+TEST(regs, match_the_operands) {
+  std::mt19937 rng(0x5e6);
+  struct riscv_insn insn;
+  for (int i = 0; i < 200000; ++i) {
+    memset(&insn, 0, sizeof(insn));
+    if (riscv_decode(&insn, rng()) == RVINSN_ILLEGAL) {
+      continue;
+    }
+    struct riscv_operands ops;
+    riscv_insn_operands(&insn, &ops);
+    const struct riscv_operand_slots *slots = &riscv_operand_slots[insn.kind];
+    uint64_t read = 0, write = 0;
+    if (slots->reads & RISCV_SLOT_RS1) {
+      read |= x(ops.rs1);
+    }
+    if (slots->reads & RISCV_SLOT_RS2) {
+      read |= x(ops.rs2);
+    }
+    if (slots->writes & RISCV_SLOT_RD) {
+      write |= x(ops.rd);
+    }
+
+    struct riscv_reg_masks m;
+    riscv_insn_regs(&insn, &m);
+    ASSERT_EQ(m.read, read & ~x(0)) << insn.kind;
+    ASSERT_EQ(m.write, write & ~x(0)) << insn.kind;
+  }
+}
+
+} // namespace regs
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+namespace rvc_table {
+
+#ifdef SUPPORT_COMPRESSED
+
+// Reference implementation: the RVC hook chain `rvc_decode` used to walk
+// before the expanded tables were generated.
+
+typedef int (*hook16_fn)(struct riscv_insn *insn, uint32_t repr, uint32_t opcode);
+
+static const hook16_fn reference_hooks16[] = {
+#ifdef SUPPORT_RV64I
+  rvc_decode_ci_rv64, rvc_decode_css_rv64, rvc_decode_cl_rv64,
+  rvc_decode_cs_rv64, rvc_decode_ca_rv64, rvc_decode_cj_rv64,
+#endif
+  rvc_decode_cr_rv32, rvc_decode_ci_rv32, rvc_decode_css_rv32,
+  rvc_decode_ciw_rv32, rvc_decode_cl_rv32, rvc_decode_cs_rv32,
+  rvc_decode_ca_rv32, rvc_decode_cb_rv32, rvc_decode_cj_rv32,
+};
+
+static int reference_rvc_decode(struct riscv_insn *insn, uint32_t repr) {
+  if (repr != 0) {
+    for (hook16_fn hook : reference_hooks16) {
+      if (hook(insn, repr, repr & 0b11)) {
+        insn->is_compressed = true;
+        insn->length = 2;
+        return insn->kind;
+      }
+    }
+  }
+  insn->is_compressed = false;
+  return RVINSN_ILLEGAL;
+}
+
+TEST(rvc_table, matches_hooks_for_every_halfword) {
+  for (uint32_t repr = 0; repr < (1 << 16); ++repr) {
+    struct riscv_insn expected, actual;
+    memset(&expected, 0, sizeof(expected));
+    memset(&actual, 0, sizeof(actual));
+    int expected_kind = reference_rvc_decode(&expected, repr);
+    int actual_kind = rvc_decode(&actual, repr);
+    ASSERT_EQ(actual_kind, expected_kind) << std::hex << repr;
+    ASSERT_EQ(actual.is_compressed, expected.is_compressed) << std::hex << repr;
+    if (actual_kind != RVINSN_ILLEGAL) {
+      ASSERT_EQ(memcmp(&actual, &expected, sizeof(actual)), 0) << std::hex << repr;
+    }
+  }
+}
+
+#endif // SUPPORT_COMPRESSED
+
+} // namespace rvc_table
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+
+#include "riscv_scan.h"
+#include "test_util.h"
+
+namespace scan {
+
+// Reference: step through the buffer one instruction at a time
+static std::vector<uint64_t> scalar_walk(const std::vector<uint8_t> &buf) {
+  size_t halfwords = buf.size() / 2;
+  std::vector<uint64_t> starts((halfwords + 63) / 64, 0);
+  for (size_t i = 0; i < halfwords;) {
+    starts[i / 64] |= 1ull << (i % 64);
+    i += (buf[2 * i] & 0b11) == 0b11 ? 2 : 1;
+  }
+  return starts;
+}
+
+typedef size_t scan_fn(const uint8_t *buf, size_t len, uint64_t *starts);
+
+static void expect_same_as_scalar_walk(scan_fn *scan) {
+  uint32_t seed = 0xb0a7;
+  for (int long_percent : { 0, 10, 50, 90, 100 }) {
+    for (size_t len : { 0, 1, 2, 3, 64, 127, 128, 130, 256, 1000, 4097 }) {
+      for (int round = 0; round < 20; ++round) {
+        std::vector<uint8_t> buf = random_code(seed++, len, long_percent);
+        std::vector<uint64_t> expected = scalar_walk(buf);
+        std::vector<uint64_t> actual(expected.size() + 1, ~0ull);
+        EXPECT_EQ(scan(buf.data(), len, actual.data()), len / 2);
+        actual.resize(expected.size());
+        ASSERT_EQ(actual, expected) << "len " << len << " long% " << long_percent;
+      }
+    }
+  }
+}
+
+TEST(scan, matches_scalar_walk) {
+  expect_same_as_scalar_walk(riscv_scan_boundaries);
+}
+
+#ifdef RVDEC_SCAN_X86
+
+// riscv_scan_boundaries() only runs the SSE2 kernel where AVX2 is missing
+TEST(scan, sse2_kernel_matches_scalar_walk) {
+  expect_same_as_scalar_walk(riscv_scan_boundaries_sse2);
+}
+
+TEST(scan, avx2_kernel_matches_scalar_walk) {
+  if (!__builtin_cpu_supports("avx2")) {
+    GTEST_SKIP() << "no AVX2";
+  }
+  expect_same_as_scalar_walk(riscv_scan_boundaries_avx2);
+}
+
+#endif // RVDEC_SCAN_X86
+
+TEST(scan, matches_decode_buffer) {
+  std::vector<uint8_t> buf = random_code(0x5ca7, 4096, 60);
+  std::vector<uint64_t> starts(4096 / 128);
+  riscv_scan_boundaries(buf.data(), buf.size(), starts.data());
+
+  std::vector<struct riscv_insn> insns(buf.size() / 2);
+  size_t n = riscv_decode_buffer(buf.data(), buf.size(), 0, insns.data(), insns.size());
+  size_t i = 0;
+  for (size_t w = 0; w < starts.size(); ++w) {
+    for (uint64_t bits = starts[w]; bits != 0; bits &= bits - 1) {
+      uint64_t pc = 2 * (64 * w + __builtin_ctzll(bits));
+      if (i < n) {
+        ASSERT_EQ(insns[i].pc, pc);
+      } else {
+        // Only a truncated 32-bit instruction can be left over at the end
+        ASSERT_EQ(pc, buf.size() - 2);
+      }
+      ++i;
+    }
+  }
+  EXPECT_GE(i, n);
+}
+
+} // namespace scan
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/register.h>
+
+#include "test_util.h"
+
+namespace soa {
+
+struct soa_arrays {
+  std::vector<uint16_t> kind;
+  std::vector<uint8_t> rd, rs1, rs2;
+  std::vector<int32_t> imm;
+  std::vector<uint8_t> len;
+  struct riscv_insn_soa soa;
+
+  explicit soa_arrays(size_t cap)
+    : kind(cap), rd(cap), rs1(cap), rs2(cap), imm(cap), len(cap) {
+    soa = { kind.data(), rd.data(), rs1.data(), rs2.data(), imm.data(),
+      len.data() };
+  }
+};
+
+TEST(soa, operands_are_scaled_and_sign_extended) {
+  struct riscv_insn ins;
+  struct riscv_operands ops;
+
+  riscv_decode(&ins, /* 142c2: beq a5,a3,142b0 */ 0xfed787e3);
+  riscv_insn_operands(&ins, &ops);
+  EXPECT_EQ(ops.rs1, RVREG_a5);
+  EXPECT_EQ(ops.rs2, RVREG_a3);
+  EXPECT_EQ(ops.rd, 0);
+  EXPECT_EQ(ops.imm, 0x142b0 - 0x142c2);
+
+  riscv_decode(&ins, /* 19e24: jal ra,196f2 */ 0x8cfff0ef);
+  riscv_insn_operands(&ins, &ops);
+  EXPECT_EQ(ops.rd, RVREG_ra);
+  EXPECT_EQ(ops.imm, 0x196f2 - 0x19e24);
+
+  riscv_decode(&ins, /* lui a5,0xfffff */ 0xfffff7b7);
+  riscv_insn_operands(&ins, &ops);
+  EXPECT_EQ(ops.rd, RVREG_a5);
+  EXPECT_EQ(ops.imm, -4096);
+
+#ifdef SUPPORT_COMPRESSED
+  riscv_decode(&ins, /* 10170: j 100e8 */ 0xbfa51141);
+  riscv_insn_operands(&ins, &ops);
+  EXPECT_EQ(ops.imm, 0x100e8 - 0x10170);
+#endif
+}
+
+static void expect_same_as_aos(const std::vector<uint8_t> &buf) {
+  std::vector<struct riscv_insn> insns(buf.size() / 2);
+  size_t n = riscv_decode_buffer(buf.data(), buf.size(), 0, insns.data(),
+      insns.size());
+  soa_arrays arrays(insns.size());
+  ASSERT_EQ(riscv_decode_buffer_soa(buf.data(), buf.size(), &arrays.soa,
+        insns.size()), n);
+
+  for (size_t i = 0; i < n; ++i) {
+    struct riscv_operands ops;
+    riscv_insn_operands(&insns[i], &ops);
+    ASSERT_EQ(arrays.kind[i], insns[i].kind) << i;
+    ASSERT_EQ(arrays.len[i], insns[i].length) << i;
+    ASSERT_EQ(arrays.rd[i], ops.rd) << i;
+    ASSERT_EQ(arrays.rs1[i], ops.rs1) << i;
+    ASSERT_EQ(arrays.rs2[i], ops.rs2) << i;
+    ASSERT_EQ(arrays.imm[i], ops.imm) << i;
+  }
+}
+
+TEST(soa, matches_decode_buffer_for_random_bytes) {
+  std::vector<uint8_t> buf = random_code(0x50a, 1 << 16);
+  expect_same_as_aos(buf);
+}
+
+TEST(soa, matches_decode_buffer_for_every_opcode_funct3_funct7) {
+  std::mt19937 rng(0x50b);
+  std::vector<uint8_t> buf;
+  for (uint32_t opcode = 0b11; opcode < 128; opcode += 4) {
+    for (uint32_t funct3 = 0; funct3 < 8; ++funct3) {
+      for (uint32_t funct7 = 0; funct7 < 128; ++funct7) {
+        uint32_t repr = (funct7 << 25) | (funct3 << 12) | opcode
+          | (rng() & 0x01ff8f80);
+        for (int i = 0; i < 4; ++i) {
+          buf.push_back(repr >> (8 * i));
+        }
+      }
+    }
+  }
+  expect_same_as_aos(buf);
+}
+
+TEST(soa, respects_capacity_and_truncation) {
+  // addi a5,s0,-200 followed by the first half of another 32-bit instruction
+  static const uint8_t code[] = { 0x93, 0x07, 0x84, 0xf3, 0x93, 0x07 };
+  soa_arrays arrays(4);
+  ASSERT_EQ(riscv_decode_buffer_soa(code, sizeof(code), &arrays.soa, 4), 1);
+  EXPECT_EQ(arrays.kind[0], RVINSN_ADDI);
+  EXPECT_EQ(arrays.rd[0], RVREG_a5);
+  EXPECT_EQ(arrays.rs1[0], RVREG_s0);
+  EXPECT_EQ(arrays.imm[0], -200);
+  EXPECT_EQ(arrays.len[0], 4);
+
+  EXPECT_EQ(riscv_decode_buffer_soa(code, sizeof(code), &arrays.soa, 0), 0);
+}
+
+} // namespace soa
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/stats.h>
+
+#include "test_util.h"
+
+namespace stats {
+
+static struct riscv_decode_stats snapshot() {
+  struct riscv_decode_stats s;
+  riscv_decode_stats_snapshot(&s);
+  return s;
+}
+
+TEST(stats, merges_every_counter) {
+  struct riscv_decode_stats a, b;
+  memset(&a, 0, sizeof(a));
+  memset(&b, 0, sizeof(b));
+  a.decodes = 3;
+  a.kinds[RVINSN_ADD] = 2;
+  a.dispatch_failures[31][7] = 1;
+  b.decodes = 4;
+  b.kinds[RVINSN_ADD] = 5;
+  b.rvc_attempts[1][2] = 6;
+  b.rvc_fallbacks = 7;
+  riscv_decode_stats_merge(&a, &b);
+  EXPECT_EQ(a.decodes, 7);
+  EXPECT_EQ(a.kinds[RVINSN_ADD], 7);
+  EXPECT_EQ(a.dispatch_failures[31][7], 1);
+  EXPECT_EQ(a.rvc_attempts[1][2], 6);
+  EXPECT_EQ(a.rvc_fallbacks, 7);
+}
+
+#ifdef RVDEC_STATS
+
+static uint64_t sum(const uint64_t *counters, size_t n) {
+  uint64_t total = 0;
+  for (size_t i = 0; i < n; ++i) {
+    total += counters[i];
+  }
+  return total;
+}
+
+TEST(stats, counts_kinds_formats_and_dispatch) {
+  riscv_decode_stats_reset();
+  struct riscv_insn insn;
+  // add a0,a1,a2 twice, then beq a0,a1,8
+  riscv_decode(&insn, 0x00c58533);
+  riscv_decode(&insn, 0x00c58533);
+  riscv_decode(&insn, 0x00b50463);
+
+  struct riscv_decode_stats s = snapshot();
+  EXPECT_TRUE(riscv_decode_stats_enabled());
+  EXPECT_EQ(s.decodes, 3);
+  EXPECT_EQ(s.kinds[RVINSN_ADD], 2);
+  EXPECT_EQ(s.kinds[RVINSN_BEQ], 1);
+  EXPECT_EQ(s.formats[INSN_R], 2);
+  EXPECT_EQ(s.formats[INSN_B], 1);
+  EXPECT_EQ(s.illegal, 0);
+  EXPECT_EQ(s.dispatch_attempts[0b0110011 >> 2][0], 2);
+  EXPECT_EQ(s.dispatch_attempts[0b1100011 >> 2][0], 1);
+  EXPECT_EQ(sum(&s.dispatch_failures[0][0], 32 * 8), 0);
+  EXPECT_EQ(s.rvc_fallbacks, 0);
+}
+
+TEST(stats, counts_failed_attempts_and_illegal) {
+  riscv_decode_stats_reset();
+  struct riscv_insn insn;
+  // Opcode 0b1111111 with funct3 0b111 is unassigned
+  riscv_decode(&insn, 0xffffffff);
+
+  struct riscv_decode_stats s = snapshot();
+  EXPECT_EQ(s.decodes, 1);
+  EXPECT_EQ(s.illegal, 1);
+  EXPECT_EQ(s.kinds[RVINSN_ILLEGAL], 1);
+  EXPECT_EQ(s.formats[INSN_UNDEFINED], 1);
+  EXPECT_EQ(s.dispatch_attempts[31][7], 1);
+  EXPECT_EQ(s.dispatch_failures[31][7], 1);
+#ifdef SUPPORT_COMPRESSED
+  // The upper halfword has low bits 0b11 as well, so isn't compressed
+  EXPECT_EQ(s.rvc_fallbacks, 1);
+  EXPECT_EQ(s.rvc_attempts[3][7], 1);
+  EXPECT_EQ(s.rvc_failures[3][7], 1);
+#endif
+}
+
+#ifdef SUPPORT_COMPRESSED
+TEST(stats, counts_compressed_fallbacks) {
+  riscv_decode_stats_reset();
+  struct riscv_insn insn;
+  // c.li a0,1 in the upper halfword, then the illegal all-zero halfword
+  riscv_decode(&insn, 0x4505u << 16);
+  riscv_decode(&insn, 0);
+
+  struct riscv_decode_stats s = snapshot();
+  EXPECT_EQ(s.decodes, 2);
+  EXPECT_EQ(s.kinds[RVINSN_ADDI], 1);
+  EXPECT_EQ(s.illegal, 1);
+  EXPECT_EQ(s.rvc_fallbacks, 2);
+  EXPECT_EQ(s.rvc_attempts[0b01][0b010], 1);
+  EXPECT_EQ(s.rvc_failures[0b01][0b010], 0);
+  EXPECT_EQ(s.rvc_attempts[0b00][0b000], 1);
+  EXPECT_EQ(s.rvc_failures[0b00][0b000], 1);
+  // Neither word has low bits 0b11, so the dispatch table isn't consulted
+  EXPECT_EQ(sum(&s.dispatch_attempts[0][0], 32 * 8), 0);
+}
+#endif
+
+TEST(stats, counts_each_instruction_of_a_buffer_once) {
+  const uint8_t code[] = {
+    /* addi a5,s0,-200 */ 0x93, 0x07, 0x84, 0xf3,
+    /* c.li a0,1       */ 0x05, 0x45,
+    /* jal ra,0x10016  */ 0xef, 0x00, 0x00, 0x01,
+    /* unassigned      */ 0xff, 0xff, 0xff, 0xff,
+  };
+  struct riscv_insn insns[4];
+  riscv_decode_stats_reset();
+  ASSERT_EQ(riscv_decode_buffer(code, sizeof(code), 0, insns, 4), 4);
+
+  struct riscv_decode_stats s = snapshot();
+  EXPECT_EQ(s.decodes, 4);
+  EXPECT_EQ(s.kinds[RVINSN_ADDI], 1 + insns[1].is_compressed);
+  EXPECT_EQ(s.kinds[RVINSN_JAL], 1);
+  EXPECT_EQ(s.illegal, 1);
+  EXPECT_EQ(sum(&s.dispatch_attempts[0][0], 32 * 8), 3);
+  EXPECT_EQ(sum(&s.dispatch_failures[0][0], 32 * 8), 1);
+  EXPECT_EQ(sum(&s.rvc_attempts[0][0], 4 * 8), insns[1].is_compressed);
+  EXPECT_EQ(s.rvc_fallbacks, 0);
+}
+
+TEST(stats, keeps_counters_per_thread) {
+  riscv_decode_stats_reset();
+  struct riscv_decode_stats other;
+  std::thread t([&other] {
+    struct riscv_insn insn;
+    riscv_decode(&insn, 0x00c58533);
+    riscv_decode_stats_snapshot(&other);
+  });
+  t.join();
+  EXPECT_EQ(other.decodes, 1);
+  EXPECT_EQ(snapshot().decodes, 0);
+
+  struct riscv_insn insn;
+  riscv_decode(&insn, 0x00c58533);
+  struct riscv_decode_stats total = snapshot();
+  riscv_decode_stats_merge(&total, &other);
+  EXPECT_EQ(total.decodes, 2);
+  EXPECT_EQ(total.kinds[RVINSN_ADD], 2);
+}
+
+TEST(stats, collects_the_threads_of_parallel_decodes) {
+  std::vector<uint8_t> buf = random_code(0x57a7, 1 << 18);
+  std::vector<struct riscv_insn> out(buf.size() / 2);
+  riscv_decode_stats_reset();
+  size_t n = riscv_decode_buffer_parallel(buf.data(), buf.size(), 0,
+      out.data(), out.size(), 4);
+
+  struct riscv_decode_stats s = snapshot();
+  EXPECT_EQ(s.decodes, n);
+  size_t illegal = 0;
+  for (size_t i = 0; i < n; ++i) {
+    illegal += out[i].kind == RVINSN_ILLEGAL;
+  }
+  EXPECT_EQ(s.illegal, illegal);
+}
+
+#else
+
+TEST(stats, compiles_away) {
+  riscv_decode_stats_reset();
+  struct riscv_insn insn;
+  riscv_decode(&insn, 0x00c58533);
+
+  struct riscv_decode_stats s = snapshot();
+  EXPECT_FALSE(riscv_decode_stats_enabled());
+  EXPECT_EQ(s.decodes, 0);
+  EXPECT_EQ(s.kinds[RVINSN_ADD], 0);
+  EXPECT_EQ(s.dispatch_attempts[0b0110011 >> 2][0], 0);
+}
+
+#endif // RVDEC_STATS
+
+} // namespace stats
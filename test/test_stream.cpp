@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/stream.h>
+
+#include "test_util.h"
+
+namespace stream {
+
+struct collector {
+  std::vector<struct riscv_insn> insns;
+  std::vector<size_t> batches;
+};
+
+static void collect(void *ctx, const struct riscv_insn *insns, size_t count) {
+  collector *c = static_cast<collector *>(ctx);
+  c->insns.insert(c->insns.end(), insns, insns + count);
+  c->batches.push_back(count);
+}
+
+/* Illegal encodings leave the operand fields unset, so compare what the
+ * decoders define rather than bytes. */
+static void expect_same_insns(const std::vector<struct riscv_insn> &actual,
+    const struct riscv_insn *expected, size_t n) {
+  ASSERT_EQ(actual.size(), n);
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_EQ(actual[i].kind, expected[i].kind) << i;
+    ASSERT_EQ(actual[i].pc, expected[i].pc) << i;
+    ASSERT_EQ(actual[i].length, expected[i].length) << i;
+    if (expected[i].kind == RVINSN_ILLEGAL) {
+      continue;
+    }
+    struct riscv_operands a, e;
+    riscv_insn_operands(&actual[i], &a);
+    riscv_insn_operands(&expected[i], &e);
+    ASSERT_EQ(a.rd, e.rd) << i;
+    ASSERT_EQ(a.rs1, e.rs1) << i;
+    ASSERT_EQ(a.rs2, e.rs2) << i;
+    ASSERT_EQ(a.imm, e.imm) << i;
+  }
+}
+
+static void expect_same_as_buffer(const std::vector<uint8_t> &buf,
+    const collector &c, size_t held) {
+  std::vector<struct riscv_insn> expected(buf.size() / 2 + 1);
+  size_t n = riscv_decode_buffer(buf.data(), buf.size(), 0x8000,
+      expected.data(), expected.size());
+  expect_same_insns(c.insns, expected.data(), n);
+  size_t end = n > 0 ? expected[n - 1].pc + expected[n - 1].length - 0x8000 : 0;
+  EXPECT_EQ(held, buf.size() - end);
+}
+
+TEST(stream, matches_buffer_decode_for_any_chunking) {
+  std::vector<uint8_t> buf = random_code(0x57e, 1 << 16);
+  std::mt19937 rng(0x57f);
+  for (size_t max_chunk : { 1, 2, 3, 5, 64, 4096 }) {
+    collector c;
+    struct riscv_stream *s = riscv_stream_create(100, NULL, 0x8000, collect,
+        &c);
+    ASSERT_NE(s, nullptr);
+    size_t offset = 0;
+    while (offset < buf.size()) {
+      size_t len = std::min(buf.size() - offset, 1 + rng() % max_chunk);
+      riscv_stream_feed(s, buf.data() + offset, len);
+      offset += len;
+    }
+    // Nothing is emitted before a batch fills
+    for (size_t count : c.batches) {
+      EXPECT_EQ(count, 100);
+    }
+    size_t held = riscv_stream_flush(s);
+    expect_same_as_buffer(buf, c, held);
+    EXPECT_EQ(riscv_stream_pc(s), 0x8000 + buf.size() - held);
+    riscv_stream_destroy(s);
+  }
+}
+
+TEST(stream, carries_split_instruction) {
+  // addi a5,s0,-200 cut after its first halfword, then after one more byte
+  const uint8_t addi[] = { 0x93, 0x07, 0x84, 0xf3 };
+  collector c;
+  struct riscv_stream *s = riscv_stream_create(4, NULL, 0x100, collect, &c);
+  ASSERT_NE(s, nullptr);
+
+  riscv_stream_feed(s, addi, 2);
+  EXPECT_EQ(riscv_stream_flush(s), 2);
+  EXPECT_TRUE(c.insns.empty());
+  riscv_stream_feed(s, addi + 2, 1);
+  EXPECT_EQ(riscv_stream_flush(s), 3);
+  riscv_stream_feed(s, addi + 3, 1);
+  EXPECT_EQ(riscv_stream_flush(s), 0);
+
+  ASSERT_EQ(c.insns.size(), 1);
+  EXPECT_EQ(c.insns[0].kind, RVINSN_ADDI);
+  EXPECT_EQ(c.insns[0].pc, 0x100);
+  EXPECT_EQ(riscv_stream_pc(s), 0x104);
+
+  // An empty flush emits nothing
+  size_t batches = c.batches.size();
+  riscv_stream_flush(s);
+  EXPECT_EQ(c.batches.size(), batches);
+  riscv_stream_destroy(s);
+}
+
+TEST(stream, rejects_empty_batch) {
+  EXPECT_EQ(riscv_stream_create(0, NULL, 0, collect, nullptr), nullptr);
+}
+
+#if defined(SUPPORT_RV32I) && defined(SUPPORT_RV32M)
+TEST(stream, decodes_for_decoder_profile) {
+  struct riscv_decoder rv32;
+  ASSERT_EQ(riscv_decoder_init(&rv32, 32, RISCV_EXT_M), 1);
+  std::vector<uint8_t> buf = random_code(0x580, 1 << 14);
+  std::vector<struct riscv_insn> expected(buf.size() / 2);
+  size_t n = riscv_decoder_decode_buffer(&rv32, buf.data(), buf.size(), 0,
+      expected.data(), expected.size());
+
+  collector c;
+  struct riscv_stream *s = riscv_stream_create(7, &rv32, 0, collect, &c);
+  ASSERT_NE(s, nullptr);
+  for (size_t offset = 0; offset < buf.size(); offset += 333) {
+    riscv_stream_feed(s, buf.data() + offset,
+        std::min<size_t>(333, buf.size() - offset));
+  }
+  riscv_stream_flush(s);
+  expect_same_insns(c.insns, expected.data(), n);
+  riscv_stream_destroy(s);
+}
+#endif
+
+} // namespace stream
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "config.h"
+
+#include <rvdec/decode.h>
+#include <rvdec/instruction.h>
+#include <rvdec/trace.h>
+
+namespace trace {
+
+struct soa {
+  std::vector<uint64_t> pc;
+  std::vector<uint16_t> kind;
+  std::vector<uint8_t> rd, rs1, rs2, len;
+  std::vector<int32_t> imm;
+  struct riscv_insn_soa out;
+
+  explicit soa(size_t n)
+    : pc(n), kind(n), rd(n), rs1(n), rs2(n), len(n), imm(n),
+      out{ kind.data(), rd.data(), rs1.data(), rs2.data(), imm.data(),
+           len.data() } {}
+};
+
+/* Trace of `n` records of `record_size` bytes, drawing the instruction of
+ * each from a small pool of random words, half of them compressed, and
+ * filling the bytes past the fields with noise. */
+static std::vector<uint8_t> random_trace(uint32_t seed, size_t n,
+    size_t record_size, std::vector<uint32_t> &words) {
+  std::mt19937 rng(seed);
+  std::vector<uint32_t> pool(1000);
+  for (size_t i = 0; i < pool.size(); ++i) {
+    pool[i] = i % 2 ? rng() | 0b11 : (rng() & 0xffff & ~0b11) | (rng() % 3);
+  }
+  std::vector<uint8_t> buf(n * record_size);
+  words.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    uint8_t *record = &buf[i * record_size];
+    uint64_t pc = 0x80000000ull + 2 * (rng() % 0x10000);
+    uint32_t word = pool[rng() % pool.size()];
+    words[i] = word;
+    for (int b = 0; b < 8; ++b) {
+      record[b] = pc >> (8 * b);
+    }
+    for (int b = 0; b < 4; ++b) {
+      record[8 + b] = word >> (8 * b);
+    }
+    for (size_t b = 12; b < record_size; ++b) {
+      record[b] = rng();
+    }
+  }
+  return buf;
+}
+
+static void expect_record(const soa &s, size_t i, const uint8_t *record,
+    uint32_t word, const struct riscv_decoder *dec) {
+  uint64_t pc = 0;
+  memcpy(&pc, record, 8);
+  struct riscv_insn insn;
+  memset(&insn, 0, sizeof(insn));
+  const uint8_t *bytes = record + RISCV_TRACE_INSN_OFFSET;
+  if (dec) {
+    riscv_decoder_decode_buffer(dec, bytes, 4, 0, &insn, 1);
+  } else {
+    riscv_decode_buffer(bytes, 4, 0, &insn, 1);
+  }
+  struct riscv_operands ops;
+  riscv_insn_operands(&insn, &ops);
+
+  ASSERT_EQ(s.pc[i], pc) << i;
+  ASSERT_EQ(s.kind[i], insn.kind) << i << " " << std::hex << word;
+  ASSERT_EQ(s.rd[i], ops.rd) << i;
+  ASSERT_EQ(s.rs1[i], ops.rs1) << i;
+  ASSERT_EQ(s.rs2[i], ops.rs2) << i;
+  ASSERT_EQ(s.imm[i], ops.imm) << i;
+  ASSERT_EQ(s.len[i], (word & 0b11) == 0b11 ? 4 : 2) << i;
+}
+
+TEST(trace, matches_decode_per_record) {
+  for (size_t record_size : { 12, 16, 24 }) {
+    std::vector<uint32_t> words;
+    std::vector<uint8_t> buf = random_trace(0x7ace + record_size, 100000,
+        record_size, words);
+    struct riscv_trace t;
+    ASSERT_EQ(riscv_trace_init(&t, buf.data(), buf.size(), record_size), 1);
+    ASSERT_EQ(t.nrecords, 100000);
+    for (unsigned threads : { 1u, 4u }) {
+      soa s(t.nrecords);
+      ASSERT_EQ(riscv_trace_decode(&t, 0, t.nrecords, NULL, s.pc.data(),
+            &s.out, threads), t.nrecords);
+      for (size_t i = 0; i < t.nrecords; ++i) {
+        expect_record(s, i, &buf[i * record_size], words[i], NULL);
+      }
+    }
+    riscv_trace_close(&t);
+  }
+}
+
+TEST(trace, decodes_a_range_of_records) {
+  std::vector<uint32_t> words;
+  // A partial record at the end is ignored
+  std::vector<uint8_t> buf = random_trace(0x7acf, 1000, 16, words);
+  buf.resize(buf.size() + 7);
+  struct riscv_trace t;
+  ASSERT_EQ(riscv_trace_init(&t, buf.data(), buf.size(), 16), 1);
+  EXPECT_EQ(t.nrecords, 1000);
+
+  soa s(1000);
+  ASSERT_EQ(riscv_trace_decode(&t, 900, 500, NULL, s.pc.data(), &s.out, 2),
+      100);
+  for (size_t i = 0; i < 100; ++i) {
+    expect_record(s, i, &buf[(900 + i) * 16], words[900 + i], NULL);
+  }
+  EXPECT_EQ(riscv_trace_decode(&t, 1000, 1, NULL, s.pc.data(), &s.out, 1),
+      0);
+}
+
+TEST(trace, keeps_illegal_long_words) {
+  // Unassigned opcode 0x7f, with c.li a0,1 in the upper halfword
+  uint8_t record[16] = {};
+  uint32_t word = 0x4501007f;
+  memcpy(&record[RISCV_TRACE_INSN_OFFSET], &word, 4);
+  struct riscv_trace t;
+  ASSERT_EQ(riscv_trace_init(&t, record, sizeof(record), 16), 1);
+
+  soa s(1);
+  ASSERT_EQ(riscv_trace_decode(&t, 0, 1, NULL, s.pc.data(), &s.out, 1), 1);
+  EXPECT_EQ(s.kind[0], RVINSN_ILLEGAL);
+  EXPECT_EQ(s.len[0], 4);
+  expect_record(s, 0, record, word, NULL);
+}
+
+TEST(trace, rejects_short_records) {
+  struct riscv_trace t;
+  uint8_t buf[64] = {};
+  EXPECT_EQ(riscv_trace_init(&t, buf, sizeof(buf), 8), 0);
+  EXPECT_EQ(riscv_trace_open(&t, "/nonexistent/trace", 16), 0);
+}
+
+#if defined(SUPPORT_RV32I) && defined(SUPPORT_RV32M)
+TEST(trace, maps_file_and_decodes_for_profile) {
+  std::vector<uint32_t> words;
+  std::vector<uint8_t> buf = random_trace(0x7ad0, 50000, 16, words);
+  char path[] = "/tmp/rvdec_trace_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(write(fd, buf.data(), buf.size()), (ssize_t)buf.size());
+  close(fd);
+
+  struct riscv_trace t;
+  ASSERT_EQ(riscv_trace_open(&t, path, 16), 1);
+  unlink(path);
+  ASSERT_EQ(t.nrecords, 50000);
+
+  struct riscv_decoder rv32;
+  ASSERT_EQ(riscv_decoder_init(&rv32, 32, RISCV_EXT_M), 1);
+  soa s(t.nrecords);
+  ASSERT_EQ(riscv_trace_decode(&t, 0, t.nrecords, &rv32, s.pc.data(), &s.out,
+        3), t.nrecords);
+  for (size_t i = 0; i < t.nrecords; ++i) {
+    expect_record(s, i, &buf[i * 16], words[i], &rv32);
+  }
+  riscv_trace_close(&t);
+}
+#endif
+
+} // namespace trace
@@ -0,0 +1,29 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <random>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/* `len` bytes of code made of random halfwords from `seed`, `long_percent`%
+ * of which have low bits 0b11 and so start a 32-bit instruction. The other
+ * halfwords have any other low bits, so the default of 25 gives uniformly
+ * random bytes. */
+static inline std::vector<uint8_t> random_code(uint32_t seed, size_t len,
+    int long_percent = 25) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> buf(len);
+  for (size_t i = 0; i < len; i += 2) {
+    uint16_t half = rng();
+    half = rng() % 100 < (uint32_t)long_percent ? half | 0b11
+                                                 : (half & ~0b11) | (rng() % 3);
+    buf[i] = half;
+    if (i + 1 < len) {
+      buf[i + 1] = half >> 8;
+    }
+  }
+  return buf;
+}
+
+#endif // TEST_UTIL_H
@@ -0,0 +1,255 @@
+/* Command-line front end of <rvdec/corpus.h>: writes a reproducible stream
+ * of valid RISC-V instructions, in little-endian order, for benchmarks and
+ * fuzzers. */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include <rvdec/corpus.h>
+#include <rvdec/decode.h>
+#include <rvdec/elf.h>
+#include <rvdec/instruction.h>
+
+#define BATCH 4096
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+      "usage: %s [options] > corpus.bin\n"
+      "  -n COUNT    instructions to write (default 1048576)\n"
+      "  -s SEED     seed of the stream (default 0)\n"
+      "  -x XLEN     32 or 64 (default from config.h)\n"
+      "  -e EXTS     extensions beyond the base set, from \"mc\" (default \"mc\")\n"
+      "  -c PERCENT  share of compressible instructions written compressed\n"
+      "              (default 50)\n"
+      "  -u          draw immediates uniformly instead of mostly small\n"
+      "  -w FILE     kind weights, one \"KIND WEIGHT\" line each, such as\n"
+      "              \"addi 30\"; unlisted kinds get 0\n"
+      "  -H ELF      kind weights from the executable sections of ELF, and\n"
+      "              its XLEN and C extension\n"
+      "  -r FILE     register weights, one \"xN WEIGHT\" line each\n"
+      "  -o FILE     write to FILE instead of standard output\n",
+      argv0);
+}
+
+static int parse_uint(const char *arg, unsigned long long max,
+    unsigned long long *value) {
+  char *end;
+  errno = 0;
+  *value = strtoull(arg, &end, 0);
+  return errno == 0 && end != arg && *end == '\0' && *value <= max;
+}
+
+static int kind_of(const char *name) {
+  for (int kind = 0; kind < RVINSN_ILLEGAL; ++kind) {
+    if (strcasecmp(name, riscv_kind_names[kind]) == 0) {
+      return kind;
+    }
+  }
+  return -1;
+}
+
+/* Reads "NAME WEIGHT" lines into `weights`, skipping blank lines and `#`
+ * comments. `index_of` maps a name to its index or -1. */
+static int read_weights(const char *path, uint32_t *weights, int (*index_of)(const char *)) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return 0;
+  }
+  char line[256];
+  int lineno = 0;
+  int ok = 1;
+  while (ok && fgets(line, sizeof(line), f)) {
+    ++lineno;
+    char name[64];
+    unsigned long long weight;
+    char *hash = strchr(line, '#');
+    if (hash) {
+      *hash = '\0';
+    }
+    if (sscanf(line, " %63s", name) != 1) {
+      continue;
+    }
+    int index = index_of(name);
+    if (index < 0 || sscanf(line, " %*s %llu", &weight) != 1
+        || weight > UINT32_MAX) {
+      fprintf(stderr, "%s:%d: expected a name and a weight\n", path, lineno);
+      ok = 0;
+      break;
+    }
+    weights[index] = weight;
+  }
+  fclose(f);
+  return ok;
+}
+
+static int reg_of(const char *name) {
+  unsigned long long reg;
+  if ((name[0] != 'x' && name[0] != 'X') || !parse_uint(name + 1, 31, &reg)) {
+    return -1;
+  }
+  return reg;
+}
+
+static int histogram_elf(const char *path, uint32_t *weights,
+    struct riscv_corpus_config *config) {
+  struct riscv_elf elf;
+  if (!riscv_elf_open(&elf, path)) {
+    fprintf(stderr, "%s: not a RISC-V ELF file\n", path);
+    return 0;
+  }
+  struct riscv_decoder dec;
+  if (!riscv_elf_decoder_init(&elf, &dec, RISCV_EXT_M)) {
+    fprintf(stderr, "%s: profile not supported by this build\n", path);
+    riscv_elf_close(&elf);
+    return 0;
+  }
+  config->xlen = dec.xlen;
+  config->extensions = dec.extensions;
+
+  static struct riscv_insn insns[BATCH];
+  for (size_t s = 0; s < elf.nsections; ++s) {
+    const struct riscv_elf_span *span = &elf.sections[s];
+    size_t offset = 0;
+    size_t n;
+    while ((n = riscv_decoder_decode_buffer(&dec, span->data + offset,
+            span->size - offset, span->addr + offset, insns, BATCH)) != 0) {
+      riscv_corpus_histogram(insns, n, weights);
+      offset = insns[n - 1].pc + insns[n - 1].length - span->addr;
+    }
+  }
+  riscv_elf_close(&elf);
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  struct riscv_corpus_config config;
+  riscv_corpus_config_init(&config);
+  static uint32_t kind_weights[RVINSN_ILLEGAL];
+  static uint32_t reg_weights[32];
+  unsigned long long count = 1 << 20;
+  unsigned long long value;
+  const char *output = NULL;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:s:x:e:c:uw:H:r:o:")) != -1) {
+    switch (opt) {
+      case 'n':
+        if (!parse_uint(optarg, SIZE_MAX, &count)) {
+          usage(argv[0]);
+          return 2;
+        }
+        break;
+      case 's':
+        if (!parse_uint(optarg, UINT64_MAX, &value)) {
+          usage(argv[0]);
+          return 2;
+        }
+        config.seed = value;
+        break;
+      case 'x':
+        if (!parse_uint(optarg, 64, &value)) {
+          usage(argv[0]);
+          return 2;
+        }
+        config.xlen = value;
+        break;
+      case 'e':
+        config.extensions = 0;
+        for (const char *p = optarg; *p; ++p) {
+          if (*p == 'm' || *p == 'M') {
+            config.extensions |= RISCV_EXT_M;
+          } else if (*p == 'c' || *p == 'C') {
+            config.extensions |= RISCV_EXT_C;
+          } else {
+            usage(argv[0]);
+            return 2;
+          }
+        }
+        break;
+      case 'c':
+        if (!parse_uint(optarg, 100, &value)) {
+          usage(argv[0]);
+          return 2;
+        }
+        config.rvc_percent = value;
+        break;
+      case 'u':
+        config.imm_model = RISCV_IMM_UNIFORM;
+        break;
+      case 'w':
+        if (!read_weights(optarg, kind_weights, kind_of)) {
+          return 1;
+        }
+        config.kind_weights = kind_weights;
+        break;
+      case 'H':
+        if (!histogram_elf(optarg, kind_weights, &config)) {
+          return 1;
+        }
+        config.kind_weights = kind_weights;
+        break;
+      case 'r':
+        if (!read_weights(optarg, reg_weights, reg_of)) {
+          return 1;
+        }
+        config.reg_weights = reg_weights;
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  struct riscv_corpus *corpus = riscv_corpus_create(&config);
+  if (!corpus) {
+    fprintf(stderr, "%s: unsupported profile or no kind with weight\n", argv[0]);
+    return 1;
+  }
+  FILE *out = output ? fopen(output, "wb") : stdout;
+  if (!out) {
+    perror(output);
+    riscv_corpus_destroy(corpus);
+    return 1;
+  }
+
+  static uint8_t buf[4 * BATCH];
+  while (count > 0) {
+    size_t n = count < BATCH ? count : BATCH;
+    size_t len = 0;
+    for (size_t i = 0; i < n; ++i) {
+      uint32_t word;
+      unsigned length = riscv_corpus_next(corpus, &word, NULL);
+      for (unsigned b = 0; b < length; ++b) {
+        buf[len++] = word >> (8 * b);
+      }
+    }
+    if (fwrite(buf, 1, len, out) != len) {
+      perror(output ? output : "stdout");
+      break;
+    }
+    count -= n;
+  }
+  riscv_corpus_destroy(corpus);
+
+  int failed = count != 0;
+  if (out != stdout) {
+    failed |= fclose(out) != 0;
+  } else {
+    failed |= fflush(out) != 0;
+  }
+  return failed;
+}